@@ -0,0 +1,352 @@
+#include "Editor/Editor.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <pty.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <fmt/core.h>
+
+namespace
+{
+    /// Number of blocks allocated with malloc since program start, operator new's included
+    std::atomic<std::size_t> g_allocations {0};
+}
+
+// glibc's own malloc, which the one below stands in front of
+extern "C" void* __libc_malloc(std::size_t size) noexcept;
+
+/**
+ * @brief Count every allocation, then leave it to glibc
+ *
+ * Interposing malloc rather than replacing operator new counts plain, array and nothrow new alike, as well as the
+ * allocations made by the C library, without having to pair every form of new with its delete.
+*/
+extern "C" void* malloc(std::size_t size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+namespace
+{
+    constexpr unsigned short ScreenRows = 24;
+    constexpr unsigned short ScreenCols = 80;
+    constexpr int FileLines = 1'000'000;
+
+    /// \brief A pseudo-terminal standing in for the user's tty
+    /// \details The editor only ever talks to STDIN_FILENO and STDOUT_FILENO, so the slave end of the pty is swapped
+    /// \details in for both while a benchmark runs. Scripted keys are written to the master end, and everything the
+    /// \details editor paints is drained from the master end by a background thread so that a full pty buffer never
+    /// \details blocks the frame being measured.
+    class VirtualTerminal
+    {
+    public:
+        static VirtualTerminal& instance()
+        {
+            static VirtualTerminal terminal {};
+            return terminal;
+        }
+
+        ~VirtualTerminal()
+        {
+            m_stop.store(true);
+            m_drainer.join();
+
+            ::close(m_master);
+            ::close(m_slave);
+        }
+
+        VirtualTerminal(VirtualTerminal const&) = delete;
+        VirtualTerminal& operator=(VirtualTerminal const&) = delete;
+
+        /// \brief Route the process' stdin and stdout through the pty
+        void attach()
+        {
+            if (::dup2(m_slave, STDIN_FILENO) == -1 or ::dup2(m_slave, STDOUT_FILENO) == -1) {
+                throw std::system_error(errno, std::generic_category(), "Could not attach the pseudo-terminal ");
+            }
+        }
+
+        /// \brief Give the process back the stdin and stdout it was started with
+        void detach()
+        {
+            ::dup2(m_savedStdin, STDIN_FILENO);
+            ::dup2(m_savedStdout, STDOUT_FILENO);
+        }
+
+        /// \brief Type a sequence of keys into the editor
+        void feed(std::string_view keys)
+        {
+            if (::write(m_master, keys.data(), keys.size()) != static_cast<long>(keys.size())) {
+                throw std::system_error(errno, std::generic_category(), "Could not feed keys to the pseudo-terminal ");
+            }
+        }
+
+        /// \returns The total number of bytes the editor has written to the pty
+        [[nodiscard]]
+        std::size_t bytesWritten() const noexcept
+        {
+            return m_bytes.load();
+        }
+
+    private:
+        int m_master {-1};
+        int m_slave {-1};
+        int m_savedStdin {::dup(STDIN_FILENO)};
+        int m_savedStdout {::dup(STDOUT_FILENO)};
+        std::atomic<bool> m_stop {false};
+        std::atomic<std::size_t> m_bytes {0};
+        std::thread m_drainer;
+
+        VirtualTerminal()
+        {
+            ::winsize size {};
+            size.ws_row = ScreenRows;
+            size.ws_col = ScreenCols;
+
+            if (::openpty(&m_master, &m_slave, nullptr, nullptr, &size) == -1) {
+                throw std::system_error(errno, std::generic_category(), "Could not open a pseudo-terminal ");
+            }
+
+            m_drainer = std::thread { [this] { drain(); } };
+        }
+
+        void drain() noexcept
+        {
+            std::array<char, 1 << 16> sink;
+            pollfd pfd { m_master, POLLIN, 0 };
+
+            while (not m_stop.load()) {
+                if (::poll(&pfd, 1, 10) > 0) {
+                    if (auto const rv = ::read(m_master, sink.data(), sink.size()); rv > 0) {
+                        m_bytes.fetch_add(static_cast<std::size_t>(rv));
+                    }
+                }
+            }
+        }
+    };
+
+    /// \brief Keeps the pty attached for the lifetime of a benchmark
+    struct Attached
+    {
+        Attached() { VirtualTerminal::instance().attach(); }
+        ~Attached() { VirtualTerminal::instance().detach(); }
+    };
+
+    /// \returns The number of read and write system calls made so far by the calling thread
+    /// \details Only the benchmark thread is counted, so the pty drainer doesn't skew the figures
+    [[nodiscard]]
+    std::size_t syscallCount()
+    {
+        std::ifstream io { "/proc/thread-self/io" };
+        std::string field;
+        std::size_t value {};
+        std::size_t total {};
+
+        while (io >> field >> value) {
+            if (field == "syscr:" or field == "syscw:") {
+                total += value;
+            }
+        }
+
+        return total;
+    }
+
+    /// \brief Generate a 1M-line file of varying line lengths, including lines wider than the screen
+    std::filesystem::path const& largeFile()
+    {
+        static std::filesystem::path const path = [] {
+            auto file = std::filesystem::temp_directory_path() / "kilo-render-bench.txt";
+            std::ofstream out { file };
+
+            for (int line = 0; line < FileLines; ++line) {
+                out << fmt::format("{:>7}: ", line) << std::string(static_cast<std::size_t>(line % 120), 'x') << '\n';
+            }
+
+            return file;
+        }();
+
+        return path;
+    }
+
+    /// \brief The editor under test, with the large file opened in it
+    Editor& editor()
+    {
+        static Editor& editor = [] () -> Editor& {
+            VirtualTerminal::instance();
+            Attached attached;
+
+            Editor& instance = Editor::instance();
+            instance.open(largeFile());
+
+            // Only the first screen is read by open; with no keys pressed, this reads the rest
+            [[maybe_unused]] auto const keyPressed = instance.waitForInput();
+            return instance;
+        }();
+
+        return editor;
+    }
+
+    /// \brief Frame-level counters reported alongside the time per frame
+    class FrameCounters
+    {
+    public:
+        explicit FrameCounters(std::size_t feedsPerFrame) noexcept : m_feedsPerFrame(feedsPerFrame) {}
+
+        void report(benchmark::State& state) const
+        {
+            auto const frames = static_cast<double>(state.iterations());
+            auto const syscalls = syscallCount() - m_syscalls - m_feedsPerFrame * state.iterations();
+
+            state.counters["bytes/frame"] = static_cast<double>(VirtualTerminal::instance().bytesWritten() - m_bytes) / frames;
+            state.counters["syscalls/frame"] = static_cast<double>(syscalls) / frames;
+            state.counters["allocs/frame"] = static_cast<double>(g_allocations.load() - m_allocations) / frames;
+        }
+
+    private:
+        std::size_t m_feedsPerFrame;
+        std::size_t m_bytes { VirtualTerminal::instance().bytesWritten() };
+        std::size_t m_allocations { g_allocations.load() };
+        std::size_t m_syscalls { syscallCount() };
+    };
+
+    /// \brief Replay one key sequence per frame: read and dispatch it, then repaint the screen
+    void replay(benchmark::State& state, std::string_view keys)
+    {
+        auto& kilo = editor();
+        Attached attached;
+
+        FrameCounters counters { 1 };
+
+        for (auto _ : state) {
+            VirtualTerminal::instance().feed(keys);
+            kilo.processKeypress();
+            kilo.refreshScreen();
+        }
+
+        // Give the drainer a moment to collect the output of the final frames
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        counters.report(state);
+    }
+}
+
+/// Repaint an unchanged screen
+static void BM_RefreshScreen(benchmark::State& state)
+{
+    auto& kilo = editor();
+    Attached attached;
+
+    FrameCounters counters { 0 };
+
+    for (auto _ : state) {
+        kilo.refreshScreen();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    counters.report(state);
+}
+BENCHMARK(BM_RefreshScreen);
+
+/// Scroll the 1M-line file one line at a time
+static void BM_ScrollDown(benchmark::State& state)
+{
+    replay(state, "\x1b[B");
+}
+BENCHMARK(BM_ScrollDown);
+
+static void BM_ScrollUp(benchmark::State& state)
+{
+    replay(state, "\x1b[A");
+}
+BENCHMARK(BM_ScrollUp);
+
+/// Page through the 1M-line file a screen at a time
+static void BM_PageDown(benchmark::State& state)
+{
+    replay(state, "\x1b[6~");
+}
+BENCHMARK(BM_PageDown);
+
+static void BM_PageUp(benchmark::State& state)
+{
+    replay(state, "\x1b[5~");
+}
+BENCHMARK(BM_PageUp);
+
+/// Sweep the cursor across a line that is wider than the screen
+static void BM_ScrollRight(benchmark::State& state)
+{
+    replay(state, "\x1b[C");
+}
+BENCHMARK(BM_ScrollRight);
+
+/// Type at 10k cursors at once, one on each of 10k rows; each keystroke is a single splice of the buffer
+static void BM_TypeAtManyCursors(benchmark::State& state)
+{
+    constexpr int Cursors = 10'000;
+
+    auto& kilo = editor();
+    auto& terminal = VirtualTerminal::instance();
+    Attached attached;
+
+    auto const press = [&](std::string_view keys) {
+        terminal.feed(keys);
+        kilo.processKeypress();
+    };
+
+    // CTRL-N adds a cursor on the row below the last one added
+    for (int i = 1; i < Cursors; ++i) {
+        press("\x0e");
+    }
+
+    press("i");
+
+    FrameCounters counters { 1 };
+
+    for (auto _ : state) {
+        terminal.feed("x");
+        kilo.processKeypress();
+        kilo.refreshScreen();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    counters.report(state);
+
+    // Back to normal mode with a single cursor
+    press("\x1b");
+    press("\x1b");
+}
+BENCHMARK(BM_TypeAtManyCursors);
+
+int main(int argc, char** argv)
+{
+    // Every run starts from the top of the file, rather than wherever the previous run left off
+    ::setenv("KILO_SESSION_DIR", "", 1);
+
+    benchmark::Initialize(&argc, argv);
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    // The editor restores the terminal it was started on when it is destroyed at exit, which is the pty
+    VirtualTerminal::instance().attach();
+
+    return EXIT_SUCCESS;
+}
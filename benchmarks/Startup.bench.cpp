@@ -0,0 +1,165 @@
+#include "Buffer/Buffer.hpp"
+#include "Session/Session.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <pty.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fmt/core.h>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr unsigned short ScreenRows = 24;
+    constexpr unsigned short ScreenCols = 80;
+
+    /// The escape sequence the editor ends every frame with, by showing the cursor again
+    constexpr std::string_view EndOfFrame { "\x1b[?25h" };
+
+    /// \brief Generate a file of @p lines lines of varying lengths, once per size
+    std::filesystem::path makeFile(int lines)
+    {
+        auto path = std::filesystem::temp_directory_path() / fmt::format("kilo-startup-bench-{}.txt", lines);
+
+        if (not std::filesystem::exists(path)) {
+            std::ofstream out { path };
+
+            for (int line = 0; line < lines; ++line) {
+                out << fmt::format("{:>7}: ", line) << std::string(static_cast<std::size_t>(line % 120), 'x') << '\n';
+            }
+        }
+
+        return path;
+    }
+
+    /// \brief Start the editor on a fresh pseudo-terminal and wait for its first frame
+    /// \returns The time from fork and exec to the end of the first frame arriving at the terminal
+    Clock::duration timeToFirstFrame(std::filesystem::path const& path)
+    {
+        ::winsize size {};
+        size.ws_row = ScreenRows;
+        size.ws_col = ScreenCols;
+
+        int master = -1;
+        auto const start = Clock::now();
+        auto const pid = ::forkpty(&master, nullptr, nullptr, &size);
+
+        if (pid == -1) {
+            throw std::system_error(errno, std::generic_category(), "Could not start the editor ");
+        }
+        else if (pid == 0) {
+            ::execl(KILO_BINARY, KILO_BINARY, path.c_str(), nullptr);
+            ::_exit(127);
+        }
+
+        std::string output;
+        std::array<char, 1 << 16> chunk;
+        pollfd pfd { master, POLLIN, 0 };
+
+        while (output.find(EndOfFrame) == std::string::npos) {
+            auto const rv = ::poll(&pfd, 1, 10'000) > 0 ? ::read(master, chunk.data(), chunk.size()) : -1;
+
+            if (rv <= 0) {
+                break;
+            }
+
+            output.append(chunk.data(), static_cast<std::size_t>(rv));
+        }
+
+        auto const elapsed = Clock::now() - start;
+
+        ::kill(pid, SIGKILL);
+        ::waitpid(pid, nullptr, 0);
+        ::close(master);
+
+        if (output.find(EndOfFrame) == std::string::npos) {
+            throw std::runtime_error("The editor exited without painting a frame");
+        }
+
+        return elapsed;
+    }
+
+    /// \brief Save a session for @p path, as if the editor had last been closed at row @p row
+    /// \details Sessions are kept in a directory of their own, which the editor is pointed at through the environment
+    void saveSession(std::filesystem::path const& path, int row)
+    {
+        auto const directory = std::filesystem::temp_directory_path() / "kilo-startup-bench-sessions";
+        ::setenv("KILO_SESSION_DIR", directory.c_str(), 1);
+
+        Buffer buffer;
+        buffer.open(path);
+
+        Session const session { FileStamp::of(path), { 0, row }, { row, 0 }, Session::indexOf(buffer) };
+        session.save(*Session::sidecarFor(path));
+    }
+
+    void startup(benchmark::State& state, std::filesystem::path const& path)
+    {
+        for (auto _ : state) {
+            state.SetIterationTime(std::chrono::duration<double>(timeToFirstFrame(path)).count());
+        }
+
+        state.counters["bytes"] = static_cast<double>(std::filesystem::file_size(path));
+    }
+}
+
+/// Start the editor on a file that fits on one screen
+static void BM_StartupSmallFile(benchmark::State& state)
+{
+    static auto const path = makeFile(10);
+    startup(state, path);
+}
+BENCHMARK(BM_StartupSmallFile)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+/// Start the editor on a 1M-line file; only its first screen should be read before the first frame
+static void BM_StartupHugeFile(benchmark::State& state)
+{
+    static auto const path = makeFile(1'000'000);
+    startup(state, path);
+}
+BENCHMARK(BM_StartupHugeFile)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+/// Reopen the 1M-line file where an earlier session left off, near its end
+static void BM_StartupHugeFileResumed(benchmark::State& state)
+{
+    static auto const path = makeFile(1'000'000);
+    saveSession(path, 900'000);
+
+    startup(state, path);
+
+    ::setenv("KILO_SESSION_DIR", "", 1);
+}
+BENCHMARK(BM_StartupHugeFileResumed)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv)
+{
+    // Sessions left behind by interactive use would change where the editor starts
+    ::setenv("KILO_SESSION_DIR", "", 1);
+
+    benchmark::Initialize(&argc, argv);
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include "Buffer/Buffer.hpp"
+
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A batch-editing script, applied to a buffer without a terminal
+ *
+ * A script holds one command per line; blank lines and lines starting with '#' are ignored.
+ * Counts default to 1, lines and columns are counted from 1, and "\n", "\t" and "\\" are unescaped in text.
+ *
+ *     goto <line> [<column>]   move to a position; <line> may be $ for the last line
+ *     up|down|left|right [<n>] move the cursor
+ *     home | end               move to the start or end of the row
+ *     insert <text>            insert the rest of the line at the cursor
+ *     newline [<n>]            split the row at the cursor
+ *     delete [<n>]             delete characters under the cursor
+ *     backspace [<n>]          delete characters before the cursor
+ *     deleteline [<n>]         delete whole rows
+ *     replace /<from>/<to>/    replace every occurrence of <from>; any character may be used as the delimiter
+ */
+class Script
+{
+public:
+    /// \brief Parse a script
+    /// \throws std::invalid_argument If a line of the script is not a valid command; the message names the line
+    [[nodiscard]]
+    static Script parse(std::istream& in);
+
+    /// \brief Run every command of the script against @p buffer, starting with the cursor at the top
+    void apply(Buffer& buffer) const;
+
+private:
+    enum class Op { Goto, Up, Down, Left, Right, Home, End, Insert, Newline, Delete, Backspace, DeleteLine, Replace };
+
+    struct Instruction
+    {
+        Op op;
+        int count {1};
+        Position at {};
+        std::string text {};
+        std::string replacement {};
+    };
+
+    std::vector<Instruction> m_instructions;
+};
+
+/// \brief Apply the script at @p script to each of @p files, rewriting them in place
+/// \details A file named "-", or no files at all, reads from stdin and writes the result to stdout
+/// \returns EXIT_SUCCESS if every file was edited, EXIT_FAILURE otherwise
+int runBatch(std::filesystem::path const& script, std::vector<std::filesystem::path> const& files);
+
+#endif
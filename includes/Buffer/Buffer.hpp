@@ -0,0 +1,247 @@
+#ifndef BUFFER_HPP
+#define BUFFER_HPP
+
+#include "Vec2/Vec2.hpp"
+#include "Compressed/Compressed.hpp"
+#include "LineIndex/LineIndex.hpp"
+#include "TextFormat/TextFormat.hpp"
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// \brief A position in a Buffer; x is the column and y is the row, both counted from 0
+using Position = Vector2<int>;
+
+/// \brief The text being edited, held as rows of UTF-8 without their line terminators
+/// \details The buffer knows nothing about terminals or screens, so it can be driven by the interactive editor or
+/// \details by a batch script alike. Row y == size() is the (empty) row just past the end of the text, and inserting
+/// \details there appends to the buffer.
+/// \details Every edit is recorded for undo. The edits made between two checkpoints are undone and redone together.
+/// \details A file can be opened lazily: only its first rows are read up front, and the rest is read in chunks by
+/// \details loadMore, e.g. while the editor waits for input. An edit made while the file is loading finishes loading
+/// \details first, since the rows past the end of what has been read can't be edited.
+/// \details A gzip or zstd file is decompressed as it is read, and compressed again when it is saved. Likewise,
+/// \details the line endings and byte order mark of a file are detected as it is read and written back as they were.
+/// \details A file that turns out not to be valid UTF-8 is taken to be Latin-1, which every sequence of bytes is.
+class Buffer
+{
+public:
+    /// \brief How much of a file loadMore reads by default
+    static constexpr std::size_t LoadChunk = 1 << 20;
+
+    Buffer() = default;
+
+    /// \brief Replace the contents of the buffer with the text read from @p in
+    void load(std::istream& in);
+
+    /// \brief Replace the contents of the buffer with those of the file at @p path
+    /// \throws std::system_error If the file cannot be opened
+    void open(std::filesystem::path const& path);
+
+    /// \brief Replace the contents of the buffer with those of the file at @p path, but only read its first @p rows
+    /// \details The rest is read by loadMore or loadAll, or by the first edit
+    /// \throws std::system_error If the file cannot be opened
+    void open(std::filesystem::path const& path, int rows);
+
+    /// \brief Replace the contents of the buffer with those of the file at @p path, but only read @p rows rows from
+    /// \brief row @p from on
+    /// \details @p index must hold the rows of the file. The rest is read by loadMore or loadAll, or by the first edit.
+    /// \details A compressed file is read with @p seekIndex, its complete seek index if it is known, so that row
+    /// \details @p from is reached without decompressing the text before it.
+    /// \throws std::system_error If the file cannot be opened
+    void open(std::filesystem::path const& path, LineIndex const& index, int from, int rows,
+        std::shared_ptr<SeekIndex> seekIndex = nullptr);
+
+    /// \brief Read up to @p bytes more of the file being loaded
+    /// \returns Whether there is more left to read
+    /// \throws std::system_error If the file cannot be read, e.g. because it is corrupt; the rows read so far are kept
+    bool loadMore(std::size_t bytes = LoadChunk);
+
+    /// \brief Read the rest of the file being loaded
+    void loadAll();
+
+    /// \returns Whether the file opened has not been read in full yet
+    [[nodiscard]]
+    bool loading() const noexcept;
+
+    /// \returns The seek index of the compressed file opened, once it has been read to its end, or nullptr; saving
+    /// \returns the file drops it, since it no longer describes the file
+    [[nodiscard]]
+    std::shared_ptr<SeekIndex> seekIndex() const noexcept;
+
+    /// \brief Write the contents of the buffer to @p out, in the format it was read in; only the rows loaded so far
+    /// \brief are written
+    /// \throws std::system_error If the text has characters the encoding can't hold
+    void save(std::ostream& out) const;
+
+    /// \brief Write the contents of the buffer to the file at @p path
+    /// \details The text is written to a temporary file which then replaces @p path, so a failed save never leaves
+    /// \details a truncated file behind. The file keeps its owner and mode, and a symbolic link is saved through.
+    /// \throws std::system_error If the file cannot be written
+    void save(std::filesystem::path const& path);
+
+    /// \returns The number of rows of text
+    [[nodiscard]]
+    int size() const noexcept;
+
+    /// \returns The text of row @p y, or an empty row if @p y is past the end of the buffer
+    [[nodiscard]]
+    std::string_view row(int y) const noexcept;
+
+    /// \returns The length of row @p y, or 0 if @p y is past the end of the buffer
+    [[nodiscard]]
+    int rowLength(int y) const noexcept;
+
+    /// \returns How many bytes row @p y takes up in the file, line terminator included
+    [[nodiscard]]
+    std::uint64_t rowBytes(int y) const noexcept;
+
+    /// \returns The format of the file opened, which it is saved in
+    [[nodiscard]]
+    TextFormat const& format() const noexcept { return m_format; }
+
+    /// \returns The text in [@p from, @p to), with a '\n' between rows
+    [[nodiscard]]
+    std::string text(Position from, Position to) const;
+
+    /// \brief Insert @p text at @p at; every '\n' in @p text starts a new row
+    /// \returns The position just after the inserted text
+    Position insert(Position at, std::string_view text);
+
+    /// \brief Erase the text in [@p from, @p to), joining rows if the range spans more than one
+    void erase(Position from, Position to);
+
+    /// \brief Erase @p count whole rows starting at row @p y
+    void eraseRows(int y, int count);
+
+    /// \brief A replacement of the text in [from, to) with @p text
+    struct Splice
+    {
+        Position from;
+        Position to;
+        std::string text;
+    };
+
+    /// \brief Make every replacement in @p splices as a single edit
+    /// \details The splices must be in order and must not overlap, though they may touch. They are applied in one pass
+    /// \details over the rows they span, however many there are, and undone and redone together.
+    /// \returns Where the text of each splice ends once they have all been made
+    std::vector<Position> splice(std::vector<Splice> splices);
+
+    /// \returns Whether the text ends with a line terminator, i.e. whether the last row is a complete line
+    [[nodiscard]]
+    bool endsWithNewline() const noexcept { return m_endsWithNewline; }
+
+    /// \returns Whether the buffer has been changed since it was last loaded or saved
+    [[nodiscard]]
+    bool dirty() const noexcept;
+
+    /// \returns How many edits have been made to the text, undos and redos included; loading more of the file is not
+    /// \returns an edit, so comparing two counts tells whether anything was edited in between
+    [[nodiscard]]
+    std::uint64_t edits() const noexcept { return m_edits; }
+
+    /// \brief Start a new undo entry; the edits made until the next checkpoint are undone together
+    void checkpoint() noexcept;
+
+    /// \brief Revert the edits of the most recent undo entry
+    /// \returns Where the reverted edits began, or nothing if there was nothing to undo
+    std::optional<Position> undo();
+
+    /// \brief Reapply the edits of the most recently undone entry
+    /// \returns Where the reapplied edits began, or nothing if there was nothing to redo
+    std::optional<Position> redo();
+
+    /// \brief Turn undo recording on or off; batch edits don't need it, and it doubles their memory use
+    void keepHistory(bool keep) noexcept;
+
+    /// \brief Called after the rows of the buffer change: the @p removed rows from row @p y on have been replaced by
+    /// \brief the @p inserted rows now there
+    using RowsChanged = std::function<void(int y, int removed, int inserted)>;
+
+    /// \brief Have @p callback called after every change to the rows, be it an edit, an undo or a row read from the file
+    /// \details Views of the text, such as a screen layout, use it to keep up with the rows that changed only
+    void onRowsChanged(RowsChanged callback) { m_rowsChanged = std::move(callback); }
+
+private:
+    /// \brief Enough of a primitive edit to reverse and reapply it
+    struct Edit
+    {
+        enum class Kind { Insert, Erase, EraseRows, Splice };
+
+        Kind kind;
+        Position from;      /// Where the edit began; for EraseRows, the first row erased
+        Position to;        /// Where the edit ended; for EraseRows, to.y is the number of rows erased
+        std::string text;   /// The text inserted or erased, with a '\n' between rows
+        bool appendedRow;   /// Whether an Insert or a Splice had to append a row past the end of the buffer
+        std::uint64_t entry;
+        std::vector<Splice> splices {};     /// For a Splice, the replacements made
+        std::vector<Splice> inverse {};     /// For a Splice, the replacements that revert them
+    };
+
+    std::vector<std::string> m_rows;
+    /// \brief A part of the file still to be read, and the row its first byte belongs to
+    struct Range
+    {
+        int row;
+        std::uint64_t begin;
+        std::uint64_t end;  /// EndOfFile to read up to the end of the file
+    };
+
+    static constexpr std::uint64_t EndOfFile = std::numeric_limits<std::uint64_t>::max();
+
+    std::unique_ptr<std::istream> m_source;     /// The text of the file being loaded; closed once it has been read
+    Compression m_compression {Compression::None};  /// How the file opened is compressed, and so how it is saved
+    std::shared_ptr<SeekIndex> m_seekIndex;     /// The access points of the compressed file opened, as they are found
+    std::vector<Range> m_ranges;    /// The parts of the file still to be read, in order; empty once loaded
+    std::uint64_t m_loadPos {0};    /// The offset in the file of the next byte to be read
+    int m_loadRow {0};          /// The row the next row read is stored in
+    std::string m_partial;      /// The start of a row whose end hasn't been read yet
+    bool m_endsWithNewline {true};  /// Whether the text loaded ended with a line terminator
+    TextFormat m_format;
+    Utf8Validator m_validator;  /// Checks the range being read, until the file turns out not to be UTF-8
+    bool m_dirty {false};
+    std::uint64_t m_edits {0};
+
+    std::vector<Edit> m_undo;
+    std::vector<Edit> m_redo;
+    std::uint64_t m_entry {0};      /// The undo entry edits are currently recorded in
+    bool m_keepHistory {true};
+    RowsChanged m_rowsChanged;
+
+    void reset();
+    void start(std::filesystem::path const& path, std::vector<Range> ranges, std::shared_ptr<SeekIndex> seekIndex = nullptr);
+    void seek();
+    void nextRange();
+    void split(std::string_view text);
+    void emit(std::string_view row);
+    void flushPartial(bool endOfFile);
+    void fallBackToLatin1();
+
+    /// \returns The bytes of the file the rows make up
+    /// \throws std::system_error If the text has characters the encoding can't hold
+    [[nodiscard]]
+    std::string encoded() const;
+
+    Position applyInsert(Position at, std::string_view text);
+    void applyErase(Position from, Position to);
+    void applyEraseRows(int y, int count);
+    std::vector<Splice> applySplices(std::vector<Splice> const& splices, bool keepText);
+    void record(Edit edit);
+    void changed(int y, int removed, int inserted) const;
+
+    /// \brief Clamp @p at to a valid position in the buffer
+    [[nodiscard]]
+    Position clamp(Position at) const noexcept;
+};
+
+#endif
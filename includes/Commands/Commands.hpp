@@ -0,0 +1,68 @@
+#ifndef COMMANDS_HPP
+#define COMMANDS_HPP
+
+#include "Buffer/Buffer.hpp"
+#include "Cursor/Cursor.hpp"
+#include "CursorSet/CursorSet.hpp"
+#include "Folds/Folds.hpp"
+
+#include <cstddef>
+#include <string_view>
+
+/// \brief Editing commands shared by the interactive editor and batch scripts
+/// \details Each command acts on a buffer at the position of a cursor, and leaves the cursor where a user would
+/// \details expect it to be afterwards. None of them know anything about the screen.
+/// \details The editing commands also act at every cursor of a CursorSet at once, as a single splice of the buffer.
+namespace commands
+{
+    /// \brief Insert @p text at the cursor and move the cursor past it
+    void insertText(Buffer& buffer, Cursor& cursor, std::string_view text);
+
+    /// \brief Split the row at the cursor and move the cursor to the start of the new row
+    void insertNewline(Buffer& buffer, Cursor& cursor);
+
+    /// \brief Delete the character before the cursor, joining rows if the cursor is at the start of one
+    void deleteBackward(Buffer& buffer, Cursor& cursor);
+
+    /// \brief Delete the character under the cursor, joining rows if the cursor is at the end of one
+    void deleteForward(Buffer& buffer, Cursor& cursor);
+
+    /// \brief Insert @p text at every cursor and move each cursor past it
+    void insertText(Buffer& buffer, CursorSet& cursors, std::string_view text);
+
+    /// \brief Split the row at every cursor
+    void insertNewline(Buffer& buffer, CursorSet& cursors);
+
+    /// \brief Delete the character before every cursor
+    void deleteBackward(Buffer& buffer, CursorSet& cursors);
+
+    /// \brief Delete the character under every cursor
+    void deleteForward(Buffer& buffer, CursorSet& cursors);
+
+    /// \brief Put a cursor on every occurrence of the word under the primary cursor, at the same place in the word
+    /// \returns The number of occurrences, or 0 if the primary cursor isn't on a word, in which case the cursors are
+    /// \returns left as they are
+    std::size_t cursorsAtWord(Buffer const& buffer, CursorSet& cursors);
+
+    /// \brief Delete @p count whole rows starting at the row the cursor is on
+    void deleteRows(Buffer& buffer, Cursor& cursor, int count);
+
+    /// \brief Move the cursor to the start of its row
+    void moveHome(Cursor& cursor) noexcept;
+
+    /// \brief Move the cursor to the end of its row
+    void moveEnd(Buffer const& buffer, Cursor& cursor) noexcept;
+
+    /// \brief Move the cursor to @p at, clamped to the buffer
+    void moveTo(Buffer const& buffer, Cursor& cursor, Position at) noexcept;
+
+    /// \brief Move every cursor @p count visible rows down, or up if @p count is negative, keeping its column
+    /// \details A closed fold counts as one row, and a cursor is never moved past the row after the last
+    void moveRows(Buffer const& buffer, Folds const& folds, CursorSet& cursors, int count);
+
+    /// \brief Replace every occurrence of @p from with @p to; neither may contain a '\n'
+    /// \returns The number of occurrences replaced
+    std::size_t replaceAll(Buffer& buffer, std::string_view from, std::string_view to);
+}
+
+#endif
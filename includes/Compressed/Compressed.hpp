@@ -0,0 +1,254 @@
+#ifndef COMPRESSED_HPP
+#define COMPRESSED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <list>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+#include <zstd.h>
+
+/// \brief How the text of a file is stored on disk
+enum class Compression { None, Gzip, Zstd };
+
+/// \brief The places in a compressed file that decompression can restart from, recorded as the file is first read
+/// \details Block i of the text runs from access point i to access point i + 1. Once the whole file has been read,
+/// \details the index is complete, and its last point marks the end of the text; until then, the last point is where
+/// \details reading has got to. A complete index can be kept, e.g. in a session, and handed to the reader of the same
+/// \details file later, which can then seek anywhere in it without reading up to there first.
+struct SeekIndex
+{
+    /// \brief A place decompression can restart from
+    struct AccessPoint
+    {
+        std::uint64_t out {0};  /// The offset of the text that starts there
+        std::uint64_t in {0};   /// The offset in the file of the first byte that holds any of its bits
+        int bits {0};           /// How many bits of the byte before @p in belong to it, if any
+        std::uint64_t skip {0}; /// How much text decompression from @p in makes before it reaches @p out
+        std::vector<unsigned char> window {};   /// The text that precedes it, which deflate may refer back to
+    };
+
+    std::vector<AccessPoint> points { AccessPoint {} };
+    bool complete {false};
+};
+
+/// \brief Reads the text of a compressed file, seeking to any offset in it without decompressing all that precedes it
+/// \details As the file is decompressed for the first time, an access point is recorded about every Span bytes of
+/// \details text. The text is then decompressed a block, from one access point to the next, at a time, and the most
+/// \details recently used blocks are cached up to CacheBytes in all. How an access point is recorded and how a block
+/// \details is decompressed again from it is up to the format.
+class SeekableReader : public std::streambuf
+{
+public:
+    /// \brief About how much text lies between two access points
+    static constexpr std::size_t Span = 1 << 20;
+
+    /// \brief The most text kept decompressed; the block being read is always kept, whatever its size
+    static constexpr std::size_t CacheBytes = 8 << 20;
+
+    ~SeekableReader() override = default;
+
+    SeekableReader(SeekableReader const&) = delete;
+    SeekableReader& operator=(SeekableReader const&) = delete;
+
+    /// \returns The access points recorded so far
+    [[nodiscard]]
+    std::shared_ptr<SeekIndex> const& index() const noexcept { return m_index; }
+
+    /// \returns The number of access points recorded so far
+    [[nodiscard]]
+    std::size_t accessPoints() const noexcept { return m_index->points.size(); }
+
+    /// \returns How much decompressed text is cached
+    [[nodiscard]]
+    std::size_t cachedBytes() const noexcept { return m_cachedBytes; }
+
+protected:
+    /// \param path The file to read
+    /// \param index The access points to record into, or a complete index of the file to seek with straight away;
+    /// \param index if null, the reader records an index of its own
+    /// \throws std::system_error If the file cannot be opened
+    SeekableReader(std::filesystem::path const& path, std::shared_ptr<SeekIndex> index);
+
+    /// \throws std::system_error If the file is corrupt or cannot be read
+    int_type underflow() override;
+    pos_type seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios::openmode which) override;
+
+    /// \brief Decompress the block that starts at the last access point, and record the access point that ends it, or
+    /// \brief complete the index at the end of the file
+    /// \returns The text of the block
+    virtual std::string indexNext() = 0;
+
+    /// \brief Decompress the block that starts at access point @p point again, once it has dropped out of the cache
+    virtual std::string decompress(std::size_t point) = 0;
+
+    [[nodiscard]]
+    std::vector<SeekIndex::AccessPoint>& points() noexcept { return m_index->points; }
+
+    /// \brief Read up to @p size bytes of the file from @p offset on
+    /// \returns How many bytes were read; fewer than @p size at the end of the file
+    std::size_t read(std::uint64_t offset, unsigned char* data, std::size_t size);
+
+    [[noreturn]]
+    void corrupt(char const* reason) const;
+
+private:
+    /// \brief The text from one access point to the next
+    struct Block
+    {
+        std::size_t point;
+        std::string text;
+    };
+
+    std::filesystem::path m_path;
+    std::ifstream m_file;
+    std::shared_ptr<SeekIndex> m_index;
+
+    std::list<Block> m_cache;   /// Most recently used first
+    std::size_t m_cachedBytes {0};
+    std::uint64_t m_blockStart {0};     /// The offset of the text in the get area
+
+    [[nodiscard]]
+    std::uint64_t position() const noexcept;
+    void moveTo(std::uint64_t pos) noexcept;
+    void detach() noexcept;
+
+    void indexAndRemember();
+    Block const& block(std::size_t point);
+    Block const& remember(std::size_t point, std::string text);
+};
+
+/// \brief Reads the text of a gzip file, seeking in it as SeekableReader does
+/// \details An access point is where a deflate block starts, along with the 32 KiB of text that precede it, which
+/// \details deflate may refer back to. Concatenated gzip members, as written by e.g. `cat a.gz b.gz`, are read as one
+/// \details text.
+class GzipReader final : public SeekableReader
+{
+public:
+    /// \throws std::system_error If the file cannot be opened
+    explicit GzipReader(std::filesystem::path const& path, std::shared_ptr<SeekIndex> index = nullptr);
+    ~GzipReader() override;
+
+protected:
+    std::string indexNext() override;
+    std::string decompress(std::size_t point) override;
+
+private:
+    /// The stream that reads the file from start to end, once, to record the access points
+    z_stream m_indexer {};
+    std::vector<unsigned char> m_indexerInput;
+    std::uint64_t m_indexerRead {0};    /// The offset in the file of the next byte the indexer reads
+};
+
+/// \brief Reads the text of a zstd file, seeking in it as SeekableReader does
+/// \details Each zstd frame is compressed on its own, so the start of a frame is an access point that needs nothing
+/// \details else to restart from. A frame that runs on for more than twice Span, such as the single frame the zstd
+/// \details tool writes, gets access points inside it too, which restart at the start of the frame and skip the text up
+/// \details to the point. Concatenated frames are read as one text.
+class ZstdReader final : public SeekableReader
+{
+public:
+    /// \throws std::system_error If the file cannot be opened
+    explicit ZstdReader(std::filesystem::path const& path, std::shared_ptr<SeekIndex> index = nullptr);
+    ~ZstdReader() override;
+
+protected:
+    std::string indexNext() override;
+    std::string decompress(std::size_t point) override;
+
+private:
+    /// The stream that reads the file from start to end, once, to record the access points
+    ZSTD_DCtx* m_indexer;
+    std::vector<unsigned char> m_indexerInput;
+    ZSTD_inBuffer m_indexerIn {};
+    std::uint64_t m_indexerRead {0};    /// The offset in the file of the next byte the indexer reads
+    bool m_betweenFrames {true};        /// Whether the indexer has just finished a frame, or not started any
+    std::uint64_t m_frameIn {0};        /// The offset in the file of the frame the indexer is in
+    std::uint64_t m_frameOut {0};       /// The offset of the text that frame starts with
+};
+
+/// \brief Writes text to a file, gzip-compressing it
+/// \details Every flush ends a gzip member, so that everything written so far is on disk in a file that can be read
+/// \details back; readers treat the members as one text.
+class GzipWriter final : public std::streambuf
+{
+public:
+    /// \throws std::system_error If the file cannot be created
+    explicit GzipWriter(std::filesystem::path const& path);
+    ~GzipWriter() override;
+
+    GzipWriter(GzipWriter const&) = delete;
+    GzipWriter& operator=(GzipWriter const&) = delete;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(char const* data, std::streamsize count) override;
+    int sync() override;
+
+private:
+    gzFile m_file;
+};
+
+/// \brief Writes text to a file, zstd-compressing it
+/// \details A frame is ended every FrameSize bytes of text, so that a reader can restart at each of them rather than
+/// \details skip the text of one long frame, and on every flush, so that everything written so far is on disk in a
+/// \details file that can be read back.
+class ZstdWriter final : public std::streambuf
+{
+public:
+    /// \brief How much text each frame holds, at most
+    static constexpr std::size_t FrameSize = SeekableReader::Span;
+
+    /// \throws std::system_error If the file cannot be created
+    explicit ZstdWriter(std::filesystem::path const& path);
+    ~ZstdWriter() override;
+
+    ZstdWriter(ZstdWriter const&) = delete;
+    ZstdWriter& operator=(ZstdWriter const&) = delete;
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(char const* data, std::streamsize count) override;
+    int sync() override;
+
+private:
+    std::ofstream m_file;
+    ZSTD_CCtx* m_context;
+    std::vector<char> m_output;
+    std::size_t m_frameBytes {0};   /// How much text the frame being written holds
+    bool m_written {false};         /// Whether any frame has been ended yet
+
+    bool compress(char const* data, std::size_t size, ZSTD_EndDirective mode);
+};
+
+namespace compressed
+{
+    /// \returns How the file at @p path is compressed, going by its first bytes
+    /// \throws std::system_error If the file cannot be opened
+    [[nodiscard]]
+    Compression detect(std::filesystem::path const& path);
+
+    /// \brief Open the file at @p path for reading its text, decompressing it if it is compressed as @p compression
+    /// \details A decompressing stream throws the std::system_error of a corrupt file from its reads. It records its
+    /// \details access points into @p index, if one is given, or seeks with it straight away if it is complete.
+    /// \throws std::system_error If the file cannot be opened
+    [[nodiscard]]
+    std::unique_ptr<std::istream> openForReading(std::filesystem::path const& path, Compression compression,
+        std::shared_ptr<SeekIndex> index = nullptr);
+
+    /// \brief Create the file at @p path for writing text to, compressing it as @p compression
+    /// \throws std::system_error If the file cannot be created
+    [[nodiscard]]
+    std::unique_ptr<std::ostream> openForWriting(std::filesystem::path const& path, Compression compression);
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CURSOR_HPP
+#define CURSOR_HPP
+
+#include "Keys/Keys.hpp"
+#include "Buffer/Buffer.hpp"
+#include "Folds/Folds.hpp"
+
+/// Data type representing the position of the cursor in a buffer
+struct Cursor
+{
+    int xPos{};
+    int yPos{};
+
+    /// Move the cursor in the direction of the arrow key pressed, stepping over the rows @p folds hide
+    void moveCursor(Key const& key, Buffer const& buffer, Folds const& folds = {});
+
+    /// The position of the cursor in the buffer
+    [[nodiscard]]
+    Position position() const noexcept { return { xPos, yPos }; }
+
+    /// Move the cursor to a position in the buffer
+    void moveTo(Position at) noexcept { xPos = at.x; yPos = at.y; }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef CURSOR_SET_HPP
+#define CURSOR_SET_HPP
+
+#include "Cursor/Cursor.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/// \brief The cursors edits are made at, kept in order through the buffer and without duplicates
+/// \details There is always at least one cursor. One of them is the primary cursor, the one the window follows and
+/// \details that commands acting on a single position use; a cursor added becomes the primary cursor.
+/// \details Edits made at every cursor are made as a single splice of the buffer, which reports where each of them
+/// \details ends, so the cursors are all moved in a single pass over them.
+class CursorSet
+{
+public:
+    /// \brief A single cursor at the start of the buffer
+    CursorSet() = default;
+
+    /// \returns The number of cursors
+    [[nodiscard]]
+    std::size_t size() const noexcept { return m_cursors.size(); }
+
+    [[nodiscard]]
+    auto begin() const noexcept { return m_cursors.cbegin(); }
+
+    [[nodiscard]]
+    auto end() const noexcept { return m_cursors.cend(); }
+
+    [[nodiscard]]
+    Cursor const& operator[](std::size_t i) const noexcept { return m_cursors[i]; }
+
+    /// \returns The primary cursor
+    [[nodiscard]]
+    Cursor& primary() noexcept { return m_cursors[m_primary]; }
+
+    [[nodiscard]]
+    Cursor const& primary() const noexcept { return m_cursors[m_primary]; }
+
+    /// \returns The cursors on row @p y, in order
+    [[nodiscard]]
+    std::span<Cursor const> onRow(int y) const noexcept;
+
+    /// \brief Add a cursor at @p at and make it the primary cursor
+    void add(Position at);
+
+    /// \brief Replace the cursors with the cursors at @p positions, which must be in order; the primary cursor becomes
+    /// \brief the one at @p positions[@p primary]
+    void assign(std::vector<Position> const& positions, std::size_t primary);
+
+    /// \brief Keep only the primary cursor
+    void collapse() noexcept;
+
+    /// \brief Move every cursor, in order, with @p move, then put them back in order
+    template <typename Move>
+    void moveEach(Move&& move)
+    {
+        for (auto& cursor : m_cursors) {
+            move(cursor);
+        }
+
+        normalise();
+    }
+
+    /// \brief Put the cursors back in order and merge the cursors that have met, after they have been moved
+    /// \details Moving every cursor the same way keeps them in order, in which case this takes a single pass
+    void normalise();
+
+private:
+    std::vector<Cursor> m_cursors {Cursor {}};
+    std::size_t m_primary {0};
+};
+
+#endif
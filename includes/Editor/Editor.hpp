@@ -2,29 +2,29 @@
 #define EDITOR_HPP
 
 #include "Keys/Keys.hpp"
+#include "Buffer/Buffer.hpp"
+#include "Cursor/Cursor.hpp"
+#include "CursorSet/CursorSet.hpp"
+#include "Keymap/Keymap.hpp"
+#include "Modal/Modal.hpp"
 #include "Terminal/Terminal.hpp"
 #include "Offset/Offset.hpp"
+#include "Latency/Latency.hpp"
+#include "Output/Output.hpp"
+#include "Session/Session.hpp"
+#include "WrapLayout/WrapLayout.hpp"
 #include <winsize/winsize.hpp>
 
+#include <unistd.h>
+
+#include <optional>
 #include <string>
 #include <filesystem>
 #include <string_view>
-#include <vector>
-
-/// Data type representing the position of the cursor in the terminal window
-struct Cursor
-{
-    int xPos{};
-    int yPos{};
-
-    /// Move the cursor in the direction of the arrow key pressed
-    void moveCursor(Key const& key);
-};
 
+/// The interactive, terminal front end of the editor
 class Editor
 {
-    friend struct Cursor;
-
 public:
     Editor();
     ~Editor();
@@ -32,25 +32,61 @@ public:
     Editor& operator=(Editor const&) = delete;
 
     static Editor& instance();
+    bool waitForInput();
     void processKeypress();
     void refreshScreen();
     void open(std::filesystem::path const& path);
 
 private:
     Terminal m_terminalCtrl;
-    Cursor m_cursor {};    /// The position of the cursor in the terminal window
+    Output m_output {STDOUT_FILENO};   /// Where frames are painted, without ever blocking on a slow terminal
+    Cursor m_cursor {};    /// The position of the cursor in the buffer
+    CursorSet m_cursors;    /// Every cursor, as of the last command that acted on all of them; m_cursor is the primary one
     std::string_view KILO_VERSION{ "0.0.1" };   /// The version of this application
     kilo::lib::winsize::winsize m_winsize;  // The size of the terminal window
-    int m_numRows {0};  /// The number of rows of text in the file
-    std::vector<std::string> m_text;    /// Text read from the file opened
+    Buffer m_buffer;    /// Text read from the file opened
     Offset m_offset;
-    std::string_view m_filename;     /// The name of the file currently opened by the editor
+    std::filesystem::path m_filename;     /// The name of the file currently opened by the editor
+    std::string m_statusMsg;    /// A transient message shown in the status bar until the next keypress
+    Keymap m_keymap {DefaultKeymap};  /// Maps the keys pressed to the commands they run
+    Modal m_modal;  /// Interprets the keys pressed outside of insert mode
+    Latency m_latency;  /// Input-to-photon timings of each frame
+    bool m_showLatency {false};     /// Whether the latency overlay is drawn in the status bar
+    std::string m_latencyLog;   /// Where to dump the latency histograms on exit; empty if they aren't dumped
+    std::string m_paste;    /// The text of the bracketed paste being executed
+    std::optional<std::filesystem::path> m_sidecar;   /// Where the session of the file opened is kept, if anywhere
+    std::optional<Session> m_session;   /// The session restored when the file was opened
+    bool m_wrap {false};    /// Whether rows wider than the window are wrapped onto the screen rows below
+    WrapLayout m_layout;    /// Where each row is on screen with wrapping on; only kept up to date while it is on
+    Folds m_folds;  /// The rows folded away
+    int m_cursorRow {0};    /// The row of the window the cursor is on, as of the last scroll
 
     void drawRows(std::string& buffer);
+    void drawRow(std::string& buffer, int filerow, int from) const;
     void displayWelcomeMessage(std::string& buffer) const;
     void scroll();
+    void resize();
+    [[nodiscard]]
+    Position cursorOnScreen() const noexcept;
+    [[nodiscard]]
+    Position topLine() const noexcept;
+    [[nodiscard]]
+    Position cursorLine() const noexcept;
+    [[nodiscard]]
+    Position below(Position line) const noexcept;
+    [[nodiscard]]
+    Position above(Position line) const noexcept;
+    void drawFoldMarker(std::string& buffer, Position line) const;
+    void drawCursors(std::string& buffer, std::string_view visible, int filerow, int from) const;
+    CursorSet& cursors();
     void drawStatusBar(std::string& buffer) const;
-    void processKeypressHelper(Key const& key) noexcept;
+    void execute(Command command, Key key) noexcept;
+    void loadKeymap(std::filesystem::path const& path);
+    void toggleLatencyOverlay() noexcept;
+    void toggleWrap();
+    void save();
+    void saveSession() noexcept;
+    void restore(std::optional<Position> where, std::string_view nothing);
 };
 
 #endif
\ No newline at end of file
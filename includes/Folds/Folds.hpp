@@ -0,0 +1,91 @@
+#ifndef FOLDS_HPP
+#define FOLDS_HPP
+
+#include "Buffer/Buffer.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+/// \brief A range of rows folded away behind the first of them
+struct Fold
+{
+    int first;  /// The row shown in place of the fold
+    int last;   /// The last row the fold hides
+};
+
+/// \brief The folded regions of a buffer, and the rows they leave visible
+/// \details Folds never overlap: folding rows that overlap existing folds merges them into one. The folds are kept
+/// \details sorted, along with how many rows the folds before each one hide, so the visible row a row is shown as,
+/// \details the index of a row among the visible ones and the row at a visible index are each found by a binary search,
+/// \details in O(log k) for k folds. Moving past a fold is one step however many rows it hides, and folding or opening
+/// \details a region costs the same whatever its size.
+/// \details Folds follow the edits to the buffer, as reported by Buffer::onRowsChanged: rows inserted or erased move
+/// \details the folds after them, and a fold whose rows have all been erased goes.
+class Folds
+{
+public:
+    /// \brief Fold rows (@p first, @p last] away behind row @p first, merging the folds the range overlaps
+    void fold(int first, int last);
+
+    /// \brief Fold the rows indented deeper than the row that heads the block row @p y is in
+    /// \details A row heads the rows after it that are indented deeper than it, blank rows in between included. Row
+    /// \details @p y heads the block if it has any such rows; otherwise the nearest row above it that is indented less
+    /// \details does. A blank row is taken to be indented as deep as the row after it.
+    /// \returns Whether there was a block to fold
+    bool foldIndented(Buffer const& buffer, int y);
+
+    /// \brief Fold every outermost indented block of @p buffer
+    void foldAllIndented(Buffer const& buffer);
+
+    /// \brief Open the fold row @p y is in, its first row included
+    /// \returns Whether there was a fold to open
+    bool unfold(int y);
+
+    /// \brief Open every fold
+    void clear() noexcept;
+
+    /// \returns The number of folds
+    [[nodiscard]]
+    std::size_t size() const noexcept { return m_folds.size(); }
+
+    /// \returns The fold row @p y is in, its first row included, if there is one
+    [[nodiscard]]
+    std::optional<Fold> at(int y) const noexcept;
+
+    /// \returns Whether row @p y is folded away
+    [[nodiscard]]
+    bool hidden(int y) const noexcept;
+
+    /// \returns The row that row @p y is shown as: @p y itself, or the first row of the fold that hides it
+    [[nodiscard]]
+    int visible(int y) const noexcept;
+
+    /// \returns The visible row @p count visible rows below the one row @p y is shown as, or above it if @p count is
+    /// \returns negative; never above row 0, but possibly past the end of the buffer
+    [[nodiscard]]
+    int step(int y, int count) const noexcept;
+
+    /// \returns The number of visible rows above the one row @p y is shown as
+    [[nodiscard]]
+    int visibleIndex(int y) const noexcept;
+
+    /// \returns The row that is the @p index th visible row, counting from 0
+    [[nodiscard]]
+    int visibleRow(int index) const noexcept;
+
+    /// \brief Move the folds to follow a change to the rows of the buffer, as reported by Buffer::onRowsChanged
+    void update(int y, int removed, int inserted);
+
+private:
+    std::vector<Fold> m_folds;
+    std::vector<int> m_hidden {0};  /// The number of rows hidden by the folds before each fold, and by all of them
+
+    /// \returns The index of the first fold that ends at or after row @p y
+    [[nodiscard]]
+    std::size_t from(int y) const noexcept;
+
+    void reindex(std::size_t first);
+};
+
+#endif
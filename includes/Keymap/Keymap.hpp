@@ -0,0 +1,248 @@
+#ifndef KEYMAP_HPP
+#define KEYMAP_HPP
+
+#include "Keys/Keys.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+/// \brief The operations the editor can bind keys to
+enum class Command : std::uint8_t {
+    None,
+    Quit, Save, ToggleLatency, ToggleWrap,
+    MoveLeft, MoveRight, MoveUp, MoveDown,
+    PageUp, PageDown, Home, End,
+    InsertChar, InsertNewline, DeleteBackward, DeleteForward,
+    NormalMode,
+    Paste, Undo, Redo,
+    AddCursorBelow, CursorsAtWord,
+    Count
+};
+
+/// \brief The number of distinct keys: every byte, followed by the special keys starting at Key::ArrowLeft
+inline constexpr std::size_t KeyCount = 256 + (static_cast<std::size_t>(Key::Paste) - static_cast<std::size_t>(Key::ArrowLeft) + 1);
+
+/// \returns The dense index of @p key in [0, KeyCount), or KeyCount if the key is out of range
+[[nodiscard]]
+constexpr std::size_t keyIndex(Key key) noexcept
+{
+    auto const code = static_cast<int>(key);
+
+    if (code >= 0 and code < 256) {
+        return static_cast<std::size_t>(code);
+    }
+    else if (code >= static_cast<int>(Key::ArrowLeft) and code <= static_cast<int>(Key::Paste)) {
+        return 256 + static_cast<std::size_t>(code - static_cast<int>(Key::ArrowLeft));
+    }
+
+    return KeyCount;
+}
+
+/// \brief Maps keys, and chords of two keys such as CTRL-X CTRL-S, to commands
+/// \details Each table is a dense array indexed by keyIndex, so a lookup is a single array access and never
+/// \details allocates. The first key of a chord is bound to a second table in which the next key is looked up.
+class Keymap
+{
+public:
+    /// \brief The most keys a binding may consist of
+    static constexpr std::size_t MaxSequence = 2;
+
+    /// \brief The most distinct chord prefixes a keymap may hold
+    static constexpr std::size_t MaxChords = 4;
+
+    /// \brief An empty keymap in which every key is unbound
+    constexpr Keymap() noexcept = default;
+
+    /// \brief The default bindings, built at compile time
+    [[nodiscard]]
+    static constexpr Keymap defaults() noexcept;
+
+    /// \brief Look up the next key pressed
+    /// \returns The command bound to the key, or Command::None if it is unbound or starts a chord
+    [[nodiscard]]
+    constexpr Command lookup(Key key) noexcept
+    {
+        auto const index = keyIndex(key);
+        auto const table = m_pending;
+        m_pending = 0;
+
+        if (index == KeyCount) {
+            return Command::None;
+        }
+
+        auto const& binding = m_tables[table][index];
+        m_pending = binding.chord;
+
+        return binding.command;
+    }
+
+    /// \returns Whether the keys looked up so far are the start of a chord
+    [[nodiscard]]
+    constexpr bool pending() const noexcept { return m_pending != 0; }
+
+    /// \brief Abandon a chord whose first key has been looked up, e.g. when another handler takes the next key
+    constexpr void cancel() noexcept { m_pending = 0; }
+
+    /// \brief Bind a sequence of one or two keys to @p command; binding Command::None unbinds the sequence
+    /// \throws std::invalid_argument If the sequence is empty, too long, or clashes with a chord
+    /// \throws std::length_error If the keymap has no room for another chord
+    constexpr void bind(std::span<Key const> sequence, Command command);
+
+    /// \brief Apply the bindings read from @p in
+    /// \details Each line is either "bind <key>... <command>" or "unbind <key>..."; blank lines and lines
+    /// \details starting with '#' are ignored. Keys are named as in "ctrl-x", "pagedown", "up", "space" or "a".
+    /// \throws std::invalid_argument If a line cannot be parsed; the message names the line
+    void load(std::istream& in);
+
+    /// \returns The key named @p name, if there is one
+    [[nodiscard]]
+    static std::optional<Key> keyNamed(std::string_view name) noexcept;
+
+    /// \returns The command named @p name, if there is one
+    [[nodiscard]]
+    static std::optional<Command> commandNamed(std::string_view name) noexcept;
+
+private:
+    struct Binding
+    {
+        Command command {Command::None};
+        std::uint8_t chord {0};     /// If non-zero, the table in which the next key of the chord is looked up
+    };
+
+    using Table = std::array<Binding, KeyCount>;
+
+    /// Table 0 holds single keys; tables [1, MaxChords] hold the second key of each chord
+    std::array<Table, MaxChords + 1> m_tables {};
+    std::uint8_t m_pending {0};
+
+    /// \returns A chord table that no key points to, such as one left behind by an unbound prefix, or 0 if every
+    /// \returns table is in use
+    [[nodiscard]]
+    constexpr std::uint8_t unusedChordTable() const noexcept
+    {
+        for (std::uint8_t table = 1; table <= MaxChords; ++table) {
+            auto const used = [table](Binding const& binding) { return binding.chord == table; };
+
+            if (std::none_of(m_tables[0].begin(), m_tables[0].end(), used)) {
+                return table;
+            }
+        }
+
+        return 0;
+    }
+};
+
+constexpr void Keymap::bind(std::span<Key const> sequence, Command command)
+{
+    if (sequence.empty() or sequence.size() > MaxSequence) {
+        throw std::invalid_argument("A binding must consist of one or two keys");
+    }
+
+    for (auto key : sequence) {
+        if (keyIndex(key) == KeyCount) {
+            throw std::invalid_argument("Cannot bind a key outside of the keymap");
+        }
+    }
+
+    auto& first = m_tables[0][keyIndex(sequence[0])];
+
+    if (sequence.size() == 1) {
+        if (first.chord != 0 and command != Command::None) {
+            throw std::invalid_argument("The key already starts a chord");
+        }
+
+        first = Binding { command, first.chord };
+
+        // Unbinding a chord prefix unbinds every chord that starts with it
+        if (command == Command::None) {
+            first.chord = 0;
+        }
+
+        return;
+    }
+
+    if (first.chord == 0) {
+        if (command == Command::None) {
+            return;
+        }
+        else if (first.command != Command::None) {
+            throw std::invalid_argument("The first key of the chord is already bound to a command");
+        }
+
+        first.chord = unusedChordTable();
+
+        if (first.chord == 0) {
+            throw std::length_error("The keymap has no room for another chord");
+        }
+
+        m_tables[first.chord] = Table {};
+    }
+
+    m_tables[first.chord][keyIndex(sequence[1])] = Binding { command, 0 };
+}
+
+constexpr Keymap Keymap::defaults() noexcept
+{
+    Keymap keymap;
+
+    auto const bindKey = [&keymap](Key key, Command command) {
+        std::array<Key, 1> const sequence { key };
+        keymap.bind(sequence, command);
+    };
+
+    auto const bindChord = [&keymap](Key prefix, Key key, Command command) {
+        std::array<Key, 2> const sequence { prefix, key };
+        keymap.bind(sequence, command);
+    };
+
+    auto const ctrl = [](char c) { return static_cast<Key>(ctrlKey(c)); };
+
+    for (int c = 0; c < 256; ++c) {
+        if (isPrintable(static_cast<Key>(c))) {
+            bindKey(static_cast<Key>(c), Command::InsertChar);
+        }
+    }
+
+    bindKey(Key::ArrowLeft, Command::MoveLeft);
+    bindKey(Key::ArrowRight, Command::MoveRight);
+    bindKey(Key::ArrowUp, Command::MoveUp);
+    bindKey(Key::ArrowDown, Command::MoveDown);
+    bindKey(Key::PageUp, Command::PageUp);
+    bindKey(Key::PageDown, Command::PageDown);
+    bindKey(Key::Home, Command::Home);
+    bindKey(Key::End, Command::End);
+
+    bindKey(Key::Enter, Command::InsertNewline);
+    bindKey(Key::Backspace, Command::DeleteBackward);
+    bindKey(ctrl('h'), Command::DeleteBackward);
+    bindKey(Key::Delete, Command::DeleteForward);
+    bindKey(Key::Escape, Command::NormalMode);
+    bindKey(Key::Paste, Command::Paste);
+
+    bindKey(ctrl('q'), Command::Quit);
+    bindKey(ctrl('s'), Command::Save);
+    bindKey(ctrl('t'), Command::ToggleLatency);
+    bindKey(ctrl('l'), Command::ToggleWrap);
+    bindKey(ctrl('z'), Command::Undo);
+    bindKey(ctrl('r'), Command::Redo);
+    bindKey(ctrl('n'), Command::AddCursorBelow);
+    bindKey(ctrl('d'), Command::CursorsAtWord);
+
+    // Emacs-style chords for the same
+    bindChord(ctrl('x'), ctrl('s'), Command::Save);
+    bindChord(ctrl('x'), ctrl('c'), Command::Quit);
+
+    return keymap;
+}
+
+/// \brief The default keymap, built once at compile time
+inline constexpr Keymap DefaultKeymap = Keymap::defaults();
+
+#endif
@@ -8,11 +8,13 @@
  * @brief We use integer constants to represent the keys in order to avoid conflicts with the regular [w, a, s, d] keys
  */
 enum class Key : int {
+    Enter = '\r', Backspace = 127,
     ArrowLeft = 1000, ArrowRight, ArrowUp, ArrowDown,
     Delete,
     Home, End,
     PageUp, PageDown,
-    Escape
+    Escape,
+    Paste       /// The start of a bracketed paste; the pasted text follows
 };
 
 /// Bitwise-ANDs a char with the value 0x1f (or 0b00011111), thus setting the upper 3 bits of the character to 0
@@ -67,4 +69,25 @@ constexpr bool isDeleteKey(Key const& key) noexcept
     return key == Key::Delete;
 }
 
+[[nodiscard]]
+constexpr bool isEnterKey(Key const& key) noexcept
+{
+    return key == Key::Enter;
+}
+
+/// Terminals send either DEL or CTRL-H for the backspace key
+[[nodiscard]]
+constexpr bool isBackspaceKey(Key const& key) noexcept
+{
+    return key == Key::Backspace or static_cast<int>(key) == ctrlKey('h');
+}
+
+/// Whether the key inserts a character into the text, i.e. printable ASCII, a tab, or a byte of a UTF-8 sequence
+[[nodiscard]]
+constexpr bool isPrintable(Key const& key) noexcept
+{
+    auto const c = static_cast<int>(key);
+    return (c >= ' ' and c < 127) or c == '\t' or (c >= 128 and c < 256);
+}
+
 #endif
\ No newline at end of file
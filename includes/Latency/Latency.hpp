@@ -0,0 +1,117 @@
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+/// \brief The stages a keypress passes through on its way to the screen, in order
+enum class Stage : std::size_t { Read, Decode, Dispatch, Layout, Render, Write };
+
+/// \brief A lock-free, log-linear histogram of durations in nanoseconds
+/// \details Every power of two is split into 16 linear sub-buckets, so a recorded value is off by at most ~6%
+class Histogram
+{
+public:
+    /// \brief Add a sample to the histogram
+    void record(std::uint64_t nanoseconds) noexcept;
+
+    /// \brief Estimate the value below which a fraction of the samples fall
+    /// \param[in] fraction A number in [0, 1], e.g. 0.99 for the 99th percentile
+    /// \returns The upper bound of the bucket holding the requested sample, or 0 if the histogram is empty
+    [[nodiscard]]
+    std::uint64_t percentile(double fraction) const noexcept;
+
+    [[nodiscard]]
+    std::uint64_t max() const noexcept;
+
+    [[nodiscard]]
+    std::uint64_t count() const noexcept;
+
+    /// \brief Write one "<label> <bucket lower bound> <count>" line per non-empty bucket
+    void dump(std::FILE* file, std::string_view label) const;
+
+private:
+    static constexpr std::size_t SubBucketBits = 4;
+    static constexpr std::size_t SubBuckets = 1 << SubBucketBits;
+    static constexpr std::size_t Buckets = (64 - SubBucketBits + 1) * SubBuckets;
+
+    std::array<std::atomic<std::uint64_t>, Buckets> m_buckets {};
+    std::atomic<std::uint64_t> m_count {0};
+    std::atomic<std::uint64_t> m_max {0};
+
+    [[nodiscard]]
+    static std::size_t bucketOf(std::uint64_t value) noexcept;
+
+    [[nodiscard]]
+    static std::uint64_t lowerBound(std::size_t bucket) noexcept;
+};
+
+/// \brief Input-to-photon latency instrumentation
+/// \details A frame starts when a keypress is waiting to be read and ends when the repainted screen has been written.
+/// \details Each stage is stamped with a monotonic timestamp, and the time spent since the previous stamp is
+/// \details recorded per stage, along with the total. When disabled, stamping costs a single branch.
+class Latency
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// \brief Start or stop collecting samples
+    void enable(bool enabled) noexcept;
+
+    [[nodiscard]]
+    bool enabled() const noexcept { return m_enabled; }
+
+    /// \brief Start a frame: a keypress is waiting to be read
+    void start() noexcept
+    {
+        if (m_enabled) [[unlikely]] {
+            m_start = m_last = Clock::now();
+            m_inFrame = true;
+        }
+    }
+
+    /// \brief Record the time at which @p stage finished
+    /// \details Stamping Stage::Write completes the frame that was started by the most recent start
+    void stamp(Stage stage) noexcept
+    {
+        if (m_enabled) [[unlikely]] {
+            record(stage, Clock::now());
+        }
+    }
+
+    /// \returns The histogram of time spent in @p stage
+    [[nodiscard]]
+    Histogram const& histogram(Stage stage) const noexcept;
+
+    /// \returns The histogram of the total input-to-photon latency, from the start of a frame to its Stage::Write
+    [[nodiscard]]
+    Histogram const& total() const noexcept { return m_total; }
+
+    /// \returns A one-line summary of the total latency, e.g. "lat p50 12us p99 48us max 1.2ms"
+    [[nodiscard]]
+    std::string summary() const;
+
+    /// \brief Write percentiles and the raw buckets of every stage to the file at @p path
+    /// \throws std::system_error If the file cannot be opened
+    void dump(std::string const& path) const;
+
+private:
+    static constexpr std::size_t StageCount = static_cast<std::size_t>(Stage::Write) + 1;
+
+    bool m_enabled {false};
+    bool m_inFrame {false};     /// Whether a frame has started and is awaiting its Stage::Write
+    Clock::time_point m_start {};   /// When the current frame started
+    Clock::time_point m_last {};    /// The most recent stamp of the current frame
+    std::array<Histogram, StageCount> m_histograms {};
+    Histogram m_total;
+
+    void record(Stage stage, Clock::time_point now) noexcept;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef LINE_INDEX_HPP
+#define LINE_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+/// \brief Where each row of a file starts, stored compactly
+/// \details Each row is stored as its length, including its '\n', in a LEB128 varint, so most rows take a byte or two.
+/// \details Every CheckpointEvery rows a checkpoint holds the absolute start of the row and where its varint is, so
+/// \details finding any row decodes at most CheckpointEvery - 1 varints. Only rows ended by a '\n' are indexed.
+/// \details An index can be a view of memory it doesn't own, such as a memory-mapped file; it is copied the first
+/// \details time it is extended.
+class LineIndex
+{
+public:
+    static constexpr int CheckpointEvery = 1024;
+
+    /// \brief The absolute start of a row, and where the varint holding that row's length begins
+    struct Checkpoint
+    {
+        std::uint64_t start;
+        std::uint64_t varint;
+    };
+
+    LineIndex() = default;
+
+    /// \brief View a serialised index, such as one in a memory-mapped sidecar, without copying it
+    /// \param storage Keeps the memory @p checkpoints and @p varints point into alive
+    /// \returns The index, or nothing if the data is inconsistent
+    [[nodiscard]]
+    static std::optional<LineIndex> view(std::shared_ptr<void const> storage, std::uint64_t rows, std::uint64_t bytes,
+        std::span<Checkpoint const> checkpoints, std::span<std::uint8_t const> varints);
+
+    /// \brief Index a row of @p length bytes, including its '\n', following the rows indexed so far
+    void append(std::uint64_t length);
+
+    /// \brief Index the rows in @p in, which holds the text that follows the rows indexed so far
+    /// \details A row at the end of @p in that isn't ended by a '\n' is not indexed
+    void extend(std::istream& in);
+
+    /// \returns The number of rows indexed
+    [[nodiscard]]
+    int rows() const noexcept { return static_cast<int>(m_rows); }
+
+    /// \returns The number of bytes the indexed rows span
+    [[nodiscard]]
+    std::uint64_t bytes() const noexcept { return m_bytes; }
+
+    /// \returns The offset of the first byte of row @p row; for row rows(), the offset just past the last indexed row
+    [[nodiscard]]
+    std::uint64_t start(int row) const noexcept;
+
+    [[nodiscard]]
+    std::span<Checkpoint const> checkpoints() const noexcept
+    {
+        return m_storage ? m_viewedCheckpoints : std::span<Checkpoint const> { m_checkpoints };
+    }
+
+    [[nodiscard]]
+    std::span<std::uint8_t const> varints() const noexcept
+    {
+        return m_storage ? m_viewedVarints : std::span<std::uint8_t const> { m_varints };
+    }
+
+private:
+    std::uint64_t m_rows {0};
+    std::uint64_t m_bytes {0};
+    std::vector<Checkpoint> m_checkpoints;
+    std::vector<std::uint8_t> m_varints;
+
+    /// Set if the index views memory it doesn't own, in which case the viewed spans are used instead of the vectors
+    std::shared_ptr<void const> m_storage;
+    std::span<Checkpoint const> m_viewedCheckpoints;
+    std::span<std::uint8_t const> m_viewedVarints;
+
+    /// \brief Copy the viewed memory into the vectors, so that the index can be extended
+    void own();
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef MODAL_HPP
+#define MODAL_HPP
+
+#include "Keys/Keys.hpp"
+#include "Buffer/Buffer.hpp"
+#include "Cursor/Cursor.hpp"
+#include "Folds/Folds.hpp"
+
+#include <string>
+#include <string_view>
+
+/// \brief The modes of the modal engine
+enum class Mode { Normal, Insert, Visual };
+
+/**
+ * @brief A vi-style modal engine in which counts, operators and motions compose
+ *
+ * In normal mode a command is [count] [operator [count]] motion, e.g. "5000j", "d10w" or "2d3w", as well as the
+ * doubled linewise operators "dd", "cc" and "yy". A counted motion is computed as one jump to its target, so
+ * "5000j" costs the same as "j". In visual mode motions extend the selection, which the operators then act on.
+ *
+ *     motions      h j k l  w b e  0 ^ $  gg G
+ *     operators    d c y
+ *     actions      x X D C Y  p P  i a I A o O  v  u
+ *     folds        zf{motion} zF  zc zo za  zM zR zE
+ *
+ * Given the folds of the window, "j" and "k" count a closed fold as one row, and linewise operators on a closed fold
+ * act on all of its rows. "zf" folds the rows a motion or the visual selection covers, "zc" folds the indented block
+ * the cursor is in and "zM" every outermost one, "zo" opens the fold under the cursor and "za" toggles it, and "zR"
+ * or "zE" open every fold.
+ *
+ * Insert mode is handled by the keymap; the engine is only told when it is entered or left.
+ */
+class Modal
+{
+public:
+    [[nodiscard]]
+    Mode mode() const noexcept { return m_mode; }
+
+    /// \brief Feed a key pressed in normal or visual mode
+    /// \returns Whether the key belonged to the engine; if not, the caller should look it up in the keymap
+    /// \throws std::bad_alloc If an edit runs out of memory
+    /// \throws std::system_error If a command that reads the rest of the file, such as "G", can't read it
+    bool feed(Key key, Buffer& buffer, Cursor& cursor);
+
+    /// \brief Return to normal mode, e.g. when ESC is pressed in insert mode
+    void enterNormal(Buffer const& buffer, Cursor& cursor) noexcept;
+
+    /// \returns The keys of the command typed so far, e.g. "5d"
+    [[nodiscard]]
+    std::string_view pending() const noexcept { return m_pending; }
+
+    /// \brief Have motions step over the folds in @p folds, and fold commands change them
+    void useFolds(Folds& folds) noexcept { m_folds = &folds; }
+
+    /// \returns Where the visual selection started; only meaningful in visual mode
+    [[nodiscard]]
+    Position anchor() const noexcept { return m_anchor; }
+
+private:
+    /// \brief Where a motion lands, and how an operator treats the text up to there
+    struct Motion
+    {
+        Position target;
+        bool linewise {false};      /// Whether operators act on whole rows
+        bool inclusive {false};     /// Whether operators include the character at the target
+    };
+
+    Mode m_mode {Mode::Normal};
+    int m_count {0};            /// The count typed so far; 0 if none was
+    int m_operatorCount {0};    /// The count typed before the pending operator; 0 if none was
+    char m_operator {'\0'};     /// The pending operator; '\0' if none is
+    bool m_prefixG {false};     /// Whether a 'g' is waiting for its second key
+    bool m_prefixZ {false};     /// Whether a 'z' is waiting for its second key
+    Folds* m_folds {nullptr};   /// The folds of the window, if there are any
+    std::string m_pending;
+    Position m_anchor {};
+
+    std::string m_register;         /// The text last deleted or yanked
+    bool m_registerLinewise {false};
+
+    /// \brief Run a key for feed, which drops the pending command if this throws
+    bool dispatch(Key key, Buffer& buffer, Cursor& cursor);
+
+    /// \brief Compute where a motion key lands, or return false if @p key is not a motion
+    bool motion(char key, int count, Buffer const& buffer, Cursor const& cursor, Motion& result) const;
+
+    /// \brief Apply the pending operator to the text between the cursor and a motion's target
+    void applyOperator(char op, Motion const& motion, Buffer& buffer, Cursor& cursor);
+
+    /// \brief Run a command that is neither an operator nor a motion, or return false if @p key is not one
+    bool action(char key, int count, Buffer& buffer, Cursor& cursor);
+
+    /// \brief Run a fold command, the key typed after 'z'
+    void foldCommand(char key, int count, Buffer const& buffer, Cursor& cursor);
+
+    /// \returns The row @p count rows below row @p y, or above it if negative, counting a closed fold as one row
+    [[nodiscard]]
+    int rowsAway(Buffer const& buffer, int y, int count) const noexcept;
+
+    /// \brief Apply an operator to the visual selection
+    void applyToSelection(char op, Buffer& buffer, Cursor& cursor);
+
+    void paste(bool after, int count, Buffer& buffer, Cursor& cursor);
+    void reset() noexcept;
+};
+
+#endif
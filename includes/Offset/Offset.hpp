@@ -8,6 +8,7 @@
 struct Offset
 {
     Vector2<int> position;
+    int screenRow {0};  /// With word wrap on, the screen row of the wrapped layout at the top of the window
     
     constexpr Offset() noexcept = default;
 };
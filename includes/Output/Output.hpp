@@ -0,0 +1,59 @@
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+/// \brief Non-blocking output of whole frames to the terminal
+/// \details A frame is written as far as the terminal accepts it without blocking, and the rest is kept until the
+/// \details terminal is writable again. A frame that has started to go out is always finished, since cutting it short
+/// \details would leave an escape sequence half written, but a frame that is still waiting its turn is replaced by
+/// \details any newer one. A terminal that can't keep up therefore skips frames instead of stalling the editor.
+class Output
+{
+public:
+    /// \brief Write to the terminal that @p fd refers to
+    /// \details The terminal is opened a second time, with O_NONBLOCK. Setting O_NONBLOCK on @p fd itself would
+    /// \details also affect stdin, which usually shares the same open file description. If @p fd is not a terminal,
+    /// \details or cannot be reopened, it is written to as it is.
+    explicit Output(int fd) noexcept;
+    ~Output();
+    Output(Output const&) = delete;
+    Output& operator=(Output const&) = delete;
+
+    /// \brief Queue a frame, replacing any frame that is still waiting its turn, and write as much as fits
+    /// \throws std::system_error If writing to the terminal fails
+    void submit(std::string frame);
+
+    /// \brief Write as much of the pending output as the terminal accepts; call it whenever fd() is writable
+    /// \throws std::system_error If writing to the terminal fails
+    void flush();
+
+    /// \brief Finish writing the frame that has started to go out, waiting at most @p timeout for the terminal
+    /// \details The frame waiting its turn, if any, is dropped
+    void finish(std::chrono::milliseconds timeout) noexcept;
+
+    /// \returns Whether there is output the terminal hasn't accepted yet
+    [[nodiscard]]
+    bool pending() const noexcept;
+
+    /// \returns The file descriptor to poll for writability while output is pending
+    [[nodiscard]]
+    int fd() const noexcept { return m_fd; }
+
+    /// \returns The number of frames replaced by a newer one before any of them was written
+    [[nodiscard]]
+    std::size_t dropped() const noexcept { return m_dropped; }
+
+private:
+    int m_fd;
+    bool m_owned {false};       /// Whether m_fd was opened by this object, and must be closed by it
+    std::string m_current;      /// The frame being written
+    std::size_t m_written {0};  /// How much of m_current the terminal has accepted
+    std::string m_next;         /// The newest frame, waiting for m_current to be finished
+    bool m_hasNext {false};
+    std::size_t m_dropped {0};
+};
+
+#endif
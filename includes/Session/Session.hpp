@@ -0,0 +1,64 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include "Buffer/Buffer.hpp"
+#include "Compressed/Compressed.hpp"
+#include "LineIndex/LineIndex.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+
+/// \brief Identifies a version of a file; if any of these change, the file may have been rewritten
+struct FileStamp
+{
+    std::uint64_t size {0};
+    std::int64_t mtime {0};     /// Nanoseconds since the epoch
+    std::uint64_t inode {0};
+    std::uint64_t device {0};
+
+    /// \throws std::system_error If the file cannot be examined
+    [[nodiscard]]
+    static FileStamp of(std::filesystem::path const& path);
+
+    bool operator==(FileStamp const&) const = default;
+};
+
+/// \brief What the editor remembers about a file between runs: where it was in the file, and the file's line index
+/// \details A session is kept in a binary sidecar file in a cache directory, one per file edited. The sidecar is
+/// \details memory-mapped when it is read, and the line index is used in place, so restoring the session of a file
+/// \details takes the same time whatever the size of the file. For a compressed file, the sidecar also keeps the seek
+/// \details index, zlib-compressed, so that the file can be opened in the middle without decompressing all before it.
+struct Session
+{
+    FileStamp stamp;        /// The version of the file the index describes
+    Position cursor {};
+    Position offset {};     /// The scroll position of the window, as in Offset
+    LineIndex index;
+    std::shared_ptr<SeekIndex> seekIndex {};    /// The complete seek index of the file, if it is compressed
+
+    /// \returns The sidecar in which the session of @p file is kept, or nothing if sessions aren't kept
+    /// \details Sidecars live in $KILO_SESSION_DIR, $XDG_CACHE_HOME/kilo or ~/.cache/kilo, whichever is set first.
+    /// \details Setting KILO_SESSION_DIR to an empty string turns sessions off.
+    [[nodiscard]]
+    static std::optional<std::filesystem::path> sidecarFor(std::filesystem::path const& file);
+
+    /// \brief Read the session of @p file from @p sidecar, and bring its index up to date with the file
+    /// \details If the file has grown since the session was saved, only the tail appended to it is indexed. If it has
+    /// \details changed in any other way, the index is dropped but the position is kept. The seek index is only kept
+    /// \details if the file is unchanged.
+    /// \returns The session, or nothing if the sidecar is missing or invalid, or the file cannot be examined
+    [[nodiscard]]
+    static std::optional<Session> restore(std::filesystem::path const& file, std::filesystem::path const& sidecar);
+
+    /// \brief Write the session to @p sidecar, replacing it atomically
+    /// \throws std::system_error If the sidecar cannot be written
+    void save(std::filesystem::path const& sidecar) const;
+
+    /// \returns The index of the rows of @p buffer, whose text must be that of the file it was loaded from
+    [[nodiscard]]
+    static LineIndex indexOf(Buffer const& buffer);
+};
+
+#endif
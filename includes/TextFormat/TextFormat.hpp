@@ -0,0 +1,98 @@
+#ifndef TEXT_FORMAT_HPP
+#define TEXT_FORMAT_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// \brief How the lines of a file are ended
+enum class LineEnding { LF, CRLF, CR };
+
+/// \brief How the text of a file is encoded; rows are always held as UTF-8, whatever the file's encoding
+enum class Encoding { Utf8, Latin1 };
+
+/// \brief The on-disk format of a text file, which is detected when it is read and kept when it is written back
+struct TextFormat
+{
+    /// \brief The UTF-8 byte order mark, which some Windows programs start files with
+    static constexpr std::string_view Bom { "\xef\xbb\xbf" };
+
+    LineEnding lineEnding {LineEnding::LF};
+    Encoding encoding {Encoding::Utf8};
+    bool bom {false};
+
+    /// \brief Detect the line endings and byte order mark of a text from its start
+    /// \param start The start of the text; the first line ending in it decides the line endings of the whole text
+    /// \param complete Whether @p start is the whole text, and so whether a '\r' ending it is a line ending of its own
+    /// \details The encoding can't be told from the start alone; it is left as UTF-8, for Utf8Validator to check
+    [[nodiscard]]
+    static TextFormat detect(std::string_view start, bool complete) noexcept;
+
+    /// \returns The line terminator written between rows
+    [[nodiscard]]
+    std::string_view terminator() const noexcept;
+
+    /// \returns A short description of the format for the status bar, or an empty one for plain UTF-8 with LF
+    [[nodiscard]]
+    std::string describe() const;
+
+    bool operator==(TextFormat const&) const = default;
+};
+
+/// \brief Checks that a text is valid UTF-8, a piece at a time
+/// \details The text is checked 16 bytes at a time with SSSE3 where the CPU has it, using the lookup tables of
+/// \details Keiser and Lemire's "Validating UTF-8 In Less Than One Instruction Per Byte", which runs at memory speed.
+/// \details Elsewhere it falls back to a byte-at-a-time state machine. Either way, a character may be split between
+/// \details two pieces.
+class Utf8Validator
+{
+public:
+    Utf8Validator() noexcept;
+
+    /// \brief Check the next piece of the text
+    /// \returns Whether no invalid UTF-8 has been found so far; the end of a piece may only be checked with the next
+    bool feed(std::string_view text) noexcept;
+
+    /// \returns Whether the whole text fed so far is valid UTF-8; the validator is then ready for a new text
+    [[nodiscard]]
+    bool finish() noexcept;
+
+private:
+    bool m_simd;
+    bool m_valid {true};
+
+    // The vectorised check works on whole 16-byte blocks, and looks back up to 3 bytes into the previous one
+    std::array<std::uint8_t, 16> m_pending {};
+    std::size_t m_pendingSize {0};
+    std::array<std::uint8_t, 16> m_previous {};
+    std::array<std::uint8_t, 16> m_error {};
+    std::array<std::uint8_t, 16> m_incomplete {};
+
+    // The state of the state machine: how many continuation bytes are still due, and the range the next one must be in
+    int m_needed {0};
+    std::uint8_t m_lower {0x80};
+    std::uint8_t m_upper {0xbf};
+
+    void feedBlocks(std::uint8_t const* data, std::size_t blocks) noexcept;
+    void feedBytes(std::string_view text) noexcept;
+};
+
+namespace utf8
+{
+    /// \returns @p text, taken as Latin-1, in UTF-8
+    [[nodiscard]]
+    std::string fromLatin1(std::string_view text);
+
+    /// \brief Convert @p text from UTF-8 to Latin-1, appending it to @p out
+    /// \returns Whether every character of @p text is in Latin-1, i.e. below U+0100
+    [[nodiscard]]
+    bool toLatin1(std::string_view text, std::string& out);
+
+    /// \returns The number of characters in @p text, counting every byte that isn't a continuation byte
+    [[nodiscard]]
+    std::size_t length(std::string_view text) noexcept;
+}
+
+#endif
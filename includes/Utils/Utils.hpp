@@ -1,6 +1,10 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <cstddef>
+#include <string>
+#include <string_view>
+
 /**
  * @brief Perform low-level keypress handling
  * 
@@ -9,4 +13,48 @@
 [[nodiscard]]
 int readKey();
 
+/**
+ * @brief Wait for the next byte of input
+ * 
+ * @return unsigned char The byte read
+ */
+[[nodiscard]]
+unsigned char readByte();
+
+/**
+ * @brief Decode the key that begins with a given byte, reading the rest of its escape sequence if it has one
+ * 
+ * @param first The first byte of the key, as returned by readByte
+ * @return int The character input by the user
+ */
+[[nodiscard]]
+int decodeKey(unsigned char first);
+
+/**
+ * @brief Decode the key at a given offset of some input, as readKey would decode it were that input all the terminal
+ * had sent; running out of input is taken as the read timer expiring
+ * 
+ * @param input The bytes sent by the terminal
+ * @param[in,out] pos The offset of the key in @p input, which must be less than its size; moved past the key
+ * @return int The character input by the user
+ */
+[[nodiscard]]
+int decodeKey(std::string_view input, std::size_t& pos);
+
+/**
+ * @brief Check for input that has been read from the terminal but not yet decoded, e.g. keys typed right after a paste
+ * 
+ * @return bool Whether readByte can return without waiting for the terminal
+ */
+[[nodiscard]]
+bool inputPending() noexcept;
+
+/**
+ * @brief Read the rest of a bracketed paste, once decodeKey has returned Key::Paste
+ * 
+ * @return std::string The pasted text, with every line terminator turned into '\n'
+ */
+[[nodiscard]]
+std::string readPaste();
+
 #endif
\ No newline at end of file
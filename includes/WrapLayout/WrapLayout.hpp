@@ -0,0 +1,81 @@
+#ifndef WRAP_LAYOUT_HPP
+#define WRAP_LAYOUT_HPP
+
+#include "Buffer/Buffer.hpp"
+
+#include <vector>
+
+/// \brief Lays the rows of a buffer out on screen rows of a fixed width, wrapping the rows that are wider
+/// \details A row of length n takes up ceil(n / width) screen rows, and at least one. The heights of the rows are kept
+/// \details in a Fenwick tree, so the screen row a buffer row starts on, and the buffer row a screen row shows, are
+/// \details both found in O(log n) however long the file is.
+/// \details The layout is told which rows each change to the buffer touched, and lays out only those again: a row
+/// \details changed in place, or appended or dropped at the end, updates the tree in O(log n). Rows inserted or erased
+/// \details in the middle rebuild the part of the tree for the rows after them in linear time. A change of width wraps
+/// \details again only the rows wider than the narrower width, from the lengths already known, without reading any
+/// \details text, and rebuilds the tree.
+class WrapLayout
+{
+public:
+    /// \brief Changes to more rows than this rebuild the tree rather than update it a row at a time
+    static constexpr int Incremental = 16;
+
+    /// \brief Lay out every row of @p buffer on screen rows @p width columns wide
+    void rebuild(Buffer const& buffer, int width);
+
+    /// \brief Lay out again the rows that changed, as reported by Buffer::onRowsChanged
+    void update(Buffer const& buffer, int y, int removed, int inserted);
+
+    /// \brief Lay the rows out on screen rows @p width columns wide instead
+    void setWidth(int width);
+
+    /// \returns The width of the screen rows
+    [[nodiscard]]
+    int width() const noexcept { return m_width; }
+
+    /// \returns The number of screen rows the whole buffer takes up
+    [[nodiscard]]
+    int screenRows() const noexcept { return m_total; }
+
+    /// \returns The number of screen rows row @p y takes up; one for the row just past the end of the buffer
+    [[nodiscard]]
+    int height(int y) const noexcept;
+
+    /// \returns The screen row that row @p y starts on; screenRows() for the row just past the end of the buffer
+    [[nodiscard]]
+    int screenRow(int y) const noexcept;
+
+    /// \returns The part of the buffer screen row @p row shows, as the row and the column it starts at; past the last
+    /// \returns screen row, the start of the row just past the end of the buffer
+    [[nodiscard]]
+    Position locate(int row) const noexcept;
+
+    /// \returns The part of the buffer shown on the screen row after the one @p at starts
+    [[nodiscard]]
+    Position next(Position at) const noexcept;
+
+    /// \returns Where @p at is on screen, as a column and a screen row; a position past the end of its row's last
+    /// \returns screen row is kept on that screen row
+    [[nodiscard]]
+    Position place(Position at) const noexcept;
+
+private:
+    int m_width {1};
+    int m_total {0};
+    std::vector<int> m_lengths;     /// The length of each row
+    std::vector<int> m_heights;     /// The number of screen rows each row takes up
+    std::vector<int> m_tree {0};    /// The Fenwick tree of the rows' heights, indexed from 1
+
+    [[nodiscard]]
+    int heightOf(int length) const noexcept;
+
+    [[nodiscard]]
+    int prefix(int rows) const noexcept;
+
+    void build(int from);
+    void set(int y, int length);
+    void push(int length);
+    void pop();
+};
+
+#endif
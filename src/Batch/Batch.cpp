@@ -0,0 +1,335 @@
+#include "Batch/Batch.hpp"
+#include "Commands/Commands.hpp"
+#include "Cursor/Cursor.hpp"
+#include "Keys/Keys.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+
+#include <fmt/core.h>
+
+namespace
+{
+    /// Line number standing in for "the last line" in a goto command
+    constexpr int LastLine = -1;
+
+    /// \brief Replace the escape sequences "\n", "\t" and "\\" with the characters they stand for
+    [[nodiscard]]
+    std::string unescape(std::string_view text)
+    {
+        std::string result;
+        result.reserve(text.size());
+
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (text[i] != '\\' or i + 1 == text.size()) {
+                result += text[i];
+                continue;
+            }
+
+            switch (text[++i]) {
+                case 'n':
+                    result += '\n';
+                    break;
+
+                case 't':
+                    result += '\t';
+                    break;
+
+                default:
+                    result += text[i];
+                    break;
+            }
+        }
+
+        return result;
+    }
+
+    /// \brief Split off the first whitespace-delimited word of @p line
+    [[nodiscard]]
+    std::string_view nextWord(std::string_view& line)
+    {
+        auto const start = line.find_first_not_of(" \t");
+
+        if (start == std::string_view::npos) {
+            line = {};
+            return {};
+        }
+
+        line.remove_prefix(start);
+
+        auto const end = std::min(line.find_first_of(" \t"), line.size());
+        auto const word = line.substr(0, end);
+        line.remove_prefix(end);
+
+        return word;
+    }
+
+    /// \brief Parse a positive number, or return @p fallback if @p word is empty
+    /// \throws std::invalid_argument If @p word is not a positive number
+    [[nodiscard]]
+    int parseNumber(std::string_view word, int fallback)
+    {
+        if (word.empty()) {
+            return fallback;
+        }
+
+        int value {};
+        auto const [end, err] = std::from_chars(word.data(), word.data() + word.size(), value);
+
+        if (err != std::errc {} or end != word.data() + word.size() or value < 1) {
+            throw std::invalid_argument(fmt::format("expected a positive number, got '{}'", word));
+        }
+
+        return value;
+    }
+}
+
+/**
+ * @brief Parse a batch-editing script
+ * @param in The stream to read the script from
+ * @return The parsed script
+ *
+ * The whole script is parsed up front so that a typo is reported before any file is touched.
+*/
+Script Script::parse(std::istream& in)
+{
+    static std::unordered_map<std::string_view, Op> const ops {
+        { "goto", Op::Goto }, { "up", Op::Up }, { "down", Op::Down }, { "left", Op::Left }, { "right", Op::Right },
+        { "home", Op::Home }, { "end", Op::End }, { "insert", Op::Insert }, { "newline", Op::Newline },
+        { "delete", Op::Delete }, { "backspace", Op::Backspace }, { "deleteline", Op::DeleteLine },
+        { "replace", Op::Replace },
+    };
+
+    Script script;
+    std::string text;
+
+    for (int lineNumber = 1; std::getline(in, text); ++lineNumber) {
+        std::string_view line { text };
+        auto const word = nextWord(line);
+
+        if (word.empty() or word.front() == '#') {
+            continue;
+        }
+
+        try {
+            auto const op = ops.find(word);
+
+            if (op == ops.end()) {
+                throw std::invalid_argument(fmt::format("unknown command '{}'", word));
+            }
+
+            Instruction instruction { op->second };
+
+            switch (instruction.op) {
+                case Op::Goto: {
+                    auto const row = nextWord(line);
+
+                    if (row.empty()) {
+                        throw std::invalid_argument("goto needs a line number");
+                    }
+
+                    instruction.at.y = row == "$" ? LastLine : parseNumber(row, 1) - 1;
+                    instruction.at.x = parseNumber(nextWord(line), 1) - 1;
+                    break;
+                }
+
+                case Op::Insert:
+                    // Everything after the single separating space is text, including any further whitespace
+                    instruction.text = unescape(line.empty() ? line : line.substr(1));
+                    line = {};
+                    break;
+
+                case Op::Replace: {
+                    line.remove_prefix(std::min(line.find_first_not_of(" \t"), line.size()));
+
+                    if (line.size() < 3) {
+                        throw std::invalid_argument("replace needs /<from>/<to>/");
+                    }
+
+                    auto const delimiter = line.front();
+                    auto const middle = line.find(delimiter, 1);
+                    auto const last = middle == std::string_view::npos ? middle : line.find(delimiter, middle + 1);
+
+                    if (last == std::string_view::npos) {
+                        throw std::invalid_argument("replace needs /<from>/<to>/");
+                    }
+
+                    instruction.text = unescape(line.substr(1, middle - 1));
+                    instruction.replacement = unescape(line.substr(middle + 1, last - middle - 1));
+                    line.remove_prefix(last + 1);
+
+                    if (instruction.text.empty() or instruction.text.find('\n') != std::string::npos
+                        or instruction.replacement.find('\n') != std::string::npos) {
+                        throw std::invalid_argument("replace patterns must be non-empty and on a single line");
+                    }
+
+                    break;
+                }
+
+                default:
+                    instruction.count = parseNumber(nextWord(line), 1);
+                    break;
+            }
+
+            if (not nextWord(line).empty()) {
+                throw std::invalid_argument(fmt::format("too many arguments to '{}'", word));
+            }
+
+            script.m_instructions.push_back(std::move(instruction));
+        }
+        catch (std::invalid_argument const& err) {
+            throw std::invalid_argument(fmt::format("line {}: {}", lineNumber, err.what()));
+        }
+    }
+
+    return script;
+}
+
+void Script::apply(Buffer& buffer) const
+{
+    Cursor cursor {};
+
+    auto const repeat = [](int count, auto&& command) {
+        for (; count > 0; --count) {
+            command();
+        }
+    };
+
+    for (auto const& instruction : m_instructions) {
+        switch (instruction.op) {
+            case Op::Goto: {
+                auto at = instruction.at;
+
+                if (at.y == LastLine) {
+                    at.y = std::max(buffer.size() - 1, 0);
+                }
+
+                commands::moveTo(buffer, cursor, at);
+                break;
+            }
+
+            case Op::Up:
+                repeat(instruction.count, [&] { cursor.moveCursor(Key::ArrowUp, buffer); });
+                break;
+
+            case Op::Down:
+                repeat(instruction.count, [&] { cursor.moveCursor(Key::ArrowDown, buffer); });
+                break;
+
+            case Op::Left:
+                repeat(instruction.count, [&] { cursor.moveCursor(Key::ArrowLeft, buffer); });
+                break;
+
+            case Op::Right:
+                repeat(instruction.count, [&] { cursor.moveCursor(Key::ArrowRight, buffer); });
+                break;
+
+            case Op::Home:
+                commands::moveHome(cursor);
+                break;
+
+            case Op::End:
+                commands::moveEnd(buffer, cursor);
+                break;
+
+            case Op::Insert:
+                commands::insertText(buffer, cursor, instruction.text);
+                break;
+
+            case Op::Newline:
+                repeat(instruction.count, [&] { commands::insertNewline(buffer, cursor); });
+                break;
+
+            case Op::Delete:
+                repeat(instruction.count, [&] { commands::deleteForward(buffer, cursor); });
+                break;
+
+            case Op::Backspace:
+                repeat(instruction.count, [&] { commands::deleteBackward(buffer, cursor); });
+                break;
+
+            case Op::DeleteLine:
+                commands::deleteRows(buffer, cursor, instruction.count);
+                break;
+
+            case Op::Replace:
+                commands::replaceAll(buffer, instruction.text, instruction.replacement);
+                break;
+        }
+    }
+}
+
+/**
+ * @brief Apply a script to a list of files
+ * @param script The path to the script
+ * @param files The files to edit in place; "-" or an empty list edits stdin onto stdout
+ * @return EXIT_SUCCESS if every file was edited, EXIT_FAILURE otherwise
+ *
+ * A file that cannot be edited is reported and skipped, and the remaining files are still edited.
+*/
+int runBatch(std::filesystem::path const& script, std::vector<std::filesystem::path> const& files)
+{
+    std::ifstream scriptFile { script };
+
+    if (not scriptFile) {
+        fmt::print(stderr, "Could not open script {}.\n", script.string());
+        return EXIT_FAILURE;
+    }
+
+    Script parsed;
+
+    try {
+        parsed = Script::parse(scriptFile);
+    }
+    catch (std::invalid_argument const& err) {
+        fmt::print(stderr, "{}: {}\n", script.string(), err.what());
+        return EXIT_FAILURE;
+    }
+
+    if (files.empty() or (files.size() == 1 and files.front() == "-")) {
+        std::ios::sync_with_stdio(false);
+
+        Buffer buffer;
+        buffer.keepHistory(false);
+        buffer.load(std::cin);
+        parsed.apply(buffer);
+
+        try {
+            buffer.save(std::cout);
+        }
+        catch (std::system_error const& err) {
+            fmt::print(stderr, "{}\n", err.what());
+            return EXIT_FAILURE;
+        }
+
+        return std::cout.flush() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    Buffer buffer;
+    buffer.keepHistory(false);
+
+    for (auto const& file : files) {
+        try {
+            buffer.open(file);
+            parsed.apply(buffer);
+
+            if (buffer.dirty()) {
+                buffer.save(file);
+            }
+        }
+        catch (std::system_error const& err) {
+            fmt::print(stderr, "{}\n", err.what());
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
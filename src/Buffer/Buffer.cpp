@@ -0,0 +1,1043 @@
+#include "Buffer/Buffer.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <tuple>
+
+namespace
+{
+    /// How much of the file is read at a time while the first screen is loaded
+    constexpr std::size_t FirstScreenChunk = 16 * 1024;
+
+    /// How much of the start of a file its line endings are detected from
+    constexpr std::size_t DetectChunk = 4 * 1024;
+
+    /**
+     * @brief Create the temporary file a save is written to, with the owner and mode of the file it is to replace
+     * @param temporary The path of the temporary file
+     * @param original The status of the file to replace
+     * @returns Whether the temporary file was created with the same owner and mode as @p original
+    */
+    bool createLike(std::filesystem::path const& temporary, struct stat const& original) noexcept
+    {
+        // Readable by nobody else until it has the mode of the original
+        int const fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+        if (fd < 0) {
+            return false;
+        }
+
+        bool const sameOwner = original.st_uid == ::geteuid() and original.st_gid == ::getegid();
+
+        // The owner is changed first, since changing it clears the set-user-ID and set-group-ID bits
+        bool const kept = (sameOwner or ::fchown(fd, original.st_uid, original.st_gid) == 0)
+            and ::fchmod(fd, original.st_mode & 07777) == 0;
+
+        ::close(fd);
+        return kept;
+    }
+}
+
+/**
+ * @brief Replace the contents of the buffer with the text read from a stream
+ * @param in The stream to read from
+ *
+ * The whole stream is read in one go and then split into rows, which is considerably faster than std::getline.
+*/
+void Buffer::load(std::istream& in)
+{
+    std::string text { std::istreambuf_iterator<char> { in }, std::istreambuf_iterator<char> {} };
+
+    reset();
+    m_format = TextFormat::detect(text, true);
+
+    if (m_format.bom) {
+        text.erase(0, TextFormat::Bom.size());
+    }
+
+    m_validator.feed(text);
+
+    if (not m_validator.finish()) {
+        m_format.encoding = Encoding::Latin1;
+        text = utf8::fromLatin1(text);
+    }
+
+    m_rows.reserve(static_cast<std::size_t>(std::count(text.begin(), text.end(), m_format.terminator().back())) + 1);
+    split(text);
+    flushPartial(true);
+}
+
+void Buffer::open(std::filesystem::path const& path)
+{
+    open(path, 0);
+    loadAll();
+}
+
+/**
+ * @brief Open a file, but only read as much of it as is needed to show its first rows
+ * @param path The file to open
+ * @param rows How many rows to read now
+ *
+ * The file is read in small chunks until @p rows rows are complete, so the cost doesn't depend on the size of the file.
+*/
+void Buffer::open(std::filesystem::path const& path, int rows)
+{
+    start(path, { { 0, 0, EndOfFile } });
+
+    while (size() < rows and loadMore(FirstScreenChunk)) {
+    }
+}
+
+/**
+ * @brief Open a file at a row in the middle of it, reading only the rows around that one for now
+ * @param path The file to open
+ * @param index The rows of the file, which locates row @p from without reading the rows before it
+ * @param from The first row to read
+ * @param rows How many rows to read now
+ * @param seekIndex The complete seek index of the file, if it is compressed and the index is known
+ *
+ * The buffer is sized to the whole file straight away, so rows and positions are right from the start; the rows not
+ * read yet are empty. The file is then read from row @p from to its end, and finally from its start up to row @p from.
+*/
+void Buffer::open(std::filesystem::path const& path, LineIndex const& index, int from, int rows,
+    std::shared_ptr<SeekIndex> seekIndex)
+{
+    // The size of a compressed file says nothing of the size of its text, so a last row without a '\n' is left to
+    // be appended when it is read
+    from = std::clamp(from, 0, index.rows());
+
+    if (from == 0) {
+        start(path, { { 0, 0, EndOfFile } }, std::move(seekIndex));
+    }
+    else {
+        start(path, { { from, index.start(from), EndOfFile }, { 0, 0, index.start(from) } }, std::move(seekIndex));
+    }
+
+    m_rows.resize(static_cast<std::size_t>(index.rows()));
+    changed(0, 0, size());
+
+    for (auto const ranges = m_ranges.size(); m_ranges.size() == ranges and m_loadRow < from + rows; ) {
+        if (not loadMore(FirstScreenChunk)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Read the next chunk of the file being loaded
+ * @param bytes The most bytes to read
+ * @return Whether there is more of the file left to read
+*/
+bool Buffer::loadMore(std::size_t bytes)
+{
+    if (not loading()) {
+        return false;
+    }
+
+    auto const& range = m_ranges.front();
+    auto const wanted = std::min<std::uint64_t>(bytes, range.end - m_loadPos);
+
+    std::string chunk(static_cast<std::size_t>(wanted), '\0');
+
+    try {
+        m_source->read(chunk.data(), static_cast<std::streamsize>(wanted));
+    }
+    catch (std::system_error const&) {
+        // Stop at what could be read; the rest of the file is out of reach
+        m_ranges.clear();
+        m_partial.clear();
+        m_source.reset();
+        throw;
+    }
+
+    chunk.resize(static_cast<std::size_t>(m_source->gcount()));
+    m_loadPos += chunk.size();
+
+    if (m_format.encoding == Encoding::Utf8 and not m_validator.feed(chunk)) {
+        fallBackToLatin1();
+    }
+
+    split(m_format.encoding == Encoding::Latin1 ? utf8::fromLatin1(chunk) : chunk);
+
+    if (chunk.size() < wanted or m_loadPos == range.end) {
+        nextRange();
+    }
+
+    return loading();
+}
+
+void Buffer::loadAll()
+{
+    while (loadMore(LoadChunk)) {
+    }
+}
+
+bool Buffer::loading() const noexcept
+{
+    return not m_ranges.empty();
+}
+
+std::shared_ptr<SeekIndex> Buffer::seekIndex() const noexcept
+{
+    return m_seekIndex and m_seekIndex->complete ? m_seekIndex : nullptr;
+}
+
+void Buffer::reset()
+{
+    auto const rows = size();
+
+    m_rows.clear();
+    m_partial.clear();
+    m_ranges.clear();
+    m_compression = Compression::None;
+    m_seekIndex.reset();
+    m_loadRow = 0;
+    m_endsWithNewline = true;
+    m_format = {};
+    m_validator = {};
+    m_dirty = false;
+    m_undo.clear();
+    m_redo.clear();
+
+    m_source.reset();
+
+    changed(0, rows, 0);
+}
+
+/**
+ * @brief Start loading a file
+ * @param path The file to load
+ * @param ranges The parts of the file to read, in the order to read them in
+ * @param seekIndex The complete seek index of the file, if it is compressed and the index is known; otherwise one is
+ * recorded as the file is read
+*/
+void Buffer::start(std::filesystem::path const& path, std::vector<Range> ranges, std::shared_ptr<SeekIndex> seekIndex)
+{
+    auto const compression = compressed::detect(path);
+
+    if (compression != Compression::None and not (seekIndex and seekIndex->complete)) {
+        seekIndex = std::make_shared<SeekIndex>();
+    }
+
+    auto source = compressed::openForReading(path, compression, seekIndex);
+
+    reset();
+    m_source = std::move(source);
+    m_compression = compression;
+    m_seekIndex = compression != Compression::None ? std::move(seekIndex) : nullptr;
+    m_ranges = std::move(ranges);
+
+    // The format is told from the start of the file, wherever reading starts
+    std::string start(DetectChunk, '\0');
+    m_source->read(start.data(), static_cast<std::streamsize>(start.size()));
+    start.resize(static_cast<std::size_t>(m_source->gcount()));
+    m_format = TextFormat::detect(start, start.size() < DetectChunk);
+
+    seek();
+}
+
+/// \brief Position the file at the start of the range to be read next, skipping the byte order mark
+void Buffer::seek()
+{
+    auto const& range = m_ranges.front();
+    auto const begin = m_format.bom ? std::max<std::uint64_t>(range.begin, TextFormat::Bom.size()) : range.begin;
+
+    m_source->clear();
+    m_source->seekg(static_cast<std::streamoff>(begin));
+    m_loadPos = begin;
+    m_loadRow = range.row;
+}
+
+/// \brief Finish reading the current range, and move on to the next one, if there is one
+void Buffer::nextRange()
+{
+    // Ranges start and end on row boundaries, so each is checked as a text of its own
+    if (not m_validator.finish() and m_format.encoding == Encoding::Utf8) {
+        fallBackToLatin1();
+    }
+
+    flushPartial(m_ranges.front().end == EndOfFile);
+    m_ranges.erase(m_ranges.begin());
+
+    if (m_ranges.empty()) {
+        m_source.reset();
+    }
+    else {
+        seek();
+    }
+}
+
+/**
+ * @brief Add the rows in a piece of text to the buffer
+ * @param text The next piece of the text being loaded
+ *
+ * The piece may start or end in the middle of a row; the end of an unfinished row is kept until the next piece
+ * finishes it, or until the range being read ends. Rows are split on the last character of the line terminator, so
+ * with CRLF line endings the '\r' is then dropped from the end of the row, if it is there.
+*/
+void Buffer::split(std::string_view text)
+{
+    auto const terminator = m_format.terminator().back();
+    auto const crlf = m_format.lineEnding == LineEnding::CRLF;
+
+    auto const unterminated = [crlf](std::string_view row) {
+        if (crlf and row.ends_with('\r')) {
+            row.remove_suffix(1);
+        }
+
+        return row;
+    };
+
+    auto eol = text.find(terminator);
+
+    if (eol == std::string_view::npos) {
+        m_partial += text;
+        return;
+    }
+
+    m_partial += text.substr(0, eol);
+    emit(unterminated(m_partial));
+    m_partial.clear();
+    text.remove_prefix(eol + 1);
+
+    for (eol = text.find(terminator); eol != std::string_view::npos; eol = text.find(terminator)) {
+        emit(unterminated(text.substr(0, eol)));
+        text.remove_prefix(eol + 1);
+    }
+
+    m_partial = text;
+}
+
+/// \brief Store the next row read, either in its place in a buffer sized up front, or at the end
+void Buffer::emit(std::string_view row)
+{
+    if (m_loadRow < size()) {
+        m_rows[static_cast<std::size_t>(m_loadRow)] = row;
+        changed(m_loadRow, 1, 1);
+    }
+    else {
+        m_rows.emplace_back(row);
+        changed(m_loadRow, 0, 1);
+    }
+
+    ++m_loadRow;
+}
+
+/**
+ * @brief Take the file being loaded to be Latin-1 after all, once it turns out not to be valid UTF-8
+ *
+ * The rows read so far hold the bytes of the file as they are, so they are converted now; the rest are converted as
+ * they are read.
+*/
+void Buffer::fallBackToLatin1()
+{
+    m_format.encoding = Encoding::Latin1;
+
+    auto const ascii = [](std::string_view text) {
+        return std::none_of(text.begin(), text.end(), [](char c) { return (static_cast<unsigned char>(c) & 0x80) != 0; });
+    };
+
+    for (auto& row : m_rows) {
+        if (not ascii(row)) {
+            row = utf8::fromLatin1(row);
+        }
+    }
+
+    m_partial = utf8::fromLatin1(m_partial);
+    changed(0, size(), size());
+}
+
+/// \brief Store the row left unfinished at the end of a range; at the end of the file, it is a row without a '\n'
+void Buffer::flushPartial(bool endOfFile)
+{
+    if (endOfFile) {
+        m_endsWithNewline = m_partial.empty();
+    }
+
+    if (not m_partial.empty()) {
+        emit(m_partial);
+        m_partial.clear();
+    }
+}
+
+/// \brief The bytes of the file the rows make up, in the format it was read in
+std::string Buffer::encoded() const
+{
+    auto const terminator = m_format.terminator();
+    std::string text;
+
+    if (m_format.bom) {
+        text += TextFormat::Bom;
+    }
+
+    for (std::size_t y = 0; y < m_rows.size(); ++y) {
+        if (m_format.encoding == Encoding::Utf8) {
+            text += m_rows[y];
+        }
+        else if (not utf8::toLatin1(m_rows[y], text)) {
+            throw std::system_error(std::make_error_code(std::errc::illegal_byte_sequence),
+                "Row " + std::to_string(y + 1) + " has characters that can't be saved as Latin-1");
+        }
+
+        text += terminator;
+    }
+
+    if (not m_endsWithNewline and not m_rows.empty()) {
+        text.resize(text.size() - terminator.size());
+    }
+
+    return text;
+}
+
+void Buffer::save(std::ostream& out) const
+{
+    auto const text = encoded();
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+/**
+ * @brief Write the contents of the buffer to a file
+ * @param path The file to write, which may be a symbolic link to it
+ *
+ * The text is written to a temporary file next to the file, which is given the file's owner and mode and then renamed
+ * over it, so a failed save leaves the file as it was. A symbolic link is followed, and the file it points to replaced,
+ * rather than the link itself. When the file can't be replaced by one like it, e.g. because its directory isn't
+ * writable, it belongs to someone else, or it has other hard links, it is rewritten where it is instead.
+ *
+ * The text is encoded before any file is opened, so text the encoding can't hold leaves no file behind, and the
+ * temporary file is removed whenever it can't be written in full.
+*/
+void Buffer::save(std::filesystem::path const& path)
+{
+    loadAll();
+
+    auto const text = encoded();
+    auto const write = [this, &text](std::filesystem::path const& file) {
+        auto const outFile = compressed::openForWriting(file, m_compression);
+        outFile->write(text.data(), static_cast<std::streamsize>(text.size()));
+
+        if (not outFile->flush()) {
+            throw std::system_error(errno, std::generic_category(), "Could not write file " + file.string());
+        }
+    };
+
+    std::error_code err;
+    auto target = std::filesystem::weakly_canonical(path, err);
+
+    if (err) {
+        target = path;
+    }
+
+    auto temporary = target;
+    temporary += ".kilo-save";
+
+    struct stat original {};
+
+    if (::stat(target.c_str(), &original) == 0 and (original.st_nlink > 1 or not createLike(temporary, original))) {
+        std::filesystem::remove(temporary, err);
+        write(target);
+
+        m_dirty = false;
+        m_seekIndex.reset();
+        return;
+    }
+
+    try {
+        write(temporary);
+    }
+    catch (...) {
+        std::filesystem::remove(temporary, err);
+        throw;
+    }
+
+    std::filesystem::rename(temporary, target, err);
+
+    if (err) {
+        std::filesystem::remove(temporary, err);
+        throw std::system_error(err, "Could not replace file " + path.string());
+    }
+
+    m_dirty = false;
+    m_seekIndex.reset();
+}
+
+int Buffer::size() const noexcept
+{
+    return static_cast<int>(m_rows.size());
+}
+
+std::string_view Buffer::row(int y) const noexcept
+{
+    if (y < 0 or y >= size()) {
+        return {};
+    }
+
+    return m_rows[static_cast<std::size_t>(y)];
+}
+
+int Buffer::rowLength(int y) const noexcept
+{
+    return static_cast<int>(row(y).size());
+}
+
+std::uint64_t Buffer::rowBytes(int y) const noexcept
+{
+    auto const text = row(y);
+    std::uint64_t bytes = m_format.encoding == Encoding::Latin1 ? utf8::length(text) : text.size();
+
+    if (y == 0 and m_format.bom) {
+        bytes += TextFormat::Bom.size();
+    }
+
+    return bytes + m_format.terminator().size();
+}
+
+std::string Buffer::text(Position from, Position to) const
+{
+    from = clamp(from);
+    to = clamp(to);
+
+    if (std::tie(to.y, to.x) < std::tie(from.y, from.x)) {
+        std::swap(from, to);
+    }
+
+    if (from.y == to.y) {
+        return std::string { row(from.y).substr(static_cast<std::size_t>(from.x), static_cast<std::size_t>(to.x - from.x)) };
+    }
+
+    std::string result { row(from.y).substr(static_cast<std::size_t>(from.x)) };
+
+    for (int y = from.y + 1; y < to.y; ++y) {
+        result += '\n';
+        result += row(y);
+    }
+
+    result += '\n';
+    result += row(to.y).substr(0, static_cast<std::size_t>(to.x));
+
+    return result;
+}
+
+/**
+ * @brief Insert text into the buffer
+ * @param at Where to insert the text; clamped to the buffer
+ * @param text The text to insert, which may span several rows
+ * @return The position just after the inserted text
+ *
+ * All new rows are inserted into the row vector at once, so the cost is independent of how many rows @p text spans.
+*/
+Position Buffer::insert(Position at, std::string_view text)
+{
+    loadAll();
+    at = clamp(at);
+
+    if (text.empty()) {
+        return at;
+    }
+
+    bool const appendedRow = at.y == size();
+    auto const end = applyInsert(at, text);
+
+    if (m_keepHistory) {
+        record({ Edit::Kind::Insert, at, end, std::string { text }, appendedRow, m_entry });
+    }
+
+    return end;
+}
+
+Position Buffer::applyInsert(Position at, std::string_view text)
+{
+    if (at.y == size()) {
+        m_rows.emplace_back();
+        changed(at.y, 0, 1);
+    }
+
+    m_dirty = true;
+    ++m_edits;
+
+    auto const y = static_cast<std::size_t>(at.y);
+    auto const x = static_cast<std::size_t>(at.x);
+    auto const eol = text.find('\n');
+
+    if (eol == std::string_view::npos) {
+        m_rows[y].insert(x, text);
+        changed(at.y, 1, 1);
+        return { at.x + static_cast<int>(text.size()), at.y };
+    }
+
+    // Split the row at the insertion point; the first line of text ends the row, and the last one begins its tail
+    std::string tail = m_rows[y].substr(x);
+    m_rows[y].replace(x, std::string::npos, text.substr(0, eol));
+
+    std::vector<std::string> rows;
+    text.remove_prefix(eol + 1);
+
+    for (auto next = text.find('\n'); next != std::string_view::npos; next = text.find('\n')) {
+        rows.emplace_back(text.substr(0, next));
+        text.remove_prefix(next + 1);
+    }
+
+    Position const end { static_cast<int>(text.size()), at.y + static_cast<int>(rows.size()) + 1 };
+
+    rows.emplace_back(text);
+    rows.back() += tail;
+
+    m_rows.insert(m_rows.begin() + static_cast<std::ptrdiff_t>(y + 1),
+        std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+    changed(at.y, 1, end.y - at.y + 1);
+
+    return end;
+}
+
+/**
+ * @brief Erase a range of text
+ * @param from The start of the range; clamped to the buffer
+ * @param to The end of the range, exclusive; clamped to the buffer
+*/
+void Buffer::erase(Position from, Position to)
+{
+    loadAll();
+    from = clamp(from);
+    to = clamp(to);
+
+    if (std::tie(to.y, to.x) < std::tie(from.y, from.x)) {
+        std::swap(from, to);
+    }
+
+    // The row past the end is empty and has no line terminator to erase, so a range reaching it ends with the last row;
+    // otherwise the text recorded for undo would end with a '\n', and undoing the erase would add a row
+    if (to.y == size() and from.y < size()) {
+        to = { rowLength(size() - 1), size() - 1 };
+    }
+
+    if (from.y == size() or (from.y == to.y and from.x == to.x)) {
+        return;
+    }
+
+    if (m_keepHistory) {
+        record({ Edit::Kind::Erase, from, to, text(from, to), false, m_entry });
+    }
+
+    applyErase(from, to);
+}
+
+void Buffer::applyErase(Position from, Position to)
+{
+    m_dirty = true;
+    ++m_edits;
+
+    auto const y = static_cast<std::size_t>(from.y);
+
+    if (from.y == to.y) {
+        m_rows[y].erase(static_cast<std::size_t>(from.x), static_cast<std::size_t>(to.x - from.x));
+        changed(from.y, 1, 1);
+        return;
+    }
+
+    // Keep the head of the first row and the tail of the last, and drop every row in between
+    m_rows[y].resize(static_cast<std::size_t>(from.x));
+    m_rows[y] += row(to.y).substr(static_cast<std::size_t>(to.x));
+
+    auto const last = std::min(to.y, size() - 1);
+    m_rows.erase(m_rows.begin() + from.y + 1, m_rows.begin() + last + 1);
+    changed(from.y, last - from.y + 1, 1);
+}
+
+void Buffer::eraseRows(int y, int count)
+{
+    loadAll();
+    y = std::clamp(y, 0, size());
+    count = std::clamp(count, 0, size() - y);
+
+    if (count == 0) {
+        return;
+    }
+
+    if (m_keepHistory) {
+        record({ Edit::Kind::EraseRows, { 0, y }, { 0, count }, text({ 0, y }, { rowLength(y + count - 1), y + count - 1 }), false, m_entry });
+    }
+
+    applyEraseRows(y, count);
+}
+
+void Buffer::applyEraseRows(int y, int count)
+{
+    m_dirty = true;
+    ++m_edits;
+    m_rows.erase(m_rows.begin() + y, m_rows.begin() + y + count);
+    changed(y, count, 0);
+}
+
+/**
+ * @brief Make many replacements as a single edit
+ * @param splices The replacements, in order and not overlapping; their positions are clamped to the buffer
+ * @return Where the text of each splice ends once they have all been made
+ *
+ * Made one at a time, each replacement would move the rows after it, and every replacement after it would have to be
+ * moved in turn. Instead the rows the splices span are rebuilt once, so the cost is linear in the size of those rows
+ * and of the text inserted, whatever the number of splices.
+*/
+std::vector<Position> Buffer::splice(std::vector<Splice> splices)
+{
+    loadAll();
+
+    for (auto& [from, to, text] : splices) {
+        from = clamp(from);
+        to = clamp(to);
+
+        if (std::tie(to.y, to.x) < std::tie(from.y, from.x)) {
+            std::swap(from, to);
+        }
+    }
+
+    auto const unchanged = [](Splice const& splice) {
+        return splice.from.x == splice.to.x and splice.from.y == splice.to.y and splice.text.empty();
+    };
+
+    std::vector<Position> ends;
+    ends.reserve(splices.size());
+
+    if (std::all_of(splices.begin(), splices.end(), unchanged)) {
+        for (auto const& splice : splices) {
+            ends.push_back(splice.from);
+        }
+
+        return ends;
+    }
+
+    // Only a splice that changes something past the last row needs a row to be appended for it
+    std::size_t unchangedPastEnd = 0;
+
+    while (splices.back().from.y == size() and unchanged(splices.back())) {
+        splices.pop_back();
+        ++unchangedPastEnd;
+    }
+
+    bool const appendedRow = splices.back().to.y == size();
+
+    if (appendedRow) {
+        m_rows.emplace_back();
+        changed(size() - 1, 0, 1);
+    }
+
+    auto inverse = applySplices(splices, m_keepHistory);
+
+    for (auto const& splice : inverse) {
+        ends.push_back(splice.to);
+    }
+
+    // The splices left out end where the one before them does if that one reaches the row past the end too, since
+    // they touch; otherwise nothing after the one before them has changed, and they end where they began
+    auto const pastEnd = appendedRow ? ends.back() : Position { 0, size() };
+    ends.insert(ends.end(), unchangedPastEnd, pastEnd);
+
+    if (m_keepHistory) {
+        auto const from = splices.front().from;
+        record({ Edit::Kind::Splice, from, from, {}, appendedRow, m_entry, std::move(splices), std::move(inverse) });
+    }
+
+    return ends;
+}
+
+/**
+ * @brief Make the replacements of a splice
+ * @param splices The replacements, in order, not overlapping and within the buffer
+ * @param keepText Whether to keep the text each replacement erases, in order to revert it later
+ * @return The replacements that revert @p splices
+ *
+ * Replacements within single rows rebuild each row they touch once, in place. Otherwise the rows from the first
+ * replacement to the last are rebuilt into a new run of rows, which takes their place in one go.
+*/
+std::vector<Buffer::Splice> Buffer::applySplices(std::vector<Splice> const& splices, bool keepText)
+{
+    m_dirty = true;
+    ++m_edits;
+
+    std::vector<Splice> inverse;
+    inverse.reserve(splices.size());
+
+    auto const erased = [this, keepText](Splice const& splice) {
+        return keepText ? text(splice.from, splice.to) : std::string {};
+    };
+
+    auto const withinRow = [](Splice const& splice) {
+        return splice.from.y == splice.to.y and splice.text.find('\n') == std::string::npos;
+    };
+
+    if (std::all_of(splices.begin(), splices.end(), withinRow)) {
+        std::string rebuilt;
+
+        for (std::size_t i = 0; i < splices.size(); ) {
+            auto const y = splices[i].from.y;
+            std::string_view const row { m_rows[static_cast<std::size_t>(y)] };
+            std::size_t start = 0;
+            int shift = 0;
+
+            rebuilt.clear();
+
+            for (; i < splices.size() and splices[i].from.y == y; ++i) {
+                auto const& [from, to, text] = splices[i];
+                Position const begin { from.x + shift, y };
+
+                rebuilt.append(row.substr(start, static_cast<std::size_t>(from.x) - start));
+                rebuilt.append(text);
+                inverse.push_back({ begin, { begin.x + static_cast<int>(text.size()), y }, erased(splices[i]) });
+
+                shift += static_cast<int>(text.size()) - (to.x - from.x);
+                start = static_cast<std::size_t>(to.x);
+            }
+
+            rebuilt.append(row.substr(start));
+            m_rows[static_cast<std::size_t>(y)].swap(rebuilt);
+            changed(y, 1, 1);
+        }
+
+        return inverse;
+    }
+
+    auto const first = splices.front().from.y;
+    auto const last = splices.back().to.y;
+
+    auto const removed = last - first + 1;
+    auto rebuilt = static_cast<std::size_t>(removed);
+
+    for (auto const& splice : splices) {
+        rebuilt += static_cast<std::size_t>(std::count(splice.text.begin(), splice.text.end(), '\n'));
+    }
+
+    // Rows rebuilt over most of the buffer are rebuilt along with the rest of it, so that every row is moved once
+    bool const whole = 2 * removed >= size();
+    auto const before = whole ? static_cast<std::size_t>(first) : 0;
+    auto const after = whole ? static_cast<std::size_t>(size() - last - 1) : 0;
+
+    std::vector<std::string> rows;
+    rows.reserve(before + rebuilt + after);
+    std::move(m_rows.begin(), m_rows.begin() + static_cast<std::ptrdiff_t>(before), std::back_inserter(rows));
+
+    std::string line { row(first).substr(0, static_cast<std::size_t>(splices.front().from.x)) };
+    auto at = splices.front().from;
+
+    for (auto const& splice : splices) {
+        // Carry over the text between the previous replacement and this one, moving the rows in between whole
+        auto& resumed = m_rows[static_cast<std::size_t>(at.y)];
+
+        if (at.y == splice.from.y) {
+            line.append(resumed, static_cast<std::size_t>(at.x), static_cast<std::size_t>(splice.from.x - at.x));
+        }
+        else {
+            line.append(resumed, static_cast<std::size_t>(at.x));
+            rows.push_back(std::move(line));
+
+            for (auto y = at.y + 1; y < splice.from.y; ++y) {
+                rows.push_back(std::move(m_rows[static_cast<std::size_t>(y)]));
+            }
+
+            line.assign(row(splice.from.y).substr(0, static_cast<std::size_t>(splice.from.x)));
+        }
+
+        Position const begin { static_cast<int>(line.size()), first + static_cast<int>(rows.size() - before) };
+        auto erasedText = erased(splice);
+        std::string_view text { splice.text };
+
+        for (auto eol = text.find('\n'); eol != std::string_view::npos; eol = text.find('\n')) {
+            line.append(text.substr(0, eol));
+            rows.push_back(std::move(line));
+            line.clear();
+            text.remove_prefix(eol + 1);
+        }
+
+        line.append(text);
+        Position const end { static_cast<int>(line.size()), first + static_cast<int>(rows.size() - before) };
+        inverse.push_back({ begin, end, std::move(erasedText) });
+        at = splice.to;
+    }
+
+    line.append(row(at.y).substr(static_cast<std::size_t>(at.x)));
+    rows.push_back(std::move(line));
+
+    auto const inserted = static_cast<int>(rows.size() - before);
+
+    if (whole) {
+        std::move(m_rows.begin() + last + 1, m_rows.end(), std::back_inserter(rows));
+        m_rows.swap(rows);
+    }
+    else {
+        auto const common = std::min(removed, inserted);
+
+        std::move(rows.begin(), rows.begin() + common, m_rows.begin() + first);
+
+        if (inserted > removed) {
+            m_rows.insert(m_rows.begin() + first + common, std::make_move_iterator(rows.begin() + common), std::make_move_iterator(rows.end()));
+        }
+        else {
+            m_rows.erase(m_rows.begin() + first + common, m_rows.begin() + first + removed);
+        }
+    }
+
+    changed(first, removed, inserted);
+
+    return inverse;
+}
+
+bool Buffer::dirty() const noexcept
+{
+    return m_dirty;
+}
+
+void Buffer::checkpoint() noexcept
+{
+    ++m_entry;
+}
+
+/**
+ * @brief Revert the edits of the most recent undo entry, newest first
+ * @return Where the first of the reverted edits began
+*/
+std::optional<Position> Buffer::undo()
+{
+    if (m_undo.empty()) {
+        return std::nullopt;
+    }
+
+    auto const entry = m_undo.back().entry;
+    Position at {};
+
+    while (not m_undo.empty() and m_undo.back().entry == entry) {
+        auto& edit = m_undo.back();
+        at = edit.from;
+
+        switch (edit.kind) {
+            case Edit::Kind::Insert:
+                applyErase(edit.from, edit.to);
+
+                if (edit.appendedRow) {
+                    m_rows.pop_back();
+                    changed(size(), 1, 0);
+                }
+
+                break;
+
+            case Edit::Kind::Erase:
+                applyInsert(edit.from, edit.text);
+                break;
+
+            case Edit::Kind::EraseRows: {
+                // Put the rows back as they were, rather than splitting a neighbouring row to make room for them
+                std::vector<std::string> rows;
+                std::string_view rest { edit.text };
+
+                for (auto eol = rest.find('\n'); eol != std::string_view::npos; eol = rest.find('\n')) {
+                    rows.emplace_back(rest.substr(0, eol));
+                    rest.remove_prefix(eol + 1);
+                }
+
+                rows.emplace_back(rest);
+                m_rows.insert(m_rows.begin() + edit.from.y, std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+                changed(edit.from.y, 0, static_cast<int>(rows.size()));
+                m_dirty = true;
+                ++m_edits;
+                break;
+            }
+
+            case Edit::Kind::Splice:
+                applySplices(edit.inverse, false);
+
+                if (edit.appendedRow) {
+                    m_rows.pop_back();
+                    changed(size(), 1, 0);
+                }
+
+                break;
+        }
+
+        m_redo.push_back(std::move(edit));
+        m_undo.pop_back();
+    }
+
+    return at;
+}
+
+/**
+ * @brief Reapply the edits of the most recently undone entry, oldest first
+ * @return Where the first of the reapplied edits began
+*/
+std::optional<Position> Buffer::redo()
+{
+    if (m_redo.empty()) {
+        return std::nullopt;
+    }
+
+    auto const entry = m_redo.back().entry;
+    auto const at = m_redo.back().from;
+
+    while (not m_redo.empty() and m_redo.back().entry == entry) {
+        auto& edit = m_redo.back();
+
+        switch (edit.kind) {
+            case Edit::Kind::Insert:
+                applyInsert(edit.from, edit.text);
+                break;
+
+            case Edit::Kind::Erase:
+                applyErase(edit.from, edit.to);
+                break;
+
+            case Edit::Kind::EraseRows:
+                applyEraseRows(edit.from.y, edit.to.y);
+                break;
+
+            case Edit::Kind::Splice:
+                if (edit.appendedRow) {
+                    m_rows.emplace_back();
+                    changed(size() - 1, 0, 1);
+                }
+
+                applySplices(edit.splices, false);
+                break;
+        }
+
+        m_undo.push_back(std::move(edit));
+        m_redo.pop_back();
+    }
+
+    return at;
+}
+
+void Buffer::keepHistory(bool keep) noexcept
+{
+    m_keepHistory = keep;
+
+    if (not keep) {
+        m_undo.clear();
+        m_redo.clear();
+    }
+}
+
+/// \details Callers check m_keepHistory first, so that no copy of the text is made when it is off
+void Buffer::record(Edit edit)
+{
+    m_undo.push_back(std::move(edit));
+    m_redo.clear();
+}
+
+void Buffer::changed(int y, int removed, int inserted) const
+{
+    if (m_rowsChanged) {
+        m_rowsChanged(y, removed, inserted);
+    }
+}
+
+Position Buffer::clamp(Position at) const noexcept
+{
+    at.y = std::clamp(at.y, 0, size());
+    at.x = std::clamp(at.x, 0, rowLength(at.y));
+
+    return at;
+}
@@ -0,0 +1,256 @@
+#include "Commands/Commands.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    [[nodiscard]]
+    bool isWordChar(char c) noexcept
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) or c == '_';
+    }
+
+    /// \brief Clamp every cursor to the buffer, so that the edits made at them don't overlap
+    void clampAll(Buffer const& buffer, CursorSet& cursors)
+    {
+        cursors.moveEach([&buffer](Cursor& cursor) { commands::moveTo(buffer, cursor, cursor.position()); });
+    }
+
+    /// \brief Make the splice that @p edit makes at each cursor, and move each cursor to where its splice ends
+    /// \details The buffer reports where every splice ends once they have all been made, so the cursors are moved in
+    /// \details one pass, rather than each edit moving every cursor after it.
+    template <typename Edit>
+    void spliceAll(Buffer& buffer, CursorSet& cursors, Edit edit)
+    {
+        clampAll(buffer, cursors);
+
+        std::vector<Buffer::Splice> splices;
+        splices.reserve(cursors.size());
+
+        for (auto const& cursor : cursors) {
+            splices.push_back(edit(cursor.position()));
+        }
+
+        auto const ends = buffer.splice(std::move(splices));
+        std::size_t i = 0;
+
+        cursors.moveEach([&ends, &i](Cursor& cursor) { cursor.moveTo(ends[i++]); });
+    }
+}
+
+namespace commands
+{
+    void insertText(Buffer& buffer, Cursor& cursor, std::string_view text)
+    {
+        cursor.moveTo(buffer.insert(cursor.position(), text));
+    }
+
+    void insertNewline(Buffer& buffer, Cursor& cursor)
+    {
+        insertText(buffer, cursor, "\n");
+    }
+
+    void deleteBackward(Buffer& buffer, Cursor& cursor)
+    {
+        auto const at = cursor.position();
+
+        if (at.x > 0) {
+            buffer.erase({ at.x - 1, at.y }, at);
+            cursor.xPos--;
+        }
+        else if (at.y > 0) {
+            Position const end { buffer.rowLength(at.y - 1), at.y - 1 };
+
+            buffer.erase(end, at);
+            cursor.moveTo(end);
+        }
+    }
+
+    void deleteForward(Buffer& buffer, Cursor& cursor)
+    {
+        auto const at = cursor.position();
+
+        if (at.x < buffer.rowLength(at.y)) {
+            buffer.erase(at, { at.x + 1, at.y });
+        }
+        else {
+            buffer.erase(at, { 0, at.y + 1 });
+        }
+    }
+
+    void deleteRows(Buffer& buffer, Cursor& cursor, int count)
+    {
+        buffer.eraseRows(cursor.yPos, count);
+        moveTo(buffer, cursor, { 0, cursor.yPos });
+    }
+
+    void insertText(Buffer& buffer, CursorSet& cursors, std::string_view text)
+    {
+        if (cursors.size() == 1) {
+            insertText(buffer, cursors.primary(), text);
+            return;
+        }
+
+        spliceAll(buffer, cursors, [text](Position at) { return Buffer::Splice { at, at, std::string { text } }; });
+    }
+
+    void insertNewline(Buffer& buffer, CursorSet& cursors)
+    {
+        insertText(buffer, cursors, "\n");
+    }
+
+    void deleteBackward(Buffer& buffer, CursorSet& cursors)
+    {
+        if (cursors.size() == 1) {
+            deleteBackward(buffer, cursors.primary());
+            return;
+        }
+
+        spliceAll(buffer, cursors, [&buffer](Position at) {
+            if (at.x > 0) {
+                return Buffer::Splice { { at.x - 1, at.y }, at, {} };
+            }
+            else if (at.y > 0) {
+                return Buffer::Splice { { buffer.rowLength(at.y - 1), at.y - 1 }, at, {} };
+            }
+
+            return Buffer::Splice { at, at, {} };
+        });
+    }
+
+    void deleteForward(Buffer& buffer, CursorSet& cursors)
+    {
+        if (cursors.size() == 1) {
+            deleteForward(buffer, cursors.primary());
+            return;
+        }
+
+        // The splices end where the text deleted began, which is where the cursors stay
+        spliceAll(buffer, cursors, [&buffer](Position at) {
+            if (at.x < buffer.rowLength(at.y)) {
+                return Buffer::Splice { at, { at.x + 1, at.y }, {} };
+            }
+            else if (at.y + 1 < buffer.size()) {
+                return Buffer::Splice { at, { 0, at.y + 1 }, {} };
+            }
+
+            return Buffer::Splice { at, at, {} };
+        });
+    }
+
+    /// \details The buffer is searched a row at a time for the word, which only counts where it isn't part of a
+    /// \details longer word
+    std::size_t cursorsAtWord(Buffer const& buffer, CursorSet& cursors)
+    {
+        auto const at = cursors.primary().position();
+        auto const row = buffer.row(at.y);
+        auto start = static_cast<std::size_t>(std::clamp(at.x, 0, static_cast<int>(row.size())));
+        auto end = start;
+
+        while (start > 0 and isWordChar(row[start - 1])) {
+            --start;
+        }
+
+        while (end < row.size() and isWordChar(row[end])) {
+            ++end;
+        }
+
+        if (start == end) {
+            return 0;
+        }
+
+        auto const word = row.substr(start, end - start);
+        auto const offset = at.x - static_cast<int>(start);
+
+        std::vector<Position> positions;
+        std::size_t primary = 0;
+
+        for (int y = 0; y < buffer.size(); ++y) {
+            auto const text = buffer.row(y);
+
+            for (auto hit = text.find(word); hit != std::string_view::npos; hit = text.find(word, hit + word.size())) {
+                auto const after = hit + word.size();
+
+                if ((hit > 0 and isWordChar(text[hit - 1])) or (after < text.size() and isWordChar(text[after]))) {
+                    continue;
+                }
+
+                if (y == at.y and hit == start) {
+                    primary = positions.size();
+                }
+
+                positions.push_back({ static_cast<int>(hit) + offset, y });
+            }
+        }
+
+        cursors.assign(positions, primary);
+
+        return positions.size();
+    }
+
+    void moveHome(Cursor& cursor) noexcept
+    {
+        cursor.xPos = 0;
+    }
+
+    void moveEnd(Buffer const& buffer, Cursor& cursor) noexcept
+    {
+        cursor.xPos = buffer.rowLength(cursor.yPos);
+    }
+
+    void moveTo(Buffer const& buffer, Cursor& cursor, Position at) noexcept
+    {
+        at.y = std::clamp(at.y, 0, buffer.size());
+        at.x = std::clamp(at.x, 0, buffer.rowLength(at.y));
+
+        cursor.moveTo(at);
+    }
+
+    void moveRows(Buffer const& buffer, Folds const& folds, CursorSet& cursors, int count)
+    {
+        cursors.moveEach([&buffer, &folds, count](Cursor& cursor) {
+            auto const y = std::min(folds.step(cursor.yPos, count), buffer.size());
+            moveTo(buffer, cursor, { cursor.xPos, folds.visible(y) });
+        });
+    }
+
+    /// \details Each row is rebuilt at most once, however many occurrences it holds
+    std::size_t replaceAll(Buffer& buffer, std::string_view from, std::string_view to)
+    {
+        if (from.empty()) {
+            return 0;
+        }
+
+        std::size_t replaced = 0;
+        std::string rebuilt;
+
+        for (int y = 0; y < buffer.size(); ++y) {
+            auto const row = buffer.row(y);
+
+            if (row.find(from) == std::string_view::npos) {
+                continue;
+            }
+
+            rebuilt.clear();
+            std::size_t start = 0;
+
+            for (auto hit = row.find(from); hit != std::string_view::npos; hit = row.find(from, start)) {
+                rebuilt.append(row.substr(start, hit - start));
+                rebuilt.append(to);
+                start = hit + from.size();
+                ++replaced;
+            }
+
+            rebuilt.append(row.substr(start));
+
+            buffer.erase({ 0, y }, { buffer.rowLength(y), y });
+            buffer.insert({ 0, y }, rebuilt);
+        }
+
+        return replaced;
+    }
+}
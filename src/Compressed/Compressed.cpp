@@ -0,0 +1,746 @@
+#include "Compressed/Compressed.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <new>
+#include <system_error>
+
+#include <fmt/core.h>
+
+namespace
+{
+    /// \brief How far back deflate may refer, and so how much text a gzip access point keeps
+    constexpr std::size_t WindowSize = 32 * 1024;
+
+    constexpr std::size_t InputChunk = 64 * 1024;
+    constexpr std::size_t OutputChunk = 64 * 1024;
+
+    /// \brief zlib's windowBits for a stream with a gzip or zlib header, whichever it finds, and for bare deflate data
+    constexpr int AutoHeader = 15 + 32;
+    constexpr int RawDeflate = -15;
+
+    /// \brief The CRC and length that end a gzip member, after its deflate data
+    constexpr unsigned GzipTrailer = 8;
+
+    constexpr std::array<unsigned char, 2> GzipMagic { 0x1f, 0x8b };
+    constexpr std::array<unsigned char, 4> ZstdMagic { 0x28, 0xb5, 0x2f, 0xfd };
+
+    template <typename Reader>
+    class DecompressingInput final : public std::istream
+    {
+    public:
+        DecompressingInput(std::filesystem::path const& path, std::shared_ptr<SeekIndex> index)
+            : std::istream { nullptr }
+            , m_reader { path, std::move(index) }
+        {
+            rdbuf(&m_reader);
+
+            // Let the error of a corrupt file through to the reader, rather than pass it off as the end of the text
+            exceptions(std::ios::badbit);
+        }
+
+    private:
+        Reader m_reader;
+    };
+
+    template <typename Writer>
+    class CompressingOutput final : public std::ostream
+    {
+    public:
+        explicit CompressingOutput(std::filesystem::path const& path)
+            : std::ostream { nullptr }
+            , m_writer { path }
+        {
+            rdbuf(&m_writer);
+        }
+
+    private:
+        Writer m_writer;
+    };
+}
+
+SeekableReader::SeekableReader(std::filesystem::path const& path, std::shared_ptr<SeekIndex> index)
+    : m_path { path }
+    , m_file { path, std::ios::binary }
+    , m_index { index ? std::move(index) : std::make_shared<SeekIndex>() }
+{
+    if (not m_file) {
+        throw std::system_error(errno, std::generic_category(), "Could not open file " + path.string());
+    }
+}
+
+/**
+ * @brief Make the block holding the current position the get area
+ *
+ * If the position is past the text indexed so far, the indexer reads on up to it, caching the blocks it passes.
+*/
+SeekableReader::int_type SeekableReader::underflow()
+{
+    if (gptr() != egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    detach();
+    auto const pos = m_blockStart;
+    auto const& points = m_index->points;
+
+    while (not m_index->complete and pos >= points.back().out) {
+        indexAndRemember();
+    }
+
+    if (pos >= points.back().out) {
+        return traits_type::eof();
+    }
+
+    auto const after = std::upper_bound(points.begin(), points.end(), pos, [](std::uint64_t offset, SeekIndex::AccessPoint const& point) {
+        return offset < point.out;
+    });
+    auto const point = static_cast<std::size_t>(after - points.begin()) - 1;
+
+    // The cached text is never written to; the get area just doesn't come in a const flavour
+    auto& text = const_cast<std::string&>(block(point).text);
+
+    m_blockStart = points[point].out;
+    setg(text.data(), text.data() + (pos - m_blockStart), text.data() + text.size());
+
+    return traits_type::to_int_type(*gptr());
+}
+
+/// \details A seek past the end of the text fails, leaving the stream where it was
+SeekableReader::pos_type SeekableReader::seekoff(off_type off, std::ios::seekdir dir, std::ios::openmode which)
+{
+    if ((which & std::ios::in) == 0) {
+        return pos_type { off_type { -1 } };
+    }
+
+    auto const& points = m_index->points;
+    off_type base = 0;
+
+    if (dir == std::ios::cur) {
+        base = static_cast<off_type>(position());
+    }
+    else if (dir == std::ios::end) {
+        detach();
+
+        while (not m_index->complete) {
+            indexAndRemember();
+        }
+
+        base = static_cast<off_type>(points.back().out);
+    }
+
+    if (base + off < 0) {
+        return pos_type { off_type { -1 } };
+    }
+
+    auto const target = static_cast<std::uint64_t>(base + off);
+
+    if (target > points.back().out) {
+        detach();
+
+        while (not m_index->complete and target > points.back().out) {
+            indexAndRemember();
+        }
+
+        if (target > points.back().out) {
+            return pos_type { off_type { -1 } };
+        }
+    }
+
+    moveTo(target);
+    return pos_type { base + off };
+}
+
+SeekableReader::pos_type SeekableReader::seekpos(pos_type pos, std::ios::openmode which)
+{
+    return seekoff(off_type { pos }, std::ios::beg, which);
+}
+
+std::uint64_t SeekableReader::position() const noexcept
+{
+    return m_blockStart + static_cast<std::uint64_t>(gptr() - eback());
+}
+
+/// \brief Move to @p pos, within the get area if it holds @p pos, and otherwise leave it to underflow to find
+void SeekableReader::moveTo(std::uint64_t pos) noexcept
+{
+    auto const size = static_cast<std::uint64_t>(egptr() - eback());
+
+    if (eback() != nullptr and pos >= m_blockStart and pos < m_blockStart + size) {
+        setg(eback(), eback() + (pos - m_blockStart), egptr());
+    }
+    else {
+        m_blockStart = pos;
+        setg(nullptr, nullptr, nullptr);
+    }
+}
+
+/// \brief Let go of the get area, keeping the position, before the block it is in may be evicted from the cache
+void SeekableReader::detach() noexcept
+{
+    m_blockStart = position();
+    setg(nullptr, nullptr, nullptr);
+}
+
+/// \brief Decompress the next block with the indexer, and cache it
+void SeekableReader::indexAndRemember()
+{
+    // indexNext records the access point after the block, so the block's own must be taken first
+    auto const point = m_index->points.size() - 1;
+    remember(point, indexNext());
+}
+
+/// \returns The block that starts at access point @p point, from the cache if it is there
+SeekableReader::Block const& SeekableReader::block(std::size_t point)
+{
+    auto const cached = std::find_if(m_cache.begin(), m_cache.end(), [point](Block const& block) {
+        return block.point == point;
+    });
+
+    if (cached == m_cache.end()) {
+        return remember(point, decompress(point));
+    }
+
+    m_cache.splice(m_cache.begin(), m_cache, cached);
+    return m_cache.front();
+}
+
+/// \brief Cache the block that starts at access point @p point, evicting the least recently used blocks to make room
+SeekableReader::Block const& SeekableReader::remember(std::size_t point, std::string text)
+{
+    m_cachedBytes += text.size();
+    m_cache.push_front({ point, std::move(text) });
+
+    while (m_cachedBytes > CacheBytes and m_cache.size() > 1) {
+        m_cachedBytes -= m_cache.back().text.size();
+        m_cache.pop_back();
+    }
+
+    return m_cache.front();
+}
+
+std::size_t SeekableReader::read(std::uint64_t offset, unsigned char* data, std::size_t size)
+{
+    m_file.clear();
+    m_file.seekg(static_cast<std::streamoff>(offset));
+    m_file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+
+    if (m_file.bad()) {
+        throw std::system_error(errno, std::generic_category(), "Could not read file " + m_path.string());
+    }
+
+    return static_cast<std::size_t>(m_file.gcount());
+}
+
+void SeekableReader::corrupt(char const* reason) const
+{
+    throw std::system_error(std::make_error_code(std::errc::illegal_byte_sequence),
+        fmt::format("Could not decompress file {}: {}", m_path.string(), reason));
+}
+
+GzipReader::GzipReader(std::filesystem::path const& path, std::shared_ptr<SeekIndex> index)
+    : SeekableReader { path, std::move(index) }
+    , m_indexerInput(InputChunk)
+{
+    if (::inflateInit2(&m_indexer, AutoHeader) != Z_OK) {
+        throw std::bad_alloc {};
+    }
+}
+
+GzipReader::~GzipReader()
+{
+    ::inflateEnd(&m_indexer);
+}
+
+/**
+ * @brief Decompress the block that starts at the last access point, and record the access point that ends it
+ * @returns The text of the block
+ *
+ * The indexer stops at every deflate block boundary to check whether a Span's worth of text has been decompressed
+ * since the last access point. At the end of the file, the last access point marks the end of the text instead.
+*/
+std::string GzipReader::indexNext()
+{
+    auto& points = this->points();
+    std::string text;
+
+    auto const refill = [this] {
+        if (m_indexer.avail_in == 0) {
+            auto const count = read(m_indexerRead, m_indexerInput.data(), m_indexerInput.size());
+            m_indexerRead += count;
+            m_indexer.next_in = m_indexerInput.data();
+            m_indexer.avail_in = static_cast<uInt>(count);
+        }
+
+        return m_indexer.avail_in > 0;
+    };
+
+    // A file that ends early is read up to where it ends, as gzip does
+    while (refill()) {
+        auto const before = text.size();
+        text.resize(before + OutputChunk);
+        m_indexer.next_out = reinterpret_cast<Bytef*>(text.data() + before);
+        m_indexer.avail_out = static_cast<uInt>(OutputChunk);
+
+        auto const rv = ::inflate(&m_indexer, Z_BLOCK);
+        text.resize(before + OutputChunk - m_indexer.avail_out);
+
+        if (rv == Z_STREAM_END) {
+            // Another gzip member may follow; anything else after the end of a member is ignored, as gzip does
+            if (not refill() or m_indexer.next_in[0] != GzipMagic[0]) {
+                break;
+            }
+
+            ::inflateReset(&m_indexer);
+            continue;
+        }
+        else if (rv != Z_OK and rv != Z_BUF_ERROR) {
+            corrupt(m_indexer.msg ? m_indexer.msg : "invalid data");
+        }
+
+        bool const boundary = (m_indexer.data_type & 128) != 0 and (m_indexer.data_type & 64) == 0;
+
+        if (boundary and text.size() >= Span) {
+            points.push_back({
+                points.back().out + text.size(),
+                m_indexerRead - m_indexer.avail_in,
+                m_indexer.data_type & 7,
+                0,
+                { text.end() - WindowSize, text.end() },
+            });
+
+            return text;
+        }
+    }
+
+    points.push_back({ points.back().out + text.size(), m_indexerRead, 0, 0, {} });
+    index()->complete = true;
+
+    return text;
+}
+
+/**
+ * @brief Decompress the block that starts at access point @p point again, once it has dropped out of the cache
+ *
+ * Except at the start of the file, decompression restarts in the middle of a gzip member, on bare deflate data; the
+ * bits of its first block that share a byte with the previous block are primed first. If the block runs on into the
+ * next member, that member is read with its header as usual.
+*/
+std::string GzipReader::decompress(std::size_t point)
+{
+    auto const& start = points()[point];
+    std::string text(static_cast<std::size_t>(points()[point + 1].out - start.out), '\0');
+
+    z_stream stream {};
+    bool raw = point > 0;
+
+    if (::inflateInit2(&stream, raw ? RawDeflate : AutoHeader) != Z_OK) {
+        throw std::bad_alloc {};
+    }
+
+    std::unique_ptr<z_stream, decltype(&::inflateEnd)> const end { &stream, &::inflateEnd };
+
+    if (start.bits > 0) {
+        unsigned char byte = 0;
+
+        if (read(start.in - 1, &byte, 1) != 1) {
+            corrupt("unexpected end of file");
+        }
+
+        ::inflatePrime(&stream, start.bits, byte >> (8 - start.bits));
+    }
+
+    if (not start.window.empty()) {
+        ::inflateSetDictionary(&stream, start.window.data(), static_cast<uInt>(start.window.size()));
+    }
+
+    std::vector<unsigned char> input(InputChunk);
+    auto offset = start.in;
+    unsigned skip = 0;
+
+    stream.next_out = reinterpret_cast<Bytef*>(text.data());
+    stream.avail_out = static_cast<uInt>(text.size());
+
+    while (stream.avail_out > 0) {
+        if (stream.avail_in == 0) {
+            auto const count = read(offset, input.data(), input.size());
+
+            // The file has changed since it was indexed
+            if (count == 0) {
+                corrupt("unexpected end of file");
+            }
+
+            offset += count;
+            stream.next_in = input.data();
+            stream.avail_in = static_cast<uInt>(count);
+        }
+
+        if (skip > 0) {
+            auto const skipped = std::min(skip, stream.avail_in);
+            stream.next_in += skipped;
+            stream.avail_in -= skipped;
+            skip -= skipped;
+            continue;
+        }
+
+        auto const rv = ::inflate(&stream, Z_NO_FLUSH);
+
+        if (rv == Z_STREAM_END) {
+            // Bare deflate data stops short of the member's trailer, which a member read with its header checks
+            skip = raw ? GzipTrailer : 0;
+            raw = false;
+            ::inflateReset2(&stream, AutoHeader);
+        }
+        else if (rv != Z_OK and rv != Z_BUF_ERROR) {
+            corrupt(stream.msg ? stream.msg : "invalid data");
+        }
+    }
+
+    return text;
+}
+
+ZstdReader::ZstdReader(std::filesystem::path const& path, std::shared_ptr<SeekIndex> index)
+    : SeekableReader { path, std::move(index) }
+    , m_indexer { ::ZSTD_createDCtx() }
+    , m_indexerInput(InputChunk)
+{
+    if (m_indexer == nullptr) {
+        throw std::bad_alloc {};
+    }
+}
+
+ZstdReader::~ZstdReader()
+{
+    ::ZSTD_freeDCtx(m_indexer);
+}
+
+/**
+ * @brief Decompress the block that starts at the last access point, and record the access point that ends it
+ * @returns The text of the block
+ *
+ * A block ends at the end of the first frame that takes it past Span, or, in a frame that runs on, once it reaches
+ * twice Span; it then ends inside the frame, at a point that restarts at the start of the frame. At the end of the
+ * file, the last access point marks the end of the text instead.
+*/
+std::string ZstdReader::indexNext()
+{
+    auto& points = this->points();
+    auto const start = points.back().out;
+    std::string text;
+
+    auto const refill = [this] {
+        if (m_indexerIn.pos == m_indexerIn.size) {
+            auto const count = read(m_indexerRead, m_indexerInput.data(), m_indexerInput.size());
+            m_indexerRead += count;
+            m_indexerIn = { m_indexerInput.data(), count, 0 };
+        }
+
+        return m_indexerIn.pos < m_indexerIn.size;
+    };
+
+    // A file that ends early is read up to where it ends, as for gzip
+    while (refill()) {
+        auto const in = m_indexerRead - (m_indexerIn.size - m_indexerIn.pos);
+
+        if (m_betweenFrames) {
+            m_frameIn = in;
+            m_frameOut = start + text.size();
+            m_betweenFrames = false;
+        }
+
+        auto const before = text.size();
+        text.resize(before + OutputChunk);
+        ZSTD_outBuffer output { text.data() + before, OutputChunk, 0 };
+
+        auto const rv = ::ZSTD_decompressStream(m_indexer, &output, &m_indexerIn);
+        text.resize(before + output.pos);
+
+        if (::ZSTD_isError(rv)) {
+            corrupt(::ZSTD_getErrorName(rv));
+        }
+
+        auto const out = start + text.size();
+
+        if (rv == 0) {
+            m_betweenFrames = true;
+
+            if (text.size() >= Span) {
+                points.push_back({ out, m_indexerRead - (m_indexerIn.size - m_indexerIn.pos), 0, 0, {} });
+                return text;
+            }
+        }
+        else if (text.size() >= 2 * Span) {
+            points.push_back({ out, m_frameIn, 0, out - m_frameOut, {} });
+            return text;
+        }
+    }
+
+    points.push_back({ start + text.size(), m_indexerRead, 0, 0, {} });
+    index()->complete = true;
+
+    return text;
+}
+
+/**
+ * @brief Decompress the block that starts at access point @p point again, once it has dropped out of the cache
+ *
+ * Decompression restarts at the start of a frame, and drops the text up to the access point if it is inside the
+ * frame. The block may run on into the frames after it.
+*/
+std::string ZstdReader::decompress(std::size_t point)
+{
+    auto const& start = points()[point];
+    std::string text(static_cast<std::size_t>(points()[point + 1].out - start.out), '\0');
+
+    std::unique_ptr<ZSTD_DCtx, decltype(&::ZSTD_freeDCtx)> const context { ::ZSTD_createDCtx(), &::ZSTD_freeDCtx };
+
+    if (not context) {
+        throw std::bad_alloc {};
+    }
+
+    std::vector<unsigned char> input(InputChunk);
+    ZSTD_inBuffer in { input.data(), 0, 0 };
+    auto offset = start.in;
+
+    std::string skipped(start.skip > 0 ? OutputChunk : 0, '\0');
+    auto skip = start.skip;
+    std::size_t filled = 0;
+
+    while (filled < text.size()) {
+        if (in.pos == in.size) {
+            auto const count = read(offset, input.data(), input.size());
+
+            // The file has changed since it was indexed
+            if (count == 0) {
+                corrupt("unexpected end of file");
+            }
+
+            offset += count;
+            in = { input.data(), count, 0 };
+        }
+
+        auto output = skip > 0
+            ? ZSTD_outBuffer { skipped.data(), static_cast<std::size_t>(std::min<std::uint64_t>(skip, skipped.size())), 0 }
+            : ZSTD_outBuffer { text.data() + filled, text.size() - filled, 0 };
+
+        auto const rv = ::ZSTD_decompressStream(context.get(), &output, &in);
+
+        if (::ZSTD_isError(rv)) {
+            corrupt(::ZSTD_getErrorName(rv));
+        }
+
+        if (skip > 0) {
+            skip -= output.pos;
+        }
+        else {
+            filled += output.pos;
+        }
+    }
+
+    return text;
+}
+
+GzipWriter::GzipWriter(std::filesystem::path const& path)
+    : m_file { ::gzopen(path.c_str(), "wb") }
+{
+    if (m_file == nullptr) {
+        throw std::system_error(errno, std::generic_category(), "Could not create file " + path.string());
+    }
+}
+
+GzipWriter::~GzipWriter()
+{
+    ::gzclose(m_file);
+}
+
+GzipWriter::int_type GzipWriter::overflow(int_type ch)
+{
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+
+    return ::gzputc(m_file, ch) == -1 ? traits_type::eof() : ch;
+}
+
+std::streamsize GzipWriter::xsputn(char const* data, std::streamsize count)
+{
+    std::streamsize written = 0;
+
+    // gzwrite takes an unsigned length but returns an int, so large writes go in pieces
+    while (written < count) {
+        auto const piece = static_cast<unsigned>(std::min<std::streamsize>(count - written, 1 << 30));
+        auto const rv = ::gzwrite(m_file, data + written, piece);
+
+        if (rv <= 0) {
+            break;
+        }
+
+        written += rv;
+    }
+
+    return written;
+}
+
+/// \details Ends the gzip member, so that a successful flush means the whole file is on disk, trailer and all
+int GzipWriter::sync()
+{
+    return ::gzflush(m_file, Z_FINISH) == Z_OK ? 0 : -1;
+}
+
+ZstdWriter::ZstdWriter(std::filesystem::path const& path)
+    : m_file { path, std::ios::binary | std::ios::trunc }
+    , m_context { ::ZSTD_createCCtx() }
+    , m_output(::ZSTD_CStreamOutSize())
+{
+    if (m_context == nullptr) {
+        throw std::bad_alloc {};
+    }
+
+    if (not m_file) {
+        ::ZSTD_freeCCtx(m_context);
+        throw std::system_error(errno, std::generic_category(), "Could not create file " + path.string());
+    }
+
+    // A checksum in every frame, so that a corrupt file is reported rather than read as the wrong text
+    ::ZSTD_CCtx_setParameter(m_context, ZSTD_c_checksumFlag, 1);
+}
+
+ZstdWriter::~ZstdWriter()
+{
+    sync();
+    ::ZSTD_freeCCtx(m_context);
+}
+
+ZstdWriter::int_type ZstdWriter::overflow(int_type ch)
+{
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+
+    auto const c = traits_type::to_char_type(ch);
+    return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+}
+
+std::streamsize ZstdWriter::xsputn(char const* data, std::streamsize count)
+{
+    std::streamsize written = 0;
+
+    while (written < count) {
+        auto const piece = std::min(static_cast<std::size_t>(count - written), FrameSize - m_frameBytes);
+
+        if (not compress(data + written, piece, ZSTD_e_continue)) {
+            break;
+        }
+
+        written += static_cast<std::streamsize>(piece);
+        m_frameBytes += piece;
+
+        if (m_frameBytes == FrameSize and not compress(nullptr, 0, ZSTD_e_end)) {
+            break;
+        }
+    }
+
+    return written;
+}
+
+/// \details Ends the frame, so that a successful flush means the whole file is on disk, checksum and all. An empty
+/// \details text still gets a frame, so that the file is a zstd file.
+int ZstdWriter::sync()
+{
+    if ((m_frameBytes > 0 or not m_written) and not compress(nullptr, 0, ZSTD_e_end)) {
+        return -1;
+    }
+
+    return m_file.flush() ? 0 : -1;
+}
+
+/// \brief Compress @p size bytes of @p data, writing out the compressed data as it is made
+/// \returns Whether it all went into the file; with ZSTD_e_end, the frame is then ended
+bool ZstdWriter::compress(char const* data, std::size_t size, ZSTD_EndDirective mode)
+{
+    ZSTD_inBuffer in { data, size, 0 };
+    bool done = false;
+
+    while (not done) {
+        ZSTD_outBuffer out { m_output.data(), m_output.size(), 0 };
+        auto const rv = ::ZSTD_compressStream2(m_context, &out, &in, mode);
+
+        if (::ZSTD_isError(rv) or not m_file.write(m_output.data(), static_cast<std::streamsize>(out.pos))) {
+            return false;
+        }
+
+        done = mode == ZSTD_e_end ? rv == 0 : in.pos == in.size;
+    }
+
+    if (mode == ZSTD_e_end) {
+        m_frameBytes = 0;
+        m_written = true;
+    }
+
+    return true;
+}
+
+Compression compressed::detect(std::filesystem::path const& path)
+{
+    std::ifstream in { path, std::ios::binary };
+
+    if (not in) {
+        throw std::system_error(errno, std::generic_category(), "Could not open file " + path.string());
+    }
+
+    std::array<char, ZstdMagic.size()> magic {};
+    in.read(magic.data(), magic.size());
+
+    auto const startsWith = [&magic, read = static_cast<std::size_t>(in.gcount())](auto const& expected) {
+        return read >= expected.size() and std::equal(expected.begin(), expected.end(), magic.begin(), [](unsigned char e, char c) {
+            return e == static_cast<unsigned char>(c);
+        });
+    };
+
+    if (startsWith(GzipMagic)) {
+        return Compression::Gzip;
+    }
+    else if (startsWith(ZstdMagic)) {
+        return Compression::Zstd;
+    }
+
+    return Compression::None;
+}
+
+std::unique_ptr<std::istream> compressed::openForReading(std::filesystem::path const& path, Compression compression,
+    std::shared_ptr<SeekIndex> index)
+{
+    if (compression == Compression::Gzip) {
+        return std::make_unique<DecompressingInput<GzipReader>>(path, std::move(index));
+    }
+    else if (compression == Compression::Zstd) {
+        return std::make_unique<DecompressingInput<ZstdReader>>(path, std::move(index));
+    }
+
+    auto in = std::make_unique<std::ifstream>(path, std::ios::binary);
+
+    if (not *in) {
+        throw std::system_error(errno, std::generic_category(), "Could not open file " + path.string());
+    }
+
+    return in;
+}
+
+std::unique_ptr<std::ostream> compressed::openForWriting(std::filesystem::path const& path, Compression compression)
+{
+    if (compression == Compression::Gzip) {
+        return std::make_unique<CompressingOutput<GzipWriter>>(path);
+    }
+    else if (compression == Compression::Zstd) {
+        return std::make_unique<CompressingOutput<ZstdWriter>>(path);
+    }
+
+    auto out = std::make_unique<std::ofstream>(path, std::ios::binary | std::ios::trunc);
+
+    if (not *out) {
+        throw std::system_error(errno, std::generic_category(), "Could not create file " + path.string());
+    }
+
+    return out;
+}
@@ -0,0 +1,54 @@
+#include "Cursor/Cursor.hpp"
+
+#include <algorithm>
+
+/**
+ * @brief Moves the cursor in the direction of the arrow-key pressed
+ * @param key One of the four possible arrow-keys
+ * @param buffer The buffer in which the cursor moves
+ * @param folds The folds of the buffer; a fold is stepped over in one move, however many rows it hides
+*/
+void Cursor::moveCursor(Key const& key, Buffer const& buffer, Folds const& folds)
+{
+    int const numRows = buffer.size();
+
+    switch (key) {
+    case Key::ArrowLeft:
+        if (xPos != 0) { 
+            xPos--; 
+        }
+        else if (yPos > 0) {
+            yPos = folds.step(yPos, -1);
+            xPos = buffer.rowLength(yPos);
+        }
+        
+        break;
+    
+    case Key::ArrowRight:
+        if (yPos < numRows and xPos < buffer.rowLength(yPos)) {
+            xPos++;
+        }
+        else if (yPos < numRows and xPos == buffer.rowLength(yPos)) {
+            yPos = std::min(folds.step(yPos, 1), numRows);
+            xPos = 0;
+        }
+
+        break;
+
+    case Key::ArrowUp:
+        if (yPos != 0) { yPos = folds.step(yPos, -1); }
+        break;
+
+    case Key::ArrowDown:
+        if (yPos < numRows) { yPos = std::min(folds.step(yPos, 1), numRows); }
+        break;
+
+    default:
+        break;
+    }
+
+    // yPos may have been mutated and could refer to a different, shorter row
+    if (auto rowLen = buffer.rowLength(yPos); xPos > rowLen) {
+        xPos = rowLen;
+    }
+}
@@ -0,0 +1,82 @@
+#include "CursorSet/CursorSet.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
+namespace
+{
+    [[nodiscard]]
+    bool before(Cursor const& a, Cursor const& b) noexcept
+    {
+        return std::tie(a.yPos, a.xPos) < std::tie(b.yPos, b.xPos);
+    }
+
+    [[nodiscard]]
+    bool same(Cursor const& a, Cursor const& b) noexcept
+    {
+        return a.yPos == b.yPos and a.xPos == b.xPos;
+    }
+}
+
+std::span<Cursor const> CursorSet::onRow(int y) const noexcept
+{
+    auto const first = std::lower_bound(m_cursors.begin(), m_cursors.end(), y,
+        [](Cursor const& cursor, int row) { return cursor.yPos < row; });
+    auto const last = std::upper_bound(first, m_cursors.end(), y,
+        [](int row, Cursor const& cursor) { return row < cursor.yPos; });
+
+    return { first, last };
+}
+
+/// \details A cursor already at @p at becomes the primary cursor instead
+void CursorSet::add(Position at)
+{
+    Cursor const cursor { at.x, at.y };
+    auto const it = std::lower_bound(m_cursors.begin(), m_cursors.end(), cursor, before);
+
+    m_primary = static_cast<std::size_t>(std::distance(m_cursors.begin(), it));
+
+    if (it == m_cursors.end() or not same(*it, cursor)) {
+        m_cursors.insert(it, cursor);
+    }
+}
+
+void CursorSet::assign(std::vector<Position> const& positions, std::size_t primary)
+{
+    if (positions.empty()) {
+        collapse();
+        return;
+    }
+
+    m_cursors.clear();
+    m_cursors.reserve(positions.size());
+
+    for (auto const& at : positions) {
+        m_cursors.push_back({ at.x, at.y });
+    }
+
+    m_primary = std::min(primary, positions.size() - 1);
+    normalise();
+}
+
+void CursorSet::collapse() noexcept
+{
+    std::swap(m_cursors.front(), m_cursors[m_primary]);
+    m_cursors.resize(1);
+    m_primary = 0;
+}
+
+void CursorSet::normalise()
+{
+    auto const kept = primary();
+
+    if (not std::is_sorted(m_cursors.begin(), m_cursors.end(), before)) {
+        std::stable_sort(m_cursors.begin(), m_cursors.end(), before);
+    }
+
+    m_cursors.erase(std::unique(m_cursors.begin(), m_cursors.end(), same), m_cursors.end());
+
+    auto const it = std::lower_bound(m_cursors.begin(), m_cursors.end(), kept, before);
+    m_primary = static_cast<std::size_t>(std::distance(m_cursors.begin(), it));
+}
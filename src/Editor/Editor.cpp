@@ -1,72 +1,44 @@
 #include "Editor/Editor.hpp"
+#include "Commands/Commands.hpp"
 #include "Keys/Keys.hpp"
 #include "Utils/Utils.hpp"
 
 #include <write/write.hpp>
 
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
 #include <cstddef>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <new>
 #include <stdexcept>
 #include <system_error>
 #include <string>
 #include <optional>
+#include <tuple>
+#include <utility>
 
 #include <fmt/core.h>
 #include <fmt/printf.h>
 
 using namespace kilo::lib;
 
-/**
- * @brief Moves the cursor in the direction of the arrow-key pressed
- * @param key One of the four possible arrow-keys
-*/
-void Cursor::moveCursor(Key const& key)
-{   
-    auto const& editor = Editor::instance();
-    std::string const* row = (yPos >= editor.m_numRows) ? nullptr : &editor.m_text[yPos];
-
-    switch (key) {
-    case Key::ArrowLeft:
-        if (xPos != 0) { 
-            xPos--; 
-        }
-        else if (yPos > 0) {
-            yPos--;
-            xPos = std::ssize(editor.m_text[yPos]);
-        }
-        
-        break;
-    
-    case Key::ArrowRight:
-        if (row and xPos < std::ssize(*row)) {
-            xPos++;
-        }
-        else if (row and xPos == std::ssize(*row)) {
-            yPos++;
-            xPos = 0;
-        }
-
-        break;
-
-    case Key::ArrowUp:
-        if (yPos != 0) { yPos--; }
-        break;
-
-    case Key::ArrowDown:
-        if (yPos < editor.m_numRows) { yPos++; }
-        break;
-
-    default:
-        break;
-    }
-
-    // We have to set row again since yPos is mutated and could refer to a different location
-    row = (yPos >= editor.m_numRows) ? nullptr : &editor.m_text[yPos];
+namespace
+{
+    /// Set by SIGWINCH when the terminal window is resized, and cleared once the editor has adapted to the new size
+    volatile std::sig_atomic_t windowResized = 0;
 
-    if (auto rowLen = row ? std::ssize(*row) : 0; xPos > rowLen) {
-        xPos = static_cast<int>(rowLen);
+    void onWindowResized(int) noexcept
+    {
+        windowResized = 1;
     }
 }
 
@@ -75,9 +47,39 @@ void Cursor::moveCursor(Key const& key)
  *
  * @details Creates a default instance of an Editor.
  * Decrements @c m_winsize.row by 1 to create room for the status bar at the bottom of the Editor window.
+ * If @c KILO_LATENCY_LOG is set in the environment, latency instrumentation is enabled from the start and the
+ * histograms are written to the file it names on exit.
+ * If @c KILO_KEYMAP is set, the bindings in the file it names are applied on top of the default keymap.
+ * The window is laid out again whenever the terminal is resized.
 */
 Editor::Editor()
 {
+    // Only the rows an edit or a load touched are wrapped again, and only the folds after them move
+    m_buffer.onRowsChanged([this](int y, int removed, int inserted) {
+        if (m_wrap) {
+            m_layout.update(m_buffer, y, removed, inserted);
+        }
+
+        m_folds.update(y, removed, inserted);
+    });
+
+    m_modal.useFolds(m_folds);
+
+    struct sigaction action {};
+    action.sa_handler = onWindowResized;
+    action.sa_flags = SA_RESTART;
+    ::sigemptyset(&action.sa_mask);
+    ::sigaction(SIGWINCH, &action, nullptr);
+
+    if (char const* log = std::getenv("KILO_LATENCY_LOG"); log and *log) {
+        m_latencyLog = log;
+        m_latency.enable(true);
+    }
+
+    if (char const* keymap = std::getenv("KILO_KEYMAP"); keymap and *keymap) {
+        loadKeymap(keymap);
+    }
+
     try {
         m_terminalCtrl.enableRawMode();
     }
@@ -98,6 +100,20 @@ Editor::Editor()
 */
 Editor::~Editor()
 {
+    if (not m_latencyLog.empty()) {
+        try {
+            m_latency.dump(m_latencyLog);
+        }
+        catch (std::system_error const& err) {
+            fmt::print(stderr, "{}\n", err.what());
+        }
+    }
+
+    saveSession();
+
+    // Finish the frame that is going out, so the screen isn't cleared in the middle of an escape sequence
+    m_output.finish(std::chrono::milliseconds { 500 });
+
     try {
        [[maybe_unused]] auto const clear = write::write(STDOUT_FILENO, "\x1b[2J", 4); // clear the screen
        [[maybe_unused]] auto const repo =  write::write(STDOUT_FILENO, "\x1b[H", 3); // reposition the cursor to the top-left corner
@@ -118,6 +134,66 @@ Editor& Editor::instance()
     return editor;
 }
 
+/**
+ * @brief Block until a key is pressed, writing out pending frames as the terminal accepts them
+ * @returns Whether a key was pressed; if not, the screen should be repainted before waiting again
+ *
+ * Waiting on the terminal's writability and on input at once keeps the editor responsive to keys while a slow
+ * terminal catches up. While the file is still loading, the rest of it is read a chunk at a time whenever there is
+ * no input, and the screen is repainted once it is all in.
+*/
+bool Editor::waitForInput()
+{
+    while (not inputPending()) {
+        std::array<pollfd, 2> fds {{ { STDIN_FILENO, POLLIN, 0 }, { m_output.fd(), POLLOUT, 0 } }};
+        nfds_t const count = m_output.pending() ? 2 : 1;
+        auto const loading = m_buffer.loading();
+
+        auto const ready = ::poll(fds.data(), count, loading ? 0 : -1);
+
+        if (ready == -1) {
+            // A resize interrupts the wait; the window is repainted at its new size
+            if (errno == EINTR) {
+                if (windowResized) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            return true;
+        }
+
+        if (ready == 0 and loading) {
+            try {
+                if (not m_buffer.loadMore()) {
+                    return false;
+                }
+            }
+            catch (std::bad_alloc const&) {
+                m_statusMsg = "Out of memory";
+                return false;
+            }
+            catch (std::system_error const& err) {
+                m_statusMsg = err.what();
+                return false;
+            }
+
+            continue;
+        }
+
+        if (count == 2 and fds[1].revents != 0) {
+            m_output.flush();
+        }
+
+        if (fds[0].revents != 0) {
+            return true;
+        }
+    }
+
+    return true;
+}
+
 /** 
  * @brief Maps keypresses to editor operations 
 */
@@ -125,53 +201,354 @@ void Editor::processKeypress()
 {
     int c;
 
+    m_latency.start();
+
     try {
-        c = readKey();
+        auto const first = readByte();
+        m_latency.stamp(Stage::Read);
+
+        c = decodeKey(first);
+
+        if (static_cast<Key>(c) == Key::Paste) {
+            m_paste = readPaste();
+        }
+
+        m_latency.stamp(Stage::Decode);
     }
     catch (std::system_error const& err) {
         fmt::print(stderr, "Error: {}\n", err.code().message());
         return;
     }
 
-    if (c == ctrlKey('q')) {
-        std::exit(EXIT_SUCCESS);
+    m_statusMsg.clear();
+
+    auto const keyPressed = static_cast<Key>(c);
+
+    // Escape outside of insert mode drops the cursors other than the primary one
+    if (isEscapeKey(keyPressed) and m_modal.mode() != Mode::Insert) {
+        m_cursors.collapse();
     }
-    else {
-        auto keyPressed = static_cast<Key>(c);
-        processKeypressHelper(keyPressed);
+
+    // Each command outside of insert mode is undone on its own, as is each paste; the keys typed in insert mode
+    // are undone together with the command that entered it
+    if (m_modal.mode() != Mode::Insert or keyPressed == Key::Paste) {
+        m_buffer.checkpoint();
     }
+
+    // Outside of insert mode the modal engine gets the first look at every key. Its commands act at the primary
+    // cursor alone, so once one of them edits the text the other cursors no longer point where they did, and go
+    auto const edits = m_buffer.edits();
+
+    try {
+        if (m_modal.mode() == Mode::Insert or not m_modal.feed(keyPressed, m_buffer, m_cursor)) {
+            execute(m_keymap.lookup(keyPressed), keyPressed);
+        }
+        else {
+            // A chord begun before the engine took this key is abandoned, rather than completed by the next key
+            m_keymap.cancel();
+
+            if (m_buffer.edits() != edits) {
+                m_cursors.collapse();
+            }
+        }
+    }
+    catch (std::bad_alloc const&) {
+        m_keymap.cancel();
+        m_statusMsg = "Out of memory";
+    }
+    catch (std::system_error const& err) {
+        // A command that reads the rest of the file first, such as "G", stops at what could be read
+        m_keymap.cancel();
+        m_statusMsg = err.what();
+    }
+
+    // A jump, an undo or an edit that lands the cursor in a fold opens it, as in vi
+    if (m_folds.hidden(m_cursor.yPos)) {
+        m_folds.unfold(m_cursor.yPos);
+    }
+
+    m_latency.stamp(Stage::Dispatch);
 }
 
-void Editor::processKeypressHelper(Key const& key) noexcept
+/**
+ * @brief Apply the key bindings in a file on top of the current keymap
+ * @param path The file to read the bindings from
+ *
+ * Exits the program if the file cannot be read or holds an invalid binding, so that a typo doesn't go unnoticed.
+*/
+void Editor::loadKeymap(std::filesystem::path const& path)
 {
-    auto const& [col, row] = m_offset.position;
+    std::ifstream in { path };
 
-    if (isHomeKey(key)) {
-        m_cursor.xPos = 0;
+    if (not in) {
+        fmt::print(stderr, "Could not open keymap {}.\nExiting the program...\n", path.string());
+        std::exit(EXIT_FAILURE);
     }
-    else if (isEndKey(key)) {
-        if (m_cursor.yPos < m_numRows) {
-            m_cursor.xPos = std::ssize(m_text[m_cursor.yPos]);
-        }
+
+    try {
+        m_keymap.load(in);
     }
-    else if (isPageKey(key)) {
-        if (key == Key::PageUp) {
-            m_cursor.yPos = col;
+    catch (std::invalid_argument const& err) {
+        fmt::print(stderr, "{}: {}\nExiting the program...\n", path.string(), err.what());
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Show or hide the latency overlay in the status bar
+ *
+ * Instrumentation is only enabled while the overlay is shown, unless a latency log was requested at startup.
+*/
+void Editor::toggleLatencyOverlay() noexcept
+{
+    m_showLatency = not m_showLatency;
+    m_latency.enable(m_showLatency or not m_latencyLog.empty());
+}
+
+/**
+ * @brief Turn wrapping of rows wider than the window on or off
+ *
+ * The layout is only kept up to date while wrapping is on, so it is built afresh each time it is turned on. The row
+ * at the top of the window stays there.
+*/
+void Editor::toggleWrap()
+{
+    m_wrap = not m_wrap;
+
+    if (m_wrap) {
+        m_layout.rebuild(m_buffer, m_winsize.col);
+        m_offset.screenRow = m_layout.screenRow(m_offset.position.x);
+        m_offset.position.y = 0;
+    }
+
+    m_statusMsg = m_wrap ? "Wrap on" : "Wrap off";
+}
+
+/**
+ * @brief Adapt to a new size of the terminal window
+ *
+ * With wrapping on, every row is wrapped again at the new width.
+*/
+void Editor::resize()
+{
+    m_winsize = winsize::winsize {};
+    m_winsize.row -= 1;
+
+    if (m_wrap) {
+        m_layout.setWidth(m_winsize.col);
+    }
+}
+
+/**
+ * @brief Run a command
+ * @param command The command the keymap bound to the key pressed
+ * @param key The key pressed; inserted into the text by Command::InsertChar
+*/
+void Editor::execute(Command command, Key key) noexcept
+{
+    auto const& [col, row] = m_offset.position;
+
+    // Moves and edits act at every cursor, and then the window follows the primary one
+    auto const moveEach = [this](auto&& move) {
+        cursors().moveEach(move);
+        m_cursor = m_cursors.primary();
+    };
+
+    // Paging moves the primary cursor to visible row y, and every other cursor by as many visible rows
+    auto const pageTo = [this](int y) {
+        commands::moveRows(m_buffer, m_folds, cursors(), m_folds.visibleIndex(y) - m_folds.visibleIndex(m_cursor.yPos));
+        m_cursor = m_cursors.primary();
+    };
+
+    auto const editEach = [this](auto&& edit) {
+        edit(m_buffer, cursors());
+        m_cursor = m_cursors.primary();
+    };
+
+    // Editing can only fail by running out of memory, in which case the keypress is dropped
+    try {
+        switch (command) {
+        case Command::NormalMode:
+            moveEach([this](Cursor& cursor) { m_modal.enterNormal(m_buffer, cursor); });
+            break;
+
+        case Command::None:
+        case Command::Count:
+            break;
+
+        case Command::Quit:
+            std::exit(EXIT_SUCCESS);
+
+        case Command::Save:
+            save();
+            break;
+
+        case Command::ToggleLatency:
+            toggleLatencyOverlay();
+            break;
+
+        case Command::ToggleWrap:
+            toggleWrap();
+            break;
+
+        case Command::MoveLeft:
+        case Command::MoveRight:
+        case Command::MoveUp:
+        case Command::MoveDown: {
+            // The command may be bound to any key, so the arrow it stands for is worked out from the command
+            auto const arrow = command == Command::MoveLeft ? Key::ArrowLeft
+                : command == Command::MoveRight ? Key::ArrowRight
+                : command == Command::MoveUp ? Key::ArrowUp
+                : Key::ArrowDown;
+
+            moveEach([this, arrow](Cursor& cursor) { cursor.moveCursor(arrow, m_buffer, m_folds); });
+            break;
         }
-        else if (key == Key::PageDown) {
-            m_cursor.yPos = col + m_winsize.row - 1;
 
-            if (m_cursor.yPos > m_numRows) {
-                m_cursor.yPos = m_numRows;
+        // Paging jumps straight to the row a screen away from the top or bottom of the window, a closed fold
+        // counting as one row
+        case Command::PageUp:
+            pageTo(m_folds.step(col, -m_winsize.row));
+            break;
+
+        case Command::PageDown: {
+            // The rows a screen further down may not have been read yet
+            auto const target = m_folds.step(col, 2 * m_winsize.row - 1);
+
+            while (m_buffer.size() <= target and m_buffer.loadMore()) {
             }
+
+            pageTo(m_folds.visible(std::min(target, m_buffer.size())));
+            break;
         }
 
-        for (auto iter = m_winsize.row; iter > 0; --iter) {
-            m_cursor.moveCursor(key == Key::PageUp ? Key::ArrowUp : Key::ArrowDown);
+        case Command::Home:
+            moveEach([](Cursor& cursor) { commands::moveHome(cursor); });
+            break;
+
+        case Command::End:
+            moveEach([this](Cursor& cursor) { commands::moveEnd(m_buffer, cursor); });
+            break;
+
+        case Command::InsertChar:
+            if (m_modal.mode() == Mode::Insert and isPrintable(key)) {
+                char const c = static_cast<char>(key);
+                editEach([c](Buffer& buffer, CursorSet& cursors) { commands::insertText(buffer, cursors, std::string_view { &c, 1 }); });
+            }
+
+            break;
+
+        case Command::InsertNewline:
+            editEach([](Buffer& buffer, CursorSet& cursors) { commands::insertNewline(buffer, cursors); });
+            break;
+
+        case Command::DeleteBackward:
+            editEach([](Buffer& buffer, CursorSet& cursors) { commands::deleteBackward(buffer, cursors); });
+            break;
+
+        case Command::DeleteForward:
+            editEach([](Buffer& buffer, CursorSet& cursors) { commands::deleteForward(buffer, cursors); });
+            break;
+
+        // The whole paste is a single insertion, so it is one undo entry and is drawn in a single repaint
+        case Command::Paste:
+            editEach([this](Buffer& buffer, CursorSet& cursors) { commands::insertText(buffer, cursors, m_paste); });
+            m_buffer.checkpoint();
+            m_paste.clear();
+            m_paste.shrink_to_fit();
+            break;
+
+        // Undoing or redoing leaves a single cursor, where the change was
+        case Command::Undo:
+            m_cursors.collapse();
+            restore(m_buffer.undo(), "Already at oldest change");
+            break;
+
+        case Command::Redo:
+            m_cursors.collapse();
+            restore(m_buffer.redo(), "Already at newest change");
+            break;
+
+        case Command::AddCursorBelow:
+            if (auto const y = m_folds.step(m_cursor.yPos, 1); y < m_buffer.size()) {
+                cursors().add({ std::min(m_cursor.xPos, m_buffer.rowLength(y)), y });
+                m_cursor = m_cursors.primary();
+            }
+
+            break;
+
+        // Every occurrence of the word in the file gets a cursor, not just those in the rows read so far
+        case Command::CursorsAtWord:
+            m_buffer.loadAll();
+
+            if (auto const count = commands::cursorsAtWord(m_buffer, cursors()); count > 0) {
+                m_cursor = m_cursors.primary();
+                m_statusMsg = fmt::format("{} cursors", count);
+            }
+            else {
+                m_statusMsg = "No word under the cursor";
+            }
+
+            break;
         }
     }
-    else if (isArrowKey(key)) {
-        m_cursor.moveCursor(key);
+    catch (std::bad_alloc const&) {
+        m_statusMsg = "Out of memory";
+    }
+    catch (std::system_error const& err) {
+        // The rest of the file couldn't be read, e.g. because it is corrupt; the rows read so far are kept
+        m_statusMsg = err.what();
+    }
+}
+
+/**
+ * @brief The cursors, brought up to date with the primary cursor
+ * @return Every cursor
+ *
+ * The commands of the modal engine only move the primary cursor, so it is put back among the others before they are
+ * all moved or edited at.
+*/
+CursorSet& Editor::cursors()
+{
+    m_cursors.primary() = m_cursor;
+    m_cursors.normalise();
+
+    return m_cursors;
+}
+
+/**
+ * @brief Move the cursor to where an undo or redo took place
+ * @param where The position returned by Buffer::undo or Buffer::redo; nothing if there was nothing to undo or redo
+ * @param nothing The message shown if there was nothing to undo or redo
+*/
+void Editor::restore(std::optional<Position> where, std::string_view nothing)
+{
+    if (where) {
+        commands::moveTo(m_buffer, m_cursor, *where);
+    }
+    else {
+        m_statusMsg = nothing;
+    }
+}
+
+/**
+ * @brief Write the buffer back to the file it was read from
+ *
+ * The outcome is reported in the status bar.
+*/
+void Editor::save()
+{
+    if (m_filename.empty()) {
+        m_statusMsg = "No file name to save to";
+        return;
+    }
+
+    try {
+        m_buffer.save(m_filename);
+        m_statusMsg = fmt::format("Wrote {} lines", m_buffer.size());
+    }
+    catch (std::system_error const& err) {
+        m_statusMsg = err.what();
     }
 }
 
@@ -180,7 +557,13 @@ void Editor::processKeypressHelper(Key const& key) noexcept
 */
 void Editor::refreshScreen()
 {
+    if (windowResized) {
+        windowResized = 0;
+        resize();
+    }
+
     scroll();
+    m_latency.stamp(Stage::Layout);
 
     std::string buffer;
     buffer += "\x1b[?25l";  // hide the cursor while repainting
@@ -189,17 +572,19 @@ void Editor::refreshScreen()
     drawRows(buffer);       // draw column of tildes
     drawStatusBar(buffer);  // draw a blank white status bar of inverted space characters
 
-    auto const& [col, row] = m_offset.position;
+    auto const [x, y] = cursorOnScreen();
 
     // Move the cursor to position (y + 1, x + 1)
-    std::string str = fmt::format("\x1b[{};{}H", (m_cursor.yPos - col) + 1, (m_cursor.xPos - row) + 1);
+    std::string str = fmt::format("\x1b[{};{}H", y + 1, x + 1);
     buffer += str;
     
     // Show the cursor immediately after repainting
     buffer += "\x1b[?25h";
+    m_latency.stamp(Stage::Render);
 
-    // Reposition the cursor to the top-left corner
-    [[maybe_unused]] auto const rv = write::write(STDOUT_FILENO, buffer.c_str(), buffer.length());
+    // Write what the terminal accepts now; the rest goes out from waitForInput, unless a newer frame replaces it
+    m_output.submit(std::move(buffer));
+    m_latency.stamp(Stage::Write);
 }
 
 /**
@@ -240,16 +625,19 @@ void Editor::displayWelcomeMessage(std::string& buffer) const
  *
  * Displays the welcome message if the user doesn't open a file
  * A tilde is drawn at the beginning of any lines that come after the EOF being edited
+ * The window is drawn a line at a time from the one at its top, a closed fold taking up a single line. With wrapping
+ * on, a row wider than the window takes up as many lines as it needs.
 */
 void Editor::drawRows(std::string& buffer)
 {
     auto const& [col, row] = m_offset.position;
+    auto line = topLine();
 
     for (int y = 0; y < m_winsize.row; ++y) {
-        if (int filerow = y + col; filerow >= m_numRows) {
+        if (int filerow = line.y; filerow >= m_buffer.size()) {
             
             // Display the welcome msg if the user doesn't open a file
-            if (m_numRows == 0 and y == m_winsize.row / 3) {
+            if (m_buffer.size() == 0 and y == m_winsize.row / 3) {
                 displayWelcomeMessage(buffer);
             }
             else {
@@ -257,19 +645,134 @@ void Editor::drawRows(std::string& buffer)
             }
         }
         else {
-            if (auto strlen = std::ssize(m_text[filerow]) - row; strlen < 0) {
-                m_text[filerow].resize(0);
-            }
-            else if (strlen > m_winsize.col) {
-                m_text[filerow].resize(m_winsize.col);
-            }
-
-            buffer += m_text[filerow];
+            drawRow(buffer, filerow, m_wrap ? line.x : row);
+            drawFoldMarker(buffer, line);
         }
 
         buffer += "\x1b[K"; // clear lines one at a time
         buffer += "\r\n";
+
+        line = below(line);
+    }
+}
+
+/**
+ * @brief Draw the visible part of a row, with the cursors on it other than the primary one in reverse video
+ * @param buffer The buffer to which the row is written
+ * @param visible The part of the row that fits in the window
+ * @param filerow The row drawn
+ * @param from The column @p visible starts at
+ *
+ * The cursors on the row are found by a binary search, so drawing the window takes the same time however many cursors
+ * there are elsewhere.
+*/
+void Editor::drawCursors(std::string& buffer, std::string_view visible, int filerow, int from) const
+{
+    std::size_t drawn = 0;
+
+    for (auto const& cursor : m_cursors.onRow(filerow)) {
+        auto const x = cursor.xPos - from;
+
+        if (&cursor == &m_cursors.primary() or x < 0 or x >= m_winsize.col or static_cast<std::size_t>(x) > visible.size()) {
+            continue;
+        }
+
+        auto const at = static_cast<std::size_t>(x);
+
+        buffer += visible.substr(drawn, at - drawn);
+        buffer += "\x1b[7m";
+        buffer += at < visible.size() ? visible.substr(at, 1) : std::string_view { " " };
+        buffer += "\x1b[m";
+        drawn = at + 1;
+    }
+
+    if (drawn < visible.size()) {
+        buffer += visible.substr(drawn);
+    }
+}
+
+/**
+ * @brief Note how many rows a closed fold hides after the last line of its first row, if there is room for it
+ * @param buffer The buffer to which the marker is written
+ * @param line The line just drawn
+*/
+void Editor::drawFoldMarker(std::string& buffer, Position line) const
+{
+    auto const fold = m_folds.at(line.y);
+
+    if (not fold or below(line).y == line.y) {
+        return;
+    }
+
+    auto const from = m_wrap ? line.x : m_offset.position.y;
+    auto const drawn = std::clamp(m_buffer.rowLength(line.y) - from, 0, static_cast<int>(m_winsize.col));
+    auto marker = fmt::format(" +{} rows", fold->last - fold->first);
+
+    marker.resize(std::min(marker.size(), static_cast<std::size_t>(m_winsize.col - drawn)));
+
+    buffer += "\x1b[7m";
+    buffer += marker;
+    buffer += "\x1b[m";
+}
+
+/**
+ * @brief Draw the part of a row of text that is scrolled into view
+ * @param buffer The buffer to which the row is written
+ * @param filerow The row of text to draw
+ * @param from The first column drawn; as much of the row from there on as fits in the window is drawn
+ *
+ * In visual mode, the selected part of the row is drawn in inverted colours.
+*/
+void Editor::drawRow(std::string& buffer, int filerow, int from) const
+{
+    auto const text = m_buffer.row(filerow);
+
+    // A cursor past the end of a row is drawn all the same
+    if (std::ssize(text) <= from and m_cursors.size() == 1) {
+        return;
+    }
+
+    auto const visible = std::ssize(text) > from ? text.substr(static_cast<std::size_t>(from), m_winsize.col) : std::string_view {};
+
+    if (m_modal.mode() != Mode::Visual) {
+        if (m_cursors.size() > 1) {
+            drawCursors(buffer, visible, filerow, from);
+        }
+        else {
+            buffer += visible;
+        }
+
+        return;
+    }
+    else if (visible.empty()) {
+        return;
+    }
+
+    auto start = m_modal.anchor();
+    auto end = m_cursor.position();
+
+    if (std::tie(end.y, end.x) < std::tie(start.y, start.x)) {
+        std::swap(start, end);
+    }
+
+    if (filerow < start.y or filerow > end.y) {
+        buffer += visible;
+        return;
     }
+
+    // The selection within the visible part of the row, as [first, last)
+    auto const clampToVisible = [&visible, from](int x) {
+        return static_cast<std::size_t>(std::clamp(x - from, 0, static_cast<int>(visible.size())));
+    };
+
+    auto const first = clampToVisible(filerow == start.y ? start.x : 0);
+    auto const last = clampToVisible(filerow == end.y ? end.x + 1 : static_cast<int>(text.size()));
+
+    buffer += visible.substr(0, first);
+    buffer += "\x1b[7m";
+    buffer += visible.substr(first, last - first);
+    buffer += "\x1b[m";
+    buffer += visible.substr(last);
 }
 
 /**
@@ -278,44 +781,124 @@ void Editor::drawRows(std::string& buffer)
  *
  * Attempts to open a file for input.
  * Sets the @c m_filename member to the name of the opened file
- * Writes the contents of the file to a vector of strings
- * Increments @c m_numRows to match the number of rows in the opened file
+ * Reads the contents of the file into @c m_buffer
 */
 void Editor::open(std::filesystem::path const& path)
 {
-    m_filename = path.c_str();
-    std::ifstream inFile{ path};
+    m_filename = path;
+    m_sidecar = Session::sidecarFor(path);
 
-    if (!inFile) {
-        fmt::print(stderr, "Could not open file {}.\n", m_filename);
+    if (m_sidecar) {
+        m_session = Session::restore(path, *m_sidecar);
+    }
+
+    // Only the first screen is read before the first paint; the rest is read while waiting for input.
+    // With a line index from an earlier session, that first screen is the one the session ended on, and with a seek
+    // index too, a compressed file is decompressed from the access point nearest to it.
+    try {
+        if (m_session and m_session->index.rows() > 0) {
+            m_buffer.open(path, m_session->index, m_session->offset.x, m_winsize.row, m_session->seekIndex);
+        }
+        else {
+            m_buffer.open(path, m_winsize.row);
+        }
+    }
+    catch (std::system_error const&) {
+        fmt::print(stderr, "Could not open file {}.\n", m_filename.string());
         return;
     }
 
-    std::string text{};
+    if (m_session) {
+        m_offset.position = m_session->offset;
+        commands::moveTo(m_buffer, m_cursor, m_session->cursor);
+    }
+}
 
-    while (std::getline(inFile, text)) {
-        m_text.push_back(text);
+/**
+ * @brief Remember where the editor was in the file, along with the file's line index, for the next time it is opened
+ *
+ * The index is taken from the buffer if it holds the text of the file as it is on disk. Otherwise the index of the
+ * restored session is kept if the file hasn't changed since, and if neither will do, only the position is saved. The
+ * seek index of a compressed file is taken likewise.
+*/
+void Editor::saveSession() noexcept
+{
+    if (not m_sidecar) {
+        return;
     }
 
-    m_numRows = static_cast<int>(m_text.size());
+    try {
+        Session session;
+        session.stamp = FileStamp::of(m_filename);
+        session.cursor = m_cursor.position();
+        session.offset = m_offset.position;
+
+        if (m_session and m_session->stamp == session.stamp and m_session->index.rows() > 0) {
+            session.index = m_session->index;
+        }
+        else if (not m_buffer.loading() and not m_buffer.dirty()) {
+            session.index = Session::indexOf(m_buffer);
+        }
+
+        session.seekIndex = m_buffer.seekIndex();
+
+        if (not session.seekIndex and m_session and m_session->stamp == session.stamp) {
+            session.seekIndex = m_session->seekIndex;
+        }
+
+        session.save(*m_sidecar);
+    }
+    catch (std::system_error const&) {
+        // Losing the session only costs the next start a little time
+    }
+    catch (std::bad_alloc const&) {
+    }
 }
 
 /**
  * @brief Determine the position of the cursor within the visible window
  *
  * Checks if the cursor is still within the visible window. 
- * If not, it adjusts @c m_offset.row to reposition it within the visible window
+ * If not, it adjusts @c m_offset.row to reposition it within the visible window.
+ *
+ * The window is walked a line at a time, from its top down to the cursor's line, or up from the cursor's line if that
+ * is below the window; the rows in a closed fold are stepped over in one go, so this takes at most a window's worth
+ * of steps however many rows are folded away. With wrapping on, the window never scrolls sideways.
 */
 void Editor::scroll()
 {
     auto& [col, row] = m_offset.position;
+    auto const before = [](Position a, Position b) { return std::tie(a.y, a.x) < std::tie(b.y, b.x); };
+    auto const cursor = cursorLine();
+    auto top = topLine();
+
+    m_cursorRow = 0;
 
-    if (m_cursor.yPos < col) {
-        col = m_cursor.yPos;
+    if (before(cursor, top)) {
+        top = cursor;
     }
+    else {
+        auto line = top;
+
+        for (; before(line, cursor) and m_cursorRow < m_winsize.row - 1; ++m_cursorRow) {
+            line = below(line);
+        }
 
-    if (m_cursor.yPos >= col + m_winsize.row) {
-        col = m_cursor.yPos - m_winsize.row + 1;
+        if (before(line, cursor)) {
+            top = cursor;
+
+            for (m_cursorRow = 0; m_cursorRow < m_winsize.row - 1 and (top.y > 0 or top.x > 0); ++m_cursorRow) {
+                top = above(top);
+            }
+        }
+    }
+
+    col = top.y;
+
+    if (m_wrap) {
+        m_offset.screenRow = m_layout.screenRow(top.y) + top.x / m_layout.width();
+        row = 0;
+        return;
     }
 
     if (m_cursor.xPos < row) {
@@ -327,6 +910,79 @@ void Editor::scroll()
     }
 }
 
+/**
+ * @brief Where the cursor is in the window
+ * @return The column and row of the window the cursor is drawn at, counted from 0
+*/
+Position Editor::cursorOnScreen() const noexcept
+{
+    if (not m_wrap) {
+        return { m_cursor.xPos - m_offset.position.y, m_cursorRow };
+    }
+
+    // The end of a row that fills its last screen row exactly is drawn in the window's last column
+    auto const at = m_layout.place(m_cursor.position());
+
+    return { std::min(at.x, m_winsize.col - 1), m_cursorRow };
+}
+
+/**
+ * @brief The line at the top of the window
+ * @return The row drawn there, and with wrapping on, the column it is drawn from
+*/
+Position Editor::topLine() const noexcept
+{
+    auto const line = m_wrap ? m_layout.locate(m_offset.screenRow) : Position { 0, m_offset.position.x };
+
+    // Folding the rows the window started in leaves it at the fold
+    if (m_folds.hidden(line.y)) {
+        return { 0, m_folds.visible(line.y) };
+    }
+
+    return line;
+}
+
+/**
+ * @brief The line the cursor is on
+ * @return The row the cursor is on, and with wrapping on, the column its line starts at
+*/
+Position Editor::cursorLine() const noexcept
+{
+    if (m_folds.hidden(m_cursor.yPos)) {
+        return { 0, m_folds.visible(m_cursor.yPos) };
+    }
+
+    return { m_wrap ? m_cursor.xPos - m_layout.place(m_cursor.position()).x : 0, m_cursor.yPos };
+}
+
+/// \returns The line drawn below @p line: the next part of its row, if it is wrapped, or else the next visible row
+Position Editor::below(Position line) const noexcept
+{
+    if (m_wrap and line.y < m_buffer.size()) {
+        if (auto const next = m_layout.next(line); next.y == line.y) {
+            return next;
+        }
+    }
+
+    return { 0, m_folds.step(line.y, 1) };
+}
+
+/// \returns The line drawn above @p line: the previous part of its row, if it is wrapped, or else the last part of
+/// \returns the previous visible row; the first line of the buffer for the first line of the buffer
+Position Editor::above(Position line) const noexcept
+{
+    if (line.x > 0) {
+        return { line.x - m_layout.width(), line.y };
+    }
+    else if (line.y == 0) {
+        return line;
+    }
+
+    auto const y = m_folds.step(line.y, -1);
+
+    return { m_wrap ? (m_layout.height(y) - 1) * m_layout.width() : 0, y };
+}
+
 /**
  * @brief Draws a status bar at the bottom of the editor window
  * @param buffer The string to which the contents of the status bar are written
@@ -335,7 +991,16 @@ void Editor::drawStatusBar(std::string& buffer) const
 {
     buffer += "\x1b[7m";    // switch to inverted colours (black text, white background)
     
-    std::string status = fmt::sprintf("%.20s - %d lines", m_filename.empty() ? "[No Name]" : m_filename, m_numRows);
+    constexpr std::array<char const*, 3> modeNames { "NORMAL", "INSERT", "VISUAL" };
+
+    std::string status = fmt::sprintf("%s %.20s - %d%s lines%s", modeNames[static_cast<std::size_t>(m_modal.mode())],
+        m_filename.empty() ? "[No Name]" : m_filename.string(), m_buffer.size(), m_buffer.loading() ? "+" : "",
+        m_buffer.dirty() ? " (modified)" : "");
+
+    if (not m_statusMsg.empty()) {
+        status += " - " + m_statusMsg;
+    }
+
     auto len = std::ssize(status);
 
     if (len > m_winsize.col) {
@@ -345,7 +1010,19 @@ void Editor::drawStatusBar(std::string& buffer) const
 
     buffer += status;
 
-    std::string rstatus = fmt::format("{}/{}", m_cursor.yPos + 1, m_numRows);
+    std::string rstatus = fmt::format("{}{}/{}", m_modal.pending(), m_cursor.yPos + 1, m_buffer.size());
+
+    if (m_cursors.size() > 1) {
+        rstatus = fmt::format("{} cursors | {}", m_cursors.size(), rstatus);
+    }
+
+    if (auto const format = m_buffer.format().describe(); not format.empty()) {
+        rstatus = fmt::format("{} | {}", format, rstatus);
+    }
+
+    if (m_showLatency) {
+        rstatus = fmt::format("{} | {}", m_latency.summary(), rstatus);
+    }
 
     while (len < m_winsize.col) {
         if (auto rlen = std::ssize(rstatus); m_winsize.col - len == rlen) {
@@ -0,0 +1,282 @@
+#include "Folds/Folds.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <string_view>
+
+namespace
+{
+    /// Tabs indent to the next multiple of this
+    constexpr int TabStop = 8;
+
+    /// \returns The width of the indentation of @p row, or -1 if it is blank
+    [[nodiscard]]
+    int indentOf(std::string_view row) noexcept
+    {
+        int width = 0;
+
+        for (auto c : row) {
+            if (c == ' ') {
+                ++width;
+            }
+            else if (c == '\t') {
+                width += TabStop - width % TabStop;
+            }
+            else {
+                return width;
+            }
+        }
+
+        return -1;
+    }
+
+    /// \returns The last row of the block row @p y heads, or @p y if it heads none
+    [[nodiscard]]
+    int blockEnd(Buffer const& buffer, int y) noexcept
+    {
+        auto const indent = indentOf(buffer.row(y));
+        auto last = y;
+
+        if (indent < 0) {
+            return y;
+        }
+
+        for (auto row = y + 1; row < buffer.size(); ++row) {
+            if (auto const deeper = indentOf(buffer.row(row)); deeper > indent) {
+                last = row;
+            }
+            else if (deeper >= 0) {
+                break;
+            }
+        }
+
+        return last;
+    }
+}
+
+/**
+ * @brief Fold a range of rows
+ * @param first The row left visible in place of the fold
+ * @param last The last row hidden
+ *
+ * The range grows to take in every fold it overlaps, which are merged into it.
+*/
+void Folds::fold(int first, int last)
+{
+    first = std::max(first, 0);
+
+    if (last <= first) {
+        return;
+    }
+
+    auto const begin = from(first);
+    auto end = begin;
+
+    for (; end < m_folds.size() and m_folds[end].first <= last; ++end) {
+        first = std::min(first, m_folds[end].first);
+        last = std::max(last, m_folds[end].last);
+    }
+
+    auto const at = m_folds.erase(m_folds.begin() + static_cast<std::ptrdiff_t>(begin), m_folds.begin() + static_cast<std::ptrdiff_t>(end));
+    m_folds.insert(at, Fold { first, last });
+    reindex(begin);
+}
+
+bool Folds::foldIndented(Buffer const& buffer, int y)
+{
+    if (y < 0 or y >= buffer.size()) {
+        return false;
+    }
+
+    if (auto const last = blockEnd(buffer, y); last > y) {
+        fold(y, last);
+        return true;
+    }
+
+    // A blank row belongs to the block of the row after it
+    auto indent = indentOf(buffer.row(y));
+
+    for (auto row = y + 1; indent < 0; ++row) {
+        indent = row < buffer.size() ? indentOf(buffer.row(row)) : std::numeric_limits<int>::max();
+    }
+
+    for (auto head = y - 1; head >= 0; --head) {
+        if (auto const outer = indentOf(buffer.row(head)); outer >= 0 and outer < indent) {
+            auto const last = blockEnd(buffer, head);
+
+            if (last < y) {
+                return false;
+            }
+
+            fold(head, last);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// \details Each block is appended after the folds before it, so this takes time linear in the size of the buffer
+void Folds::foldAllIndented(Buffer const& buffer)
+{
+    for (int y = 0; y < buffer.size(); ) {
+        if (auto const last = blockEnd(buffer, y); last > y) {
+            fold(y, last);
+            y = last + 1;
+        }
+        else {
+            ++y;
+        }
+    }
+}
+
+bool Folds::unfold(int y)
+{
+    auto const i = from(y);
+
+    if (i == m_folds.size() or m_folds[i].first > y) {
+        return false;
+    }
+
+    m_folds.erase(m_folds.begin() + static_cast<std::ptrdiff_t>(i));
+    reindex(i);
+
+    return true;
+}
+
+void Folds::clear() noexcept
+{
+    m_folds.clear();
+    m_hidden.assign(1, 0);
+}
+
+std::optional<Fold> Folds::at(int y) const noexcept
+{
+    auto const i = from(y);
+
+    if (i == m_folds.size() or m_folds[i].first > y) {
+        return std::nullopt;
+    }
+
+    return m_folds[i];
+}
+
+bool Folds::hidden(int y) const noexcept
+{
+    auto const fold = at(y);
+    return fold and y > fold->first;
+}
+
+int Folds::visible(int y) const noexcept
+{
+    auto const fold = at(y);
+    return fold ? fold->first : y;
+}
+
+int Folds::step(int y, int count) const noexcept
+{
+    return visibleRow(std::max(visibleIndex(y) + count, 0));
+}
+
+/// \details Every fold that starts before the visible row also ends before it, so all the rows they hide are above it
+int Folds::visibleIndex(int y) const noexcept
+{
+    y = visible(y);
+
+    auto const before = std::lower_bound(m_folds.begin(), m_folds.end(), y,
+        [](Fold const& fold, int row) { return fold.first < row; });
+
+    return y - m_hidden[static_cast<std::size_t>(std::distance(m_folds.begin(), before))];
+}
+
+/// \details The first rows of the folds are visible, and in order, so the folds whose first rows come before the
+/// \details visible row sought are found by a binary search; the row is past all the rows those folds hide.
+int Folds::visibleRow(int index) const noexcept
+{
+    std::size_t low = 0;
+    std::size_t high = m_folds.size();
+
+    while (low < high) {
+        auto const middle = low + (high - low) / 2;
+
+        if (m_folds[middle].first - m_hidden[middle] < index) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return index + m_hidden[low];
+}
+
+/**
+ * @brief Move the folds to follow a change to the rows of the buffer
+ * @param y The first row changed
+ * @param removed How many rows from row @p y on the change replaced
+ * @param inserted How many rows now stand in their place
+ *
+ * Rows changed in place leave the folds as they are. Otherwise the folds after the change move by the number of rows
+ * inserted or erased, and the ends of a fold that fall in the changed rows are kept within the rows that replaced
+ * them. The folds that end before the change are left alone.
+*/
+void Folds::update(int y, int removed, int inserted)
+{
+    if (removed == inserted or m_folds.empty()) {
+        return;
+    }
+
+    // An end of a fold in the rows replaced stays within the rows that replaced them; with none, the first row of the
+    // fold moves down to the row after them, and its last row up to the row before
+    auto const moved = [=](int row, bool last) {
+        if (row < y) {
+            return row;
+        }
+        else if (row >= y + removed) {
+            return row + inserted - removed;
+        }
+
+        return y + std::min(row - y, last ? inserted - 1 : std::max(inserted - 1, 0));
+    };
+
+    auto const first = from(y);
+    auto kept = first;
+
+    for (auto i = first; i < m_folds.size(); ++i) {
+        Fold const fold { moved(m_folds[i].first, false), moved(m_folds[i].last, true) };
+
+        if (fold.last <= fold.first) {
+            continue;
+        }
+
+        // Folds squeezed together by an erasure merge
+        if (kept > 0 and m_folds[kept - 1].last >= fold.first) {
+            m_folds[kept - 1].last = std::max(m_folds[kept - 1].last, fold.last);
+            continue;
+        }
+
+        m_folds[kept++] = fold;
+    }
+
+    m_folds.resize(kept);
+    reindex(first == 0 ? 0 : first - 1);
+}
+
+std::size_t Folds::from(int y) const noexcept
+{
+    auto const it = std::lower_bound(m_folds.begin(), m_folds.end(), y,
+        [](Fold const& fold, int row) { return fold.last < row; });
+
+    return static_cast<std::size_t>(std::distance(m_folds.begin(), it));
+}
+
+/// \brief Count the rows hidden by the folds before each fold from fold @p first on
+void Folds::reindex(std::size_t first)
+{
+    m_hidden.resize(m_folds.size() + 1);
+
+    for (auto i = first; i < m_folds.size(); ++i) {
+        m_hidden[i + 1] = m_hidden[i] + m_folds[i].last - m_folds[i].first;
+    }
+}
@@ -0,0 +1,159 @@
+#include "Keymap/Keymap.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <string>
+#include <utility>
+
+#include <fmt/core.h>
+
+namespace
+{
+    constexpr std::array<std::pair<std::string_view, Key>, 15> KeyNames {{
+        { "left", Key::ArrowLeft }, { "right", Key::ArrowRight }, { "up", Key::ArrowUp }, { "down", Key::ArrowDown },
+        { "delete", Key::Delete }, { "home", Key::Home }, { "end", Key::End },
+        { "pageup", Key::PageUp }, { "pagedown", Key::PageDown }, { "escape", Key::Escape },
+        { "paste", Key::Paste },
+        { "enter", Key::Enter }, { "backspace", Key::Backspace },
+        { "tab", static_cast<Key>('\t') }, { "space", static_cast<Key>(' ') },
+    }};
+
+    constexpr std::array<std::pair<std::string_view, Command>, static_cast<std::size_t>(Command::Count)> CommandNames {{
+        { "none", Command::None },
+        { "quit", Command::Quit }, { "save", Command::Save }, { "toggle-latency", Command::ToggleLatency },
+        { "toggle-wrap", Command::ToggleWrap },
+        { "move-left", Command::MoveLeft }, { "move-right", Command::MoveRight },
+        { "move-up", Command::MoveUp }, { "move-down", Command::MoveDown },
+        { "page-up", Command::PageUp }, { "page-down", Command::PageDown },
+        { "home", Command::Home }, { "end", Command::End },
+        { "insert-char", Command::InsertChar }, { "newline", Command::InsertNewline },
+        { "delete-backward", Command::DeleteBackward }, { "delete-forward", Command::DeleteForward },
+        { "normal-mode", Command::NormalMode },
+        { "paste", Command::Paste }, { "undo", Command::Undo }, { "redo", Command::Redo },
+        { "add-cursor-below", Command::AddCursorBelow }, { "cursors-at-word", Command::CursorsAtWord },
+    }};
+
+    /// \brief Split off the first whitespace-delimited word of @p line
+    [[nodiscard]]
+    std::string_view nextWord(std::string_view& line) noexcept
+    {
+        auto const start = line.find_first_not_of(" \t");
+
+        if (start == std::string_view::npos) {
+            line = {};
+            return {};
+        }
+
+        line.remove_prefix(start);
+
+        auto const end = std::min(line.find_first_of(" \t"), line.size());
+        auto const word = line.substr(0, end);
+        line.remove_prefix(end);
+
+        return word;
+    }
+}
+
+std::optional<Key> Keymap::keyNamed(std::string_view name) noexcept
+{
+    if (name.size() == 1) {
+        return static_cast<Key>(static_cast<unsigned char>(name.front()));
+    }
+
+    if (name.size() == 6 and name.starts_with("ctrl-") and name.back() >= 'a' and name.back() <= 'z') {
+        return static_cast<Key>(ctrlKey(name.back()));
+    }
+
+    for (auto const& [keyName, key] : KeyNames) {
+        if (keyName == name) {
+            return key;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::optional<Command> Keymap::commandNamed(std::string_view name) noexcept
+{
+    for (auto const& [commandName, command] : CommandNames) {
+        if (commandName == name) {
+            return command;
+        }
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * @brief Apply the bindings read from a stream on top of the current ones
+ * @param in The stream to read the bindings from
+ *
+ * Every line is validated before it is applied, but lines before an invalid one stay applied.
+*/
+void Keymap::load(std::istream& in)
+{
+    std::string text;
+
+    for (int lineNumber = 1; std::getline(in, text); ++lineNumber) {
+        std::string_view line { text };
+        auto const verb = nextWord(line);
+
+        if (verb.empty() or verb.front() == '#') {
+            continue;
+        }
+
+        try {
+            if (verb != "bind" and verb != "unbind") {
+                throw std::invalid_argument(fmt::format("expected bind or unbind, got '{}'", verb));
+            }
+
+            std::array<std::string_view, MaxSequence + 1> words {};
+            std::size_t count = 0;
+
+            for (auto word = nextWord(line); not word.empty(); word = nextWord(line)) {
+                if (count == words.size()) {
+                    throw std::invalid_argument("too many keys");
+                }
+
+                words[count++] = word;
+            }
+
+            auto command = Command::None;
+
+            if (verb == "bind") {
+                if (count < 2) {
+                    throw std::invalid_argument("bind needs at least one key and a command");
+                }
+
+                auto const named = commandNamed(words[--count]);
+
+                if (not named) {
+                    throw std::invalid_argument(fmt::format("unknown command '{}'", words[count]));
+                }
+
+                command = *named;
+            }
+
+            std::array<Key, MaxSequence> sequence {};
+
+            if (count == 0 or count > MaxSequence) {
+                throw std::invalid_argument("a binding must consist of one or two keys");
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                auto const key = keyNamed(words[i]);
+
+                if (not key) {
+                    throw std::invalid_argument(fmt::format("unknown key '{}'", words[i]));
+                }
+
+                sequence[i] = *key;
+            }
+
+            bind(std::span<Key const> { sequence.data(), count }, command);
+        }
+        catch (std::logic_error const& err) {
+            throw std::invalid_argument(fmt::format("line {}: {}", lineNumber, err.what()));
+        }
+    }
+}
@@ -0,0 +1,189 @@
+#include "Latency/Latency.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <memory>
+#include <system_error>
+
+#include <fmt/core.h>
+
+namespace
+{
+    constexpr std::array<std::string_view, 6> StageNames { "read", "decode", "dispatch", "layout", "render", "write" };
+
+    /// \brief Format a duration in nanoseconds using the largest unit that keeps it above 1
+    [[nodiscard]]
+    std::string formatDuration(std::uint64_t nanoseconds)
+    {
+        auto const ns = static_cast<double>(nanoseconds);
+
+        if (nanoseconds < 1'000) {
+            return fmt::format("{}ns", nanoseconds);
+        }
+        else if (nanoseconds < 1'000'000) {
+            return fmt::format("{:.1f}us", ns / 1e3);
+        }
+        else if (nanoseconds < 1'000'000'000) {
+            return fmt::format("{:.1f}ms", ns / 1e6);
+        }
+
+        return fmt::format("{:.1f}s", ns / 1e9);
+    }
+}
+
+void Histogram::record(std::uint64_t nanoseconds) noexcept
+{
+    m_buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    auto current = m_max.load(std::memory_order_relaxed);
+
+    while (current < nanoseconds and not m_max.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+        // current is reloaded by compare_exchange_weak on failure
+    }
+}
+
+std::uint64_t Histogram::percentile(double fraction) const noexcept
+{
+    auto const total = count();
+
+    if (total == 0) {
+        return 0;
+    }
+
+    // The rank of the requested sample, counting from 1
+    auto const rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(fraction * static_cast<double>(total) + 0.5));
+    std::uint64_t seen = 0;
+
+    for (std::size_t bucket = 0; bucket < Buckets; ++bucket) {
+        seen += m_buckets[bucket].load(std::memory_order_relaxed);
+
+        if (seen >= rank) {
+            // Report the top of the bucket, but never more than the largest value actually seen
+            auto const upper = bucket + 1 < Buckets ? lowerBound(bucket + 1) - 1 : UINT64_MAX;
+            return std::min(upper, max());
+        }
+    }
+
+    return max();
+}
+
+std::uint64_t Histogram::max() const noexcept
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::count() const noexcept
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+void Histogram::dump(std::FILE* file, std::string_view label) const
+{
+    for (std::size_t bucket = 0; bucket < Buckets; ++bucket) {
+        if (auto const n = m_buckets[bucket].load(std::memory_order_relaxed); n > 0) {
+            fmt::print(file, "{} {} {}\n", label, lowerBound(bucket), n);
+        }
+    }
+}
+
+/// \details Values below 16 get a bucket each. Above that, the bucket is chosen by the position of the most
+/// \details significant bit, and then by the 4 bits that follow it.
+std::size_t Histogram::bucketOf(std::uint64_t value) noexcept
+{
+    if (value < SubBuckets) {
+        return static_cast<std::size_t>(value);
+    }
+
+    auto const exponent = static_cast<std::size_t>(std::bit_width(value)) - 1;
+    auto const mantissa = static_cast<std::size_t>(value >> (exponent - SubBucketBits)) & (SubBuckets - 1);
+
+    return (exponent - SubBucketBits + 1) * SubBuckets + mantissa;
+}
+
+std::uint64_t Histogram::lowerBound(std::size_t bucket) noexcept
+{
+    if (bucket < SubBuckets) {
+        return bucket;
+    }
+
+    auto const exponent = bucket / SubBuckets + SubBucketBits - 1;
+    auto const mantissa = bucket % SubBuckets;
+
+    return static_cast<std::uint64_t>(SubBuckets + mantissa) << (exponent - SubBucketBits);
+}
+
+void Latency::enable(bool enabled) noexcept
+{
+    m_enabled = enabled;
+    m_inFrame = false;
+}
+
+Histogram const& Latency::histogram(Stage stage) const noexcept
+{
+    return m_histograms[static_cast<std::size_t>(stage)];
+}
+
+std::string Latency::summary() const
+{
+    auto const& total = m_total;
+
+    if (total.count() == 0) {
+        return "lat -";
+    }
+
+    return fmt::format("lat p50 {} p99 {} max {}",
+        formatDuration(total.percentile(0.50)), formatDuration(total.percentile(0.99)), formatDuration(total.max()));
+}
+
+void Latency::dump(std::string const& path) const
+{
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> file { std::fopen(path.c_str(), "w"), &std::fclose };
+
+    if (not file) {
+        throw std::system_error(errno, std::generic_category(), "Could not open the latency log " + path);
+    }
+
+    fmt::print(file.get(), "# stage count p50_ns p90_ns p99_ns max_ns\n");
+
+    auto const summarise = [&file](std::string_view label, Histogram const& hist) {
+        fmt::print(file.get(), "{} {} {} {} {} {}\n",
+            label, hist.count(), hist.percentile(0.50), hist.percentile(0.90), hist.percentile(0.99), hist.max());
+    };
+
+    summarise("total", m_total);
+
+    for (std::size_t stage = 0; stage < StageCount; ++stage) {
+        summarise(StageNames[stage], m_histograms[stage]);
+    }
+
+    fmt::print(file.get(), "# stage bucket_lower_bound_ns count\n");
+    m_total.dump(file.get(), "total");
+
+    for (std::size_t stage = 0; stage < StageCount; ++stage) {
+        m_histograms[stage].dump(file.get(), StageNames[stage]);
+    }
+}
+
+/// \details The time spent in a stage is measured from the previous stamp of the same frame, so a stage that is
+/// \details skipped (e.g. Dispatch when the key could not be read) is folded into the next one
+void Latency::record(Stage stage, Clock::time_point now) noexcept
+{
+    // Repaints that weren't caused by a keypress (e.g. the very first one) aren't part of any frame
+    if (not m_inFrame) {
+        return;
+    }
+
+    auto const elapsed = [](Clock::time_point from, Clock::time_point to) {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    };
+
+    m_histograms[static_cast<std::size_t>(stage)].record(elapsed(m_last, now));
+    m_last = now;
+
+    if (stage == Stage::Write) {
+        m_total.record(elapsed(m_start, now));
+        m_inFrame = false;
+    }
+}
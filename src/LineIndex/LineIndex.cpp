@@ -0,0 +1,141 @@
+#include "LineIndex/LineIndex.hpp"
+
+#include <algorithm>
+#include <array>
+#include <istream>
+#include <limits>
+#include <utility>
+
+namespace
+{
+    /// \brief Decode the LEB128 varint at @p pos, advancing @p pos past it
+    /// \returns The value, or nothing if the varint runs past the end of @p data
+    [[nodiscard]]
+    std::optional<std::uint64_t> decode(std::span<std::uint8_t const> data, std::size_t& pos) noexcept
+    {
+        std::uint64_t value = 0;
+
+        for (unsigned shift = 0; pos < data.size() and shift < 64; shift += 7) {
+            auto const byte = data[pos++];
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+
+        return std::nullopt;
+    }
+}
+
+/**
+ * @brief View a serialised index in place
+ *
+ * Only the sizes are checked up front, so viewing an index of any size takes constant time. A corrupt varint is
+ * treated as a row of length 0 when it is decoded.
+*/
+std::optional<LineIndex> LineIndex::view(std::shared_ptr<void const> storage, std::uint64_t rows, std::uint64_t bytes,
+    std::span<Checkpoint const> checkpoints, std::span<std::uint8_t const> varints)
+{
+    auto const expected = (rows + CheckpointEvery - 1) / CheckpointEvery;
+
+    if (checkpoints.size() != expected or varints.size() < rows or rows > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+        return std::nullopt;
+    }
+
+    LineIndex index;
+    index.m_rows = rows;
+    index.m_bytes = bytes;
+    index.m_storage = std::move(storage);
+    index.m_viewedCheckpoints = checkpoints;
+    index.m_viewedVarints = varints;
+
+    return index;
+}
+
+void LineIndex::append(std::uint64_t length)
+{
+    own();
+
+    if (m_rows % CheckpointEvery == 0) {
+        m_checkpoints.push_back({ m_bytes, m_varints.size() });
+    }
+
+    for (auto value = length; ; value >>= 7) {
+        auto const byte = static_cast<std::uint8_t>(value & 0x7f);
+
+        if (value < 0x80) {
+            m_varints.push_back(byte);
+            break;
+        }
+
+        m_varints.push_back(byte | 0x80);
+    }
+
+    ++m_rows;
+    m_bytes += length;
+}
+
+/// \details The text is scanned for '\n' a chunk at a time, so indexing the tail of a grown file costs a read of
+/// \details the tail only
+void LineIndex::extend(std::istream& in)
+{
+    std::array<char, 1 << 16> chunk;
+    std::uint64_t length = 0;
+
+    while (in) {
+        in.read(chunk.data(), chunk.size());
+        auto const count = static_cast<std::size_t>(in.gcount());
+        auto const* const end = chunk.data() + count;
+
+        for (auto const* pos = chunk.data(); pos != end; ) {
+            auto const* const eol = std::find(pos, end, '\n');
+            length += static_cast<std::uint64_t>(eol - pos);
+
+            if (eol == end) {
+                break;
+            }
+
+            append(length + 1);
+            length = 0;
+            pos = eol + 1;
+        }
+    }
+}
+
+std::uint64_t LineIndex::start(int row) const noexcept
+{
+    if (row <= 0 or m_rows == 0) {
+        return 0;
+    }
+    else if (static_cast<std::uint64_t>(row) >= m_rows) {
+        return m_bytes;
+    }
+
+    auto const index = static_cast<std::size_t>(row) / CheckpointEvery;
+    auto const checkpoint = checkpoints()[index];
+    auto const data = varints();
+
+    auto start = checkpoint.start;
+    auto pos = static_cast<std::size_t>(checkpoint.varint);
+
+    for (auto skipped = index * CheckpointEvery; skipped < static_cast<std::size_t>(row); ++skipped) {
+        start += decode(data, pos).value_or(0);
+    }
+
+    return start;
+}
+
+void LineIndex::own()
+{
+    if (not m_storage) {
+        return;
+    }
+
+    m_checkpoints.assign(m_viewedCheckpoints.begin(), m_viewedCheckpoints.end());
+    m_varints.assign(m_viewedVarints.begin(), m_viewedVarints.end());
+
+    m_storage.reset();
+    m_viewedCheckpoints = {};
+    m_viewedVarints = {};
+}
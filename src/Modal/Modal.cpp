@@ -0,0 +1,704 @@
+#include "Modal/Modal.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <tuple>
+
+namespace
+{
+    /// Counts are capped so that "99999999999j" saturates rather than overflowing
+    constexpr int MaxCount = 100'000'000;
+
+    /// The most text a counted paste inserts, so that "99999999p" doesn't run the editor out of memory; a register
+    /// larger than this is still pasted once
+    constexpr std::size_t MaxPaste = 64 << 20;
+
+    /// \brief The class of a character, for word motions: 0 for blanks, 1 for punctuation, 2 for word characters
+    [[nodiscard]]
+    int charClass(char c) noexcept
+    {
+        auto const byte = static_cast<unsigned char>(c);
+
+        if (std::isspace(byte)) {
+            return 0;
+        }
+        else if (std::isalnum(byte) or c == '_' or byte >= 0x80) {
+            return 2;
+        }
+
+        return 1;
+    }
+
+    /// \brief The class of the character at @p at; the end of a row counts as a blank
+    [[nodiscard]]
+    int classAt(Buffer const& buffer, Position at) noexcept
+    {
+        auto const row = buffer.row(at.y);
+        return at.x < std::ssize(row) ? charClass(row[static_cast<std::size_t>(at.x)]) : 0;
+    }
+
+    [[nodiscard]]
+    bool isEmptyRow(Buffer const& buffer, Position at) noexcept
+    {
+        return at.x == 0 and buffer.rowLength(at.y) == 0;
+    }
+
+    /// \brief Step forward one character, treating the end of each row as a character; false at the end of the text
+    [[nodiscard]]
+    bool next(Buffer const& buffer, Position& at) noexcept
+    {
+        if (at.x < buffer.rowLength(at.y)) {
+            ++at.x;
+            return true;
+        }
+        else if (at.y + 1 < buffer.size()) {
+            at = { 0, at.y + 1 };
+            return true;
+        }
+
+        return false;
+    }
+
+    /// \brief Step back one character, treating the end of each row as a character; false at the start of the text
+    [[nodiscard]]
+    bool prev(Buffer const& buffer, Position& at) noexcept
+    {
+        if (at.x > 0) {
+            --at.x;
+            return true;
+        }
+        else if (at.y > 0) {
+            at = { buffer.rowLength(at.y - 1), at.y - 1 };
+            return true;
+        }
+
+        return false;
+    }
+
+    /// \brief The start of the next word; an empty row counts as a word
+    [[nodiscard]]
+    Position wordForward(Buffer const& buffer, Position at) noexcept
+    {
+        if (auto const cls = classAt(buffer, at); cls != 0) {
+            while (classAt(buffer, at) == cls and next(buffer, at)) {}
+        }
+
+        while (classAt(buffer, at) == 0 and not isEmptyRow(buffer, at) and next(buffer, at)) {}
+
+        return at;
+    }
+
+    /// \brief The start of the current word, or of the previous one if already at the start of a word
+    [[nodiscard]]
+    Position wordBackward(Buffer const& buffer, Position at) noexcept
+    {
+        if (not prev(buffer, at)) {
+            return at;
+        }
+
+        while (classAt(buffer, at) == 0 and not isEmptyRow(buffer, at) and prev(buffer, at)) {}
+
+        auto const cls = classAt(buffer, at);
+
+        for (auto before = at; cls != 0 and prev(buffer, before) and before.y == at.y and classAt(buffer, before) == cls;) {
+            at = before;
+        }
+
+        return at;
+    }
+
+    /// \brief The end of the current word, or of the next one if already at the end of a word
+    [[nodiscard]]
+    Position wordEnd(Buffer const& buffer, Position at) noexcept
+    {
+        if (not next(buffer, at)) {
+            return at;
+        }
+
+        while (classAt(buffer, at) == 0 and next(buffer, at)) {}
+
+        auto const cls = classAt(buffer, at);
+
+        for (auto after = at; cls != 0 and next(buffer, after) and after.y == at.y and classAt(buffer, after) == cls;) {
+            at = after;
+        }
+
+        return at;
+    }
+
+    [[nodiscard]]
+    int firstNonBlank(Buffer const& buffer, int y) noexcept
+    {
+        auto const row = buffer.row(y);
+        return static_cast<int>(std::min(row.find_first_not_of(" \t"), row.size()));
+    }
+}
+
+/// \details A command that throws is dropped along with its count, so the next key starts a new one
+bool Modal::feed(Key key, Buffer& buffer, Cursor& cursor)
+{
+    try {
+        return dispatch(key, buffer, cursor);
+    }
+    catch (...) {
+        reset();
+        throw;
+    }
+}
+
+/**
+ * @brief Run a key pressed in normal or visual mode
+ * @param key The key pressed
+ * @param buffer The buffer to act on
+ * @param cursor The cursor to move
+ * @return Whether the key belonged to the engine
+ *
+ * Every printable key belongs to the engine, even if it isn't bound to anything, so that it is never inserted into
+ * the text by accident. Other keys, such as the arrow keys, are left to the keymap.
+*/
+bool Modal::dispatch(Key key, Buffer& buffer, Cursor& cursor)
+{
+    if (isEscapeKey(key)) {
+        m_mode = Mode::Normal;
+        reset();
+        return true;
+    }
+
+    auto code = static_cast<int>(key);
+
+    // Enter and backspace move the cursor in normal mode, as they do in vi
+    if (isEnterKey(key)) {
+        code = 'j';
+    }
+    else if (isBackspaceKey(key)) {
+        code = 'h';
+    }
+
+    if (code < ' ' or code > '~') {
+        return false;
+    }
+
+    auto c = static_cast<char>(code);
+    m_pending += c;
+
+    // "G" lands on the last row and "zM" folds every block in the file, so they wait for the whole file to be read
+    if (c == 'G' or (m_prefixZ and c == 'M')) {
+        buffer.loadAll();
+    }
+
+    if (m_prefixG) {
+        m_prefixG = false;
+
+        if (c != 'g') {
+            reset();
+            return true;
+        }
+    }
+    else if (c == 'g') {
+        m_prefixG = true;
+        return true;
+    }
+
+    if (m_prefixZ) {
+        m_prefixZ = false;
+        foldCommand(c, m_count, buffer, cursor);
+
+        // "zf" waits for a motion, like any other operator
+        if (m_operator != 'z') {
+            reset();
+        }
+
+        return true;
+    }
+    else if (c == 'z' and m_operator == '\0' and m_folds) {
+        m_prefixZ = true;
+        return true;
+    }
+
+    if (std::isdigit(static_cast<unsigned char>(c)) and (c != '0' or m_count > 0)) {
+        m_count = std::min(m_count * 10 + (c - '0'), MaxCount);
+        return true;
+    }
+
+    // Counts before and after an operator multiply, so "2d3w" deletes six words
+    int count = m_count;
+
+    if (m_operator != '\0' and m_operatorCount > 0) {
+        count = std::min(std::max(count, 1) * m_operatorCount, MaxCount);
+    }
+
+    Motion target {};
+
+    if (m_operator != '\0') {
+        if (c == m_operator) {
+            auto const last = std::max(buffer.size() - 1, 0);
+            auto const y = std::min(cursor.yPos + std::max(count, 1) - 1, last);
+
+            applyOperator(m_operator, Motion { { 0, y }, true }, buffer, cursor);
+        }
+        else {
+            // "cw" on a word changes up to the end of the word, leaving the blanks after it alone
+            if (m_operator == 'c' and c == 'w' and classAt(buffer, cursor.position()) != 0) {
+                c = 'e';
+            }
+
+            if (motion(c, count, buffer, cursor, target)) {
+                applyOperator(m_operator, target, buffer, cursor);
+            }
+        }
+
+        reset();
+        return true;
+    }
+
+    if (m_mode == Mode::Visual and (c == 'd' or c == 'x' or c == 'y' or c == 'c')) {
+        applyToSelection(c == 'x' ? 'd' : c, buffer, cursor);
+        reset();
+        return true;
+    }
+    else if (m_mode == Mode::Visual and c == 'o') {
+        // Swap the ends of the selection
+        auto const anchor = m_anchor;
+        m_anchor = cursor.position();
+        cursor.moveTo(anchor);
+        reset();
+        return true;
+    }
+
+    if (m_mode == Mode::Normal and (c == 'd' or c == 'c' or c == 'y')) {
+        m_operator = c;
+        m_operatorCount = m_count;
+        m_count = 0;
+        return true;
+    }
+
+    if (motion(c, count, buffer, cursor, target)) {
+        cursor.moveTo(target.target);
+    }
+    else if (m_mode == Mode::Normal or c == 'v') {
+        action(c, count, buffer, cursor);
+    }
+
+    reset();
+    return true;
+}
+
+void Modal::enterNormal(Buffer const& buffer, Cursor& cursor) noexcept
+{
+    m_mode = Mode::Normal;
+    reset();
+
+    // Leaving insert mode steps back onto the last character inserted, as in vi
+    if (cursor.xPos > 0) {
+        cursor.xPos = std::min(cursor.xPos - 1, buffer.rowLength(cursor.yPos));
+    }
+}
+
+/**
+ * @brief Compute where a motion lands
+ * @param key The motion key; 'g' stands for "gg"
+ * @param count The count typed before the motion, or 0 if there wasn't one
+ * @param buffer The buffer the motion moves through
+ * @param cursor Where the motion starts
+ * @param[out] result Where the motion lands
+ * @return Whether @p key is a motion
+ *
+ * Line and column motions jump straight to their target whatever the count; only word motions have to walk the
+ * text, one word at a time.
+*/
+bool Modal::motion(char key, int count, Buffer const& buffer, Cursor const& cursor, Motion& result) const
+{
+    auto const n = std::max(count, 1);
+    auto const at = cursor.position();
+    auto const last = std::max(buffer.size() - 1, 0);
+
+    auto const onRow = [&buffer, &at](int y) {
+        return Position { std::min(at.x, buffer.rowLength(y)), y };
+    };
+
+    auto const repeat = [n, &buffer, at](auto step) {
+        auto to = at;
+
+        for (int i = 0; i < n; ++i) {
+            to = step(buffer, to);
+        }
+
+        return to;
+    };
+
+    switch (key) {
+    case 'h':
+        result = { { std::max(at.x - n, 0), at.y } };
+        return true;
+
+    case 'l':
+        result = { { std::min(at.x + n, buffer.rowLength(at.y)), at.y } };
+        return true;
+
+    case 'j':
+        result = { onRow(rowsAway(buffer, at.y, n)), true };
+        return true;
+
+    case 'k':
+        result = { onRow(rowsAway(buffer, at.y, -n)), true };
+        return true;
+
+    case '0':
+        result = { { 0, at.y } };
+        return true;
+
+    case '^':
+        result = { { firstNonBlank(buffer, at.y), at.y } };
+        return true;
+
+    case '$': {
+        auto const y = std::min(at.y + n - 1, last);
+        result = { { buffer.rowLength(y), y } };
+        return true;
+    }
+
+    case 'w':
+        result = { repeat(wordForward) };
+        return true;
+
+    case 'b':
+        result = { repeat(wordBackward) };
+        return true;
+
+    case 'e':
+        result = { repeat(wordEnd), false, true };
+        return true;
+
+    case 'g':
+    case 'G': {
+        auto const fallback = key == 'G' ? last : 0;
+        auto const y = count > 0 ? std::min(count - 1, last) : fallback;
+
+        result = { { firstNonBlank(buffer, y), y }, true };
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+void Modal::applyOperator(char op, Motion const& motion, Buffer& buffer, Cursor& cursor)
+{
+    auto from = cursor.position();
+    auto to = motion.target;
+
+    if (std::tie(to.y, to.x) < std::tie(from.y, from.x)) {
+        std::swap(from, to);
+    }
+
+    // A closed fold at the end of the rows an operator acts on is taken in whole
+    if (auto const fold = m_folds ? m_folds->at(to.y) : std::nullopt; fold and motion.linewise) {
+        to.y = fold->last;
+    }
+
+    if (op == 'z') {
+        m_folds->fold(from.y, to.y);
+        cursor.moveTo({ std::min(cursor.xPos, buffer.rowLength(from.y)), from.y });
+        return;
+    }
+
+    if (motion.linewise) {
+        if (buffer.size() == 0) {
+            return;
+        }
+
+        auto const y0 = from.y;
+        auto const y1 = std::min(to.y, buffer.size() - 1);
+
+        m_register = buffer.text({ 0, y0 }, { buffer.rowLength(y1), y1 });
+        m_registerLinewise = true;
+
+        if (op == 'd') {
+            buffer.eraseRows(y0, y1 - y0 + 1);
+
+            auto const y = std::min(y0, std::max(buffer.size() - 1, 0));
+            cursor.moveTo({ firstNonBlank(buffer, y), y });
+        }
+        else if (op == 'c') {
+            buffer.erase({ 0, y0 }, { buffer.rowLength(y1), y1 });
+            cursor.moveTo({ 0, y0 });
+            m_mode = Mode::Insert;
+        }
+        else {
+            cursor.moveTo({ std::min(cursor.xPos, buffer.rowLength(y0)), y0 });
+        }
+
+        return;
+    }
+
+    if (motion.inclusive) {
+        to.x = std::min(to.x + 1, buffer.rowLength(to.y));
+    }
+    else if (to.x == 0 and to.y > from.y) {
+        // An exclusive motion that ends at the start of a row stops at the end of the row before, as in vi
+        to = { buffer.rowLength(to.y - 1), to.y - 1 };
+    }
+
+    m_register = buffer.text(from, to);
+    m_registerLinewise = false;
+
+    if (op == 'd' or op == 'c') {
+        buffer.erase(from, to);
+    }
+
+    cursor.moveTo(from);
+
+    if (op == 'c') {
+        m_mode = Mode::Insert;
+    }
+}
+
+bool Modal::action(char key, int count, Buffer& buffer, Cursor& cursor)
+{
+    auto const n = std::max(count, 1);
+    auto const at = cursor.position();
+
+    switch (key) {
+    case 'x':
+        applyOperator('d', Motion { { std::min(at.x + n, buffer.rowLength(at.y)), at.y } }, buffer, cursor);
+        return true;
+
+    case 'X':
+        applyOperator('d', Motion { { std::max(at.x - n, 0), at.y } }, buffer, cursor);
+        return true;
+
+    case 'D':
+    case 'C': {
+        auto const y = std::min(at.y + n - 1, std::max(buffer.size() - 1, 0));
+        applyOperator(key == 'D' ? 'd' : 'c', Motion { { buffer.rowLength(y), y } }, buffer, cursor);
+        return true;
+    }
+
+    case 'Y': {
+        auto const y = std::min(at.y + n - 1, std::max(buffer.size() - 1, 0));
+        applyOperator('y', Motion { { 0, y }, true }, buffer, cursor);
+        return true;
+    }
+
+    case 'p':
+    case 'P':
+        paste(key == 'p', n, buffer, cursor);
+        return true;
+
+    case 'a':
+        cursor.xPos = std::min(at.x + 1, buffer.rowLength(at.y));
+        m_mode = Mode::Insert;
+        return true;
+
+    case 'I':
+        cursor.xPos = firstNonBlank(buffer, at.y);
+        m_mode = Mode::Insert;
+        return true;
+
+    case 'A':
+        cursor.xPos = buffer.rowLength(at.y);
+        m_mode = Mode::Insert;
+        return true;
+
+    case 'i':
+        m_mode = Mode::Insert;
+        return true;
+
+    case 'o':
+        buffer.insert({ buffer.rowLength(at.y), at.y }, "\n");
+        cursor.moveTo({ 0, at.y + 1 });
+        m_mode = Mode::Insert;
+        return true;
+
+    case 'O':
+        buffer.insert({ 0, at.y }, "\n");
+        cursor.moveTo({ 0, at.y });
+        m_mode = Mode::Insert;
+        return true;
+
+    case 'u':
+        for (int i = 0; i < n; ++i) {
+            if (auto const where = buffer.undo()) {
+                cursor.moveTo(*where);
+            }
+        }
+
+        return true;
+
+    case 'v':
+        if (m_mode == Mode::Visual) {
+            m_mode = Mode::Normal;
+        }
+        else {
+            m_mode = Mode::Visual;
+            m_anchor = at;
+        }
+
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Run a fold command
+ * @param key The key typed after 'z'
+ * @param count The count typed before the 'z', or 0 if there wasn't one
+ * @param buffer The buffer the folds are in
+ * @param cursor The cursor; it is moved off any rows folded away
+*/
+void Modal::foldCommand(char key, int count, Buffer const& buffer, Cursor& cursor)
+{
+    auto const y = cursor.yPos;
+
+    switch (key) {
+    case 'f':
+        if (m_mode == Mode::Visual) {
+            m_folds->fold(std::min(y, m_anchor.y), std::max(y, m_anchor.y));
+            m_mode = Mode::Normal;
+        }
+        else {
+            m_operator = 'z';
+            m_operatorCount = m_count;
+            m_count = 0;
+        }
+
+        break;
+
+    case 'F':
+        m_folds->fold(y, std::min(y + std::max(count, 1) - 1, buffer.size() - 1));
+        break;
+
+    case 'c':
+        m_folds->foldIndented(buffer, y);
+        break;
+
+    case 'o':
+        m_folds->unfold(y);
+        break;
+
+    case 'a':
+        if (not m_folds->unfold(y)) {
+            m_folds->foldIndented(buffer, y);
+        }
+
+        break;
+
+    case 'M':
+        m_folds->foldAllIndented(buffer);
+        break;
+
+    case 'R':
+    case 'E':
+        m_folds->clear();
+        break;
+
+    default:
+        break;
+    }
+
+    if (auto const visible = m_folds->visible(cursor.yPos); visible != cursor.yPos) {
+        cursor.moveTo({ std::min(cursor.xPos, buffer.rowLength(visible)), visible });
+    }
+}
+
+int Modal::rowsAway(Buffer const& buffer, int y, int count) const noexcept
+{
+    auto const last = std::max(buffer.size() - 1, 0);
+
+    if (not m_folds) {
+        return std::clamp(y + count, 0, last);
+    }
+
+    return m_folds->visible(std::min(m_folds->step(y, count), last));
+}
+
+/// \details The selection includes the characters under both the anchor and the cursor
+void Modal::applyToSelection(char op, Buffer& buffer, Cursor& cursor)
+{
+    auto from = m_anchor;
+    auto to = cursor.position();
+
+    if (std::tie(to.y, to.x) < std::tie(from.y, from.x)) {
+        std::swap(from, to);
+    }
+
+    cursor.moveTo(from);
+    m_mode = Mode::Normal;
+
+    // Selecting the end of a row selects the row break too
+    if (to.x >= buffer.rowLength(to.y) and to.y + 1 < buffer.size()) {
+        to = { 0, to.y + 1 };
+    }
+    else {
+        to.x = std::min(to.x + 1, buffer.rowLength(to.y));
+    }
+
+    m_register = buffer.text(from, to);
+    m_registerLinewise = false;
+
+    if (op == 'd' or op == 'c') {
+        buffer.erase(from, to);
+    }
+
+    if (op == 'c') {
+        m_mode = Mode::Insert;
+    }
+}
+
+void Modal::paste(bool after, int count, Buffer& buffer, Cursor& cursor)
+{
+    if (m_register.empty() and not m_registerLinewise) {
+        return;
+    }
+
+    auto const most = std::max<std::size_t>(MaxPaste / (m_register.size() + 1), 1);
+    count = static_cast<int>(std::min(static_cast<std::size_t>(count), most));
+
+    std::string text;
+    text.reserve((m_register.size() + 1) * static_cast<std::size_t>(count));
+
+    for (int i = 0; i < count; ++i) {
+        if (m_registerLinewise and i > 0) {
+            text += '\n';
+        }
+
+        text += m_register;
+    }
+
+    auto const at = cursor.position();
+
+    if (m_registerLinewise) {
+        if (buffer.size() == 0) {
+            buffer.insert({ 0, 0 }, text);
+            cursor.moveTo({ 0, 0 });
+        }
+        else if (after) {
+            buffer.insert({ buffer.rowLength(at.y), at.y }, "\n" + text);
+            cursor.moveTo({ firstNonBlank(buffer, at.y + 1), at.y + 1 });
+        }
+        else {
+            buffer.insert({ 0, at.y }, text + "\n");
+            cursor.moveTo({ firstNonBlank(buffer, at.y), at.y });
+        }
+
+        return;
+    }
+
+    auto const where = after ? Position { std::min(at.x + 1, buffer.rowLength(at.y)), at.y } : at;
+    auto const end = buffer.insert(where, text);
+
+    cursor.moveTo({ std::max(end.x - 1, 0), end.y });
+}
+
+void Modal::reset() noexcept
+{
+    m_count = 0;
+    m_operatorCount = 0;
+    m_operator = '\0';
+    m_prefixG = false;
+    m_prefixZ = false;
+    m_pending.clear();
+}
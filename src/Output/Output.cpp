@@ -0,0 +1,110 @@
+#include "Output/Output.hpp"
+
+#include <write/write.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+using namespace kilo::lib;
+
+/**
+ * @brief Open the terminal behind a file descriptor for non-blocking writes
+ * @param fd The file descriptor the terminal is normally written through, e.g. STDOUT_FILENO
+*/
+Output::Output(int fd) noexcept : m_fd(fd)
+{
+    std::array<char, 256> name {};
+
+    if (::isatty(fd) and ::ttyname_r(fd, name.data(), name.size()) == 0) {
+        if (auto const tty = ::open(name.data(), O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC); tty != -1) {
+            m_fd = tty;
+            m_owned = true;
+        }
+    }
+}
+
+Output::~Output()
+{
+    if (m_owned) {
+        ::close(m_fd);
+    }
+}
+
+/**
+ * @brief Queue a frame for output
+ * @param frame The frame; if another frame is already waiting its turn, this one replaces it
+*/
+void Output::submit(std::string frame)
+{
+    if (not pending()) {
+        m_current = std::move(frame);
+        m_written = 0;
+    }
+    else {
+        if (m_hasNext) {
+            ++m_dropped;
+        }
+
+        m_next = std::move(frame);
+        m_hasNext = true;
+    }
+
+    flush();
+}
+
+void Output::flush()
+{
+    while (true) {
+        while (m_written < m_current.size()) {
+            auto const rv = write::writeSome(m_fd, m_current.data() + m_written, m_current.size() - m_written);
+
+            if (rv == 0) {
+                return;
+            }
+
+            m_written += static_cast<std::size_t>(rv);
+        }
+
+        if (not m_hasNext) {
+            return;
+        }
+
+        m_current = std::move(m_next);
+        m_next.clear();
+        m_hasNext = false;
+        m_written = 0;
+    }
+}
+
+void Output::finish(std::chrono::milliseconds timeout) noexcept
+{
+    m_next.clear();
+    m_hasNext = false;
+
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+
+    try {
+        for (flush(); pending(); flush()) {
+            auto const left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd pfd { m_fd, POLLOUT, 0 };
+
+            if (left.count() <= 0 or ::poll(&pfd, 1, static_cast<int>(left.count())) == 0) {
+                return;
+            }
+        }
+    }
+    catch (std::system_error const&) {
+        // The terminal is gone, so there is nobody left to show the rest of the frame to
+    }
+}
+
+bool Output::pending() const noexcept
+{
+    return m_written < m_current.size() or m_hasNext;
+}
@@ -0,0 +1,378 @@
+#include "Session/Session.hpp"
+#include "Compressed/Compressed.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <fmt/core.h>
+
+#include <zlib.h>
+
+namespace
+{
+    constexpr std::array<char, 8> Magic { 'K', 'I', 'L', 'O', 'I', 'D', 'X', '2' };
+
+    /// \brief The most text deflate refers back to, and so the longest window an access point may have
+    constexpr std::size_t MaxWindow = 32 * 1024;
+
+    /// \brief How much deflate can shrink its input at most, which bounds the seek index a sidecar can unpack into
+    constexpr std::uint64_t MaxDeflateRatio = 1032;
+
+    /// \brief The fixed-size start of a sidecar; it is followed by the checkpoints and the varints of the index, and
+    /// \brief then by the seek index, packed as PackedPoints and zlib-compressed
+    struct Header
+    {
+        std::array<char, 8> magic;
+        std::uint64_t size;
+        std::int64_t mtime;
+        std::uint64_t inode;
+        std::uint64_t device;
+        std::int32_t cursorX;
+        std::int32_t cursorY;
+        std::int32_t offsetX;
+        std::int32_t offsetY;
+        std::uint64_t rows;
+        std::uint64_t bytes;
+        std::uint64_t checkpoints;
+        std::uint64_t varints;
+        std::uint64_t seekPoints;
+        std::uint64_t seekSize;     /// The size of the packed seek index
+        std::uint64_t seekBytes;    /// The size of the packed seek index once compressed
+    };
+
+    /// \brief The fixed-size part of an access point of the seek index; its window follows it
+    struct PackedPoint
+    {
+        std::uint64_t out;
+        std::uint64_t in;
+        std::uint64_t skip;
+        std::uint32_t bits;
+        std::uint32_t window;
+    };
+
+    // The checkpoints that follow the header are read in place, so they must be suitably aligned
+    static_assert(sizeof(Header) % alignof(LineIndex::Checkpoint) == 0);
+
+    /// \brief Map a whole file into memory, read-only
+    /// \returns The mapping, which is unmapped once the last copy of it is gone, and its size; or nothing on failure
+    std::optional<std::pair<std::shared_ptr<void const>, std::size_t>> map(std::filesystem::path const& path) noexcept
+    {
+        auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (fd == -1) {
+            return std::nullopt;
+        }
+
+        struct ::stat info {};
+        void* address = MAP_FAILED;
+        std::size_t size = 0;
+
+        if (::fstat(fd, &info) == 0 and info.st_size > 0) {
+            size = static_cast<std::size_t>(info.st_size);
+            address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+
+        ::close(fd);
+
+        if (address == MAP_FAILED) {
+            return std::nullopt;
+        }
+
+        try {
+            std::shared_ptr<void const> mapping { address, [size](void const* mapped) {
+                ::munmap(const_cast<void*>(mapped), size);
+            } };
+
+            return std::make_pair(std::move(mapping), size);
+        }
+        catch (std::bad_alloc const&) {
+            ::munmap(address, size);
+            return std::nullopt;
+        }
+    }
+
+    /// \returns The access points of @p index packed one after the other, zlib-compressed, and their size before
+    /// \returns compression
+    std::pair<std::vector<Bytef>, std::uint64_t> pack(SeekIndex const& index)
+    {
+        std::string packed;
+
+        for (auto const& point : index.points) {
+            PackedPoint const fixed {
+                point.out, point.in, point.skip,
+                static_cast<std::uint32_t>(point.bits), static_cast<std::uint32_t>(point.window.size()),
+            };
+
+            packed.append(reinterpret_cast<char const*>(&fixed), sizeof(fixed));
+            packed.append(point.window.begin(), point.window.end());
+        }
+
+        std::vector<Bytef> compressed(::compressBound(packed.size()));
+        auto size = static_cast<uLongf>(compressed.size());
+
+        if (::compress2(compressed.data(), &size, reinterpret_cast<Bytef const*>(packed.data()), packed.size(), Z_BEST_SPEED) != Z_OK) {
+            throw std::bad_alloc {};
+        }
+
+        compressed.resize(size);
+        return { std::move(compressed), packed.size() };
+    }
+
+    /// \returns The seek index of @p count access points packed by pack into @p compressed, or nullptr if it is not
+    /// \returns a valid index of a file of @p fileSize bytes
+    std::shared_ptr<SeekIndex> unpack(std::span<std::uint8_t const> compressed, std::uint64_t size, std::uint64_t count,
+        std::uint64_t fileSize)
+    {
+        if (count == 0 or size > compressed.size() * MaxDeflateRatio or size < count * sizeof(PackedPoint)) {
+            return nullptr;
+        }
+
+        std::vector<std::uint8_t> packed(static_cast<std::size_t>(size));
+        auto unpacked = static_cast<uLongf>(packed.size());
+
+        if (::uncompress(packed.data(), &unpacked, compressed.data(), compressed.size()) != Z_OK or unpacked != size) {
+            return nullptr;
+        }
+
+        auto index = std::make_shared<SeekIndex>();
+        index->points.clear();
+        index->complete = true;
+
+        for (std::size_t at = 0; at < packed.size(); ) {
+            PackedPoint fixed;
+
+            if (packed.size() - at < sizeof(fixed)) {
+                return nullptr;
+            }
+
+            std::memcpy(&fixed, packed.data() + at, sizeof(fixed));
+            at += sizeof(fixed);
+
+            auto const ordered = index->points.empty() ? fixed.out == 0 : fixed.out >= index->points.back().out;
+
+            if (not ordered or fixed.in > fileSize or fixed.bits > 7 or fixed.window > MaxWindow or packed.size() - at < fixed.window) {
+                return nullptr;
+            }
+
+            index->points.push_back({
+                fixed.out, fixed.in, static_cast<int>(fixed.bits), fixed.skip,
+                { packed.begin() + static_cast<std::ptrdiff_t>(at), packed.begin() + static_cast<std::ptrdiff_t>(at + fixed.window) },
+            });
+            at += fixed.window;
+        }
+
+        return index->points.size() == count ? index : nullptr;
+    }
+
+    /// \returns Whether the byte at @p offset in the text of @p file is a '\n'
+    bool newlineAt(std::filesystem::path const& file, std::uint64_t offset)
+    {
+        auto const in = compressed::openForReading(file, compressed::detect(file));
+        char c = '\0';
+
+        return in->seekg(static_cast<std::streamoff>(offset)) and in->get(c) and c == '\n';
+    }
+}
+
+FileStamp FileStamp::of(std::filesystem::path const& path)
+{
+    struct ::stat info {};
+
+    if (::stat(path.c_str(), &info) == -1) {
+        throw std::system_error(errno, std::generic_category(), "Could not examine file " + path.string());
+    }
+
+    return FileStamp {
+        static_cast<std::uint64_t>(info.st_size),
+        static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1'000'000'000 + info.st_mtim.tv_nsec,
+        static_cast<std::uint64_t>(info.st_ino),
+        static_cast<std::uint64_t>(info.st_dev),
+    };
+}
+
+/// \details The sidecar is named after the file, followed by a hash of its absolute path to tell apart files of the
+/// \details same name
+std::optional<std::filesystem::path> Session::sidecarFor(std::filesystem::path const& file)
+{
+    std::filesystem::path directory;
+
+    if (char const* dir = std::getenv("KILO_SESSION_DIR")) {
+        if (*dir == '\0') {
+            return std::nullopt;
+        }
+
+        directory = dir;
+    }
+    else if (char const* cache = std::getenv("XDG_CACHE_HOME"); cache and *cache) {
+        directory = std::filesystem::path { cache } / "kilo";
+    }
+    else if (char const* home = std::getenv("HOME"); home and *home) {
+        directory = std::filesystem::path { home } / ".cache" / "kilo";
+    }
+    else {
+        return std::nullopt;
+    }
+
+    std::error_code err;
+    auto const absolute = std::filesystem::absolute(file, err);
+
+    if (err) {
+        return std::nullopt;
+    }
+
+    auto const hash = std::hash<std::string> {}(absolute.string());
+    return directory / fmt::format("{}-{:016x}.idx", absolute.filename().string(), hash);
+}
+
+/**
+ * @brief Restore the session of a file
+ *
+ * The sidecar is memory-mapped and the index used in place. The file is checked against the stamp it was indexed at:
+ * - if it is unchanged, the index is used as it is;
+ * - if it is the same file, has grown, and the indexed rows still end in a '\n', only the appended tail is indexed
+ *   (for a compressed file, the text up to the tail is decompressed again, but not indexed);
+ * - otherwise the index is dropped.
+*/
+std::optional<Session> Session::restore(std::filesystem::path const& file, std::filesystem::path const& sidecar)
+{
+    auto mapped = map(sidecar);
+
+    if (not mapped or mapped->second < sizeof(Header)) {
+        return std::nullopt;
+    }
+
+    auto const& [mapping, size] = *mapped;
+    auto const* const data = static_cast<std::uint8_t const*>(mapping.get());
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    auto const checkpointBytes = header.checkpoints * sizeof(LineIndex::Checkpoint);
+    bool const sized = header.checkpoints <= size and header.varints <= size and header.seekBytes <= size
+        and sizeof(Header) + checkpointBytes + header.varints + header.seekBytes == size;
+
+    if (header.magic != Magic or not sized) {
+        return std::nullopt;
+    }
+
+    std::span const checkpoints { reinterpret_cast<LineIndex::Checkpoint const*>(data + sizeof(Header)), header.checkpoints };
+    std::span const varints { data + sizeof(Header) + checkpointBytes, header.varints };
+
+    auto index = LineIndex::view(mapping, header.rows, header.bytes, checkpoints, varints);
+
+    if (not index) {
+        return std::nullopt;
+    }
+
+    Session session {
+        FileStamp { header.size, header.mtime, header.inode, header.device },
+        Position { header.cursorX, header.cursorY },
+        Position { header.offsetX, header.offsetY },
+        std::move(*index),
+    };
+
+    if (header.seekPoints > 0) {
+        std::span const seekIndex { varints.data() + varints.size(), header.seekBytes };
+        session.seekIndex = unpack(seekIndex, header.seekSize, header.seekPoints, header.size);
+    }
+
+    try {
+        auto const current = FileStamp::of(file);
+
+        if (current == session.stamp) {
+            return session;
+        }
+
+        bool const grown = current.inode == session.stamp.inode and current.device == session.stamp.device
+            and current.size > session.stamp.size and session.index.bytes() <= session.stamp.size
+            and (session.index.bytes() == 0 or newlineAt(file, session.index.bytes() - 1));
+
+        if (grown) {
+            auto const in = compressed::openForReading(file, compressed::detect(file));
+            in->seekg(static_cast<std::streamoff>(session.index.bytes()));
+            session.index.extend(*in);
+        }
+        else {
+            session.index = LineIndex {};
+        }
+
+        // The access points at the end of the text a grown file had can't be told from those of the text it has now
+        session.seekIndex = nullptr;
+        session.stamp = current;
+        return session;
+    }
+    catch (std::system_error const&) {
+        return std::nullopt;
+    }
+}
+
+void Session::save(std::filesystem::path const& sidecar) const
+{
+    std::error_code err;
+    std::filesystem::create_directories(sidecar.parent_path(), err);
+
+    if (err) {
+        throw std::system_error(err, "Could not create directory " + sidecar.parent_path().string());
+    }
+
+    auto const checkpoints = index.checkpoints();
+    auto const varints = index.varints();
+    auto const packSeekIndex = seekIndex and seekIndex->complete;
+    auto const [seekIndexBytes, seekSize] = packSeekIndex ? pack(*seekIndex) : std::pair<std::vector<Bytef>, std::uint64_t> {};
+
+    Header const header {
+        Magic,
+        stamp.size, stamp.mtime, stamp.inode, stamp.device,
+        cursor.x, cursor.y, offset.x, offset.y,
+        static_cast<std::uint64_t>(index.rows()), index.bytes(), checkpoints.size(), varints.size(),
+        packSeekIndex ? seekIndex->points.size() : 0, seekSize, seekIndexBytes.size(),
+    };
+
+    auto temporary = sidecar;
+    temporary += ".kilo-save";
+
+    {
+        std::ofstream out { temporary, std::ios::binary | std::ios::trunc };
+        out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        out.write(reinterpret_cast<char const*>(checkpoints.data()), static_cast<std::streamsize>(checkpoints.size_bytes()));
+        out.write(reinterpret_cast<char const*>(varints.data()), static_cast<std::streamsize>(varints.size_bytes()));
+        out.write(reinterpret_cast<char const*>(seekIndexBytes.data()), static_cast<std::streamsize>(seekIndexBytes.size()));
+
+        if (not out.flush()) {
+            throw std::system_error(errno, std::generic_category(), "Could not write file " + temporary.string());
+        }
+    }
+
+    std::filesystem::rename(temporary, sidecar, err);
+
+    if (err) {
+        std::filesystem::remove(temporary, err);
+        throw std::system_error(err, "Could not replace file " + sidecar.string());
+    }
+}
+
+LineIndex Session::indexOf(Buffer const& buffer)
+{
+    LineIndex index;
+    auto const rows = buffer.endsWithNewline() ? buffer.size() : buffer.size() - 1;
+
+    for (int y = 0; y < rows; ++y) {
+        index.append(buffer.rowBytes(y));
+    }
+
+    return index;
+}
@@ -44,6 +44,8 @@ Terminal::~Terminal()
     Expects(m_state == TerminalState::Raw or m_state == TerminalState::Reset);
 
     if (m_state == TerminalState::Raw) {
+        [[maybe_unused]] auto const bracketed = ::write(STDOUT_FILENO, "\x1b[?2004l", 8);
+
         // Attempt to set the terminal driver settings to those in m_terminal
         // If this fails, log the error that occured and exit the program with status EXIT_FAILURE
         if (errno = 0; tcsetattr(STDIN_FILENO, TCSAFLUSH, &m_terminal) == -1) {
@@ -96,6 +98,10 @@ void Terminal::enableRawMode()
 
     m_state = TerminalState::Raw;
 
+    // Ask the terminal to bracket pasted text with ESC [ 200 ~ and ESC [ 201 ~, so that a paste can be told apart
+    // from typing and inserted in one go. Terminals that don't support it ignore the request.
+    [[maybe_unused]] auto const bracketed = ::write(STDOUT_FILENO, "\x1b[?2004h", 8);
+
     Ensures(m_state == TerminalState::Raw);
 }
 
@@ -0,0 +1,386 @@
+#include "TextFormat/TextFormat.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#if defined(__x86_64__)
+    // What can be wrong with a pair of consecutive bytes, one bit per error. The tables below map the high and low
+    // nibbles of the first byte and the high nibble of the second to the errors they allow; a pair is in error if
+    // all three allow the same one. TwoConts is not an error in itself: it is checked against the third and fourth
+    // bytes of multibyte characters, which are the only places two continuation bytes in a row may be.
+    constexpr std::uint8_t TooShort = 1 << 0;       // a lead byte followed by ASCII or another lead byte
+    constexpr std::uint8_t TooLong = 1 << 1;        // ASCII followed by a continuation byte
+    constexpr std::uint8_t Overlong3 = 1 << 2;      // 11100000 100_____
+    constexpr std::uint8_t TooLarge = 1 << 3;       // 11110100 1001____, 11110100 101_____ and above
+    constexpr std::uint8_t Surrogate = 1 << 4;      // 11101101 101_____
+    constexpr std::uint8_t Overlong2 = 1 << 5;      // 1100000_ 10______
+    constexpr std::uint8_t TooLarge1000 = 1 << 6;   // 11110101 1000____ and above
+    constexpr std::uint8_t Overlong4 = 1 << 6;      // 11110000 1000____
+    constexpr std::uint8_t TwoConts = 1 << 7;       // 10______ 10______
+    constexpr std::uint8_t Carry = TooShort | TooLong | TwoConts;
+
+    alignas(16) constexpr std::array<std::uint8_t, 16> Byte1High {
+        TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+        TwoConts, TwoConts, TwoConts, TwoConts,
+        TooShort | Overlong2,
+        TooShort,
+        TooShort | Overlong3 | Surrogate,
+        TooShort | TooLarge | TooLarge1000 | Overlong4,
+    };
+
+    alignas(16) constexpr std::array<std::uint8_t, 16> Byte1Low {
+        Carry | Overlong3 | Overlong2 | Overlong4,
+        Carry | Overlong2,
+        Carry,
+        Carry,
+        Carry | TooLarge,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000 | Surrogate,
+        Carry | TooLarge | TooLarge1000,
+        Carry | TooLarge | TooLarge1000,
+    };
+
+    alignas(16) constexpr std::array<std::uint8_t, 16> Byte2High {
+        TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+        TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4,
+        TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge,
+        TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+        TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+        TooShort, TooShort, TooShort, TooShort,
+    };
+
+    /// The largest values the last three bytes of a block can have without starting a character that runs on
+    alignas(16) constexpr std::array<std::uint8_t, 16> MaxTail {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf,
+    };
+
+    __attribute__((target("ssse3")))
+    __m128i load(std::uint8_t const* data) noexcept
+    {
+        return _mm_loadu_si128(reinterpret_cast<__m128i const*>(data));
+    }
+
+    __attribute__((target("ssse3")))
+    void store(std::uint8_t* data, __m128i value) noexcept
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data), value);
+    }
+
+    /// \returns The high nibble of every byte of @p value
+    __attribute__((target("ssse3")))
+    __m128i highNibbles(__m128i value) noexcept
+    {
+        return _mm_and_si128(_mm_srli_epi16(value, 4), _mm_set1_epi8(0x0f));
+    }
+
+    /**
+     * @brief Check whole 16-byte blocks of UTF-8
+     * @param previous The block before the first one, which the first one's characters may have started in
+     * @param error Accumulates the errors found
+     * @param incomplete Set to the bytes of the last block that start a character that runs on past it
+     *
+     * A block of ASCII only needs checking for a character the block before it left unfinished.
+    */
+    __attribute__((target("ssse3")))
+    void checkBlocks(std::uint8_t const* data, std::size_t blocks, std::uint8_t* previous, std::uint8_t* error,
+        std::uint8_t* incomplete) noexcept
+    {
+        auto const byte1High = load(Byte1High.data());
+        auto const byte1Low = load(Byte1Low.data());
+        auto const byte2High = load(Byte2High.data());
+        auto const maxTail = load(MaxTail.data());
+
+        auto prev = load(previous);
+        auto err = load(error);
+        auto inc = load(incomplete);
+
+        for (std::size_t block = 0; block < blocks; ++block, data += 16) {
+            auto const input = load(data);
+
+            if (_mm_movemask_epi8(input) == 0) {
+                err = _mm_or_si128(err, inc);
+                inc = _mm_setzero_si128();
+            }
+            else {
+                auto const prev1 = _mm_alignr_epi8(input, prev, 15);
+                auto const prev2 = _mm_alignr_epi8(input, prev, 14);
+                auto const prev3 = _mm_alignr_epi8(input, prev, 13);
+
+                auto const special = _mm_and_si128(
+                    _mm_and_si128(_mm_shuffle_epi8(byte1High, highNibbles(prev1)),
+                        _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, _mm_set1_epi8(0x0f)))),
+                    _mm_shuffle_epi8(byte2High, highNibbles(input)));
+
+                // The third byte of a three- or four-byte character, or the fourth of a four-byte one, must be a
+                // continuation byte following another
+                auto const third = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+                auto const fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+                auto const mustBeTwoConts = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+
+                err = _mm_or_si128(err, _mm_xor_si128(mustBeTwoConts, special));
+                inc = _mm_subs_epu8(input, maxTail);
+            }
+
+            prev = input;
+        }
+
+        store(previous, prev);
+        store(error, err);
+        store(incomplete, inc);
+    }
+
+    bool hasSsse3() noexcept
+    {
+        static bool const supported = __builtin_cpu_supports("ssse3");
+        return supported;
+    }
+#else
+    bool hasSsse3() noexcept
+    {
+        return false;
+    }
+#endif
+
+    [[nodiscard]]
+    bool isZero(std::array<std::uint8_t, 16> const& bytes) noexcept
+    {
+        return std::all_of(bytes.begin(), bytes.end(), [](std::uint8_t byte) { return byte == 0; });
+    }
+}
+
+TextFormat TextFormat::detect(std::string_view start, bool complete) noexcept
+{
+    TextFormat format;
+    format.bom = start.starts_with(Bom);
+
+    auto const eol = start.find_first_of("\r\n");
+
+    if (eol != std::string_view::npos and start[eol] == '\r') {
+        if (eol + 1 < start.size()) {
+            format.lineEnding = start[eol + 1] == '\n' ? LineEnding::CRLF : LineEnding::CR;
+        }
+        else {
+            // The '\n' that would follow hasn't been read; CRLF is far more likely than a file of CRs
+            format.lineEnding = complete ? LineEnding::CR : LineEnding::CRLF;
+        }
+    }
+
+    return format;
+}
+
+std::string_view TextFormat::terminator() const noexcept
+{
+    switch (lineEnding) {
+    case LineEnding::CRLF:
+        return "\r\n";
+
+    case LineEnding::CR:
+        return "\r";
+
+    case LineEnding::LF:
+        break;
+    }
+
+    return "\n";
+}
+
+std::string TextFormat::describe() const
+{
+    std::string description;
+
+    auto const add = [&description](std::string_view part) {
+        if (not description.empty()) {
+            description += ' ';
+        }
+
+        description += part;
+    };
+
+    if (lineEnding == LineEnding::CRLF) {
+        add("CRLF");
+    }
+    else if (lineEnding == LineEnding::CR) {
+        add("CR");
+    }
+
+    if (encoding == Encoding::Latin1) {
+        add("Latin-1");
+    }
+
+    if (bom) {
+        add("BOM");
+    }
+
+    return description;
+}
+
+Utf8Validator::Utf8Validator() noexcept
+    : m_simd { hasSsse3() }
+{
+}
+
+/// \details With SSSE3, the bytes left over after the last whole block of a piece are only checked once the next piece
+/// \details or finish completes their block, so the answer may lag the text by up to 15 bytes
+bool Utf8Validator::feed(std::string_view text) noexcept
+{
+    if (not m_simd) {
+        feedBytes(text);
+        return m_valid;
+    }
+
+#if defined(__x86_64__)
+    auto const* data = reinterpret_cast<std::uint8_t const*>(text.data());
+    auto size = text.size();
+
+    if (m_pendingSize > 0) {
+        auto const taken = std::min(size, m_pending.size() - m_pendingSize);
+        std::copy_n(data, taken, m_pending.data() + m_pendingSize);
+        m_pendingSize += taken;
+        data += taken;
+        size -= taken;
+
+        if (m_pendingSize < m_pending.size()) {
+            return m_valid;
+        }
+
+        feedBlocks(m_pending.data(), 1);
+        m_pendingSize = 0;
+    }
+
+    feedBlocks(data, size / 16);
+
+    m_pendingSize = size % 16;
+    std::copy_n(data + size - m_pendingSize, m_pendingSize, m_pending.data());
+#endif
+
+    return m_valid;
+}
+
+bool Utf8Validator::finish() noexcept
+{
+    bool valid = m_valid;
+
+    if (not m_simd) {
+        valid = valid and m_needed == 0;
+    }
+    else {
+#if defined(__x86_64__)
+        // The bytes left over are checked as a block padded with ASCII, which also catches a character they leave
+        // unfinished; with none left over, the padding catches one the last block left unfinished
+        std::fill(m_pending.begin() + static_cast<std::ptrdiff_t>(m_pendingSize), m_pending.end(), 0);
+        feedBlocks(m_pending.data(), 1);
+
+        valid = m_valid;
+#endif
+    }
+
+    *this = Utf8Validator {};
+    return valid;
+}
+
+void Utf8Validator::feedBlocks([[maybe_unused]] std::uint8_t const* data, [[maybe_unused]] std::size_t blocks) noexcept
+{
+#if defined(__x86_64__)
+    checkBlocks(data, blocks, m_previous.data(), m_error.data(), m_incomplete.data());
+    m_valid = isZero(m_error);
+#endif
+}
+
+/// \brief Check @p text a byte at a time, as in the Unicode standard's table of well-formed byte sequences
+void Utf8Validator::feedBytes(std::string_view text) noexcept
+{
+    for (auto const c : text) {
+        auto const byte = static_cast<std::uint8_t>(c);
+
+        if (not m_valid) {
+            return;
+        }
+        else if (m_needed > 0) {
+            m_valid = byte >= m_lower and byte <= m_upper;
+            m_lower = 0x80;
+            m_upper = 0xbf;
+            --m_needed;
+        }
+        else if (byte < 0x80) {
+            continue;
+        }
+        else if (byte >= 0xc2 and byte <= 0xdf) {
+            m_needed = 1;
+        }
+        else if (byte >= 0xe0 and byte <= 0xef) {
+            m_needed = 2;
+            m_lower = byte == 0xe0 ? 0xa0 : 0x80;
+            m_upper = byte == 0xed ? 0x9f : 0xbf;
+        }
+        else if (byte >= 0xf0 and byte <= 0xf4) {
+            m_needed = 3;
+            m_lower = byte == 0xf0 ? 0x90 : 0x80;
+            m_upper = byte == 0xf4 ? 0x8f : 0xbf;
+        }
+        else {
+            m_valid = false;
+        }
+    }
+}
+
+std::string utf8::fromLatin1(std::string_view text)
+{
+    std::string converted;
+    converted.reserve(text.size());
+
+    for (auto const c : text) {
+        auto const byte = static_cast<std::uint8_t>(c);
+
+        if (byte < 0x80) {
+            converted += c;
+        }
+        else {
+            converted += static_cast<char>(0xc0 | (byte >> 6));
+            converted += static_cast<char>(0x80 | (byte & 0x3f));
+        }
+    }
+
+    return converted;
+}
+
+bool utf8::toLatin1(std::string_view text, std::string& out)
+{
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        auto const byte = static_cast<std::uint8_t>(text[i]);
+
+        if (byte < 0x80) {
+            out += text[i];
+            continue;
+        }
+
+        // Only U+0080 to U+00FF, encoded as 0xc2 or 0xc3 and a continuation byte, are in Latin-1
+        if ((byte != 0xc2 and byte != 0xc3) or i + 1 == text.size()
+            or (static_cast<std::uint8_t>(text[i + 1]) & 0xc0) != 0x80) {
+            return false;
+        }
+
+        out += static_cast<char>(((byte & 0x03) << 6) | (static_cast<std::uint8_t>(text[i + 1]) & 0x3f));
+        ++i;
+    }
+
+    return true;
+}
+
+std::size_t utf8::length(std::string_view text) noexcept
+{
+    return static_cast<std::size_t>(std::count_if(text.begin(), text.end(), [](char c) {
+        return (static_cast<std::uint8_t>(c) & 0xc0) != 0x80;
+    }));
+}
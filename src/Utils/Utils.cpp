@@ -5,111 +5,300 @@
 #include <read/read.hpp>
 
 #include <array>
+#include <algorithm>
 #include <cctype>
+#include <cstddef>
+#include <string>
+#include <string_view>
 
-/**
- * @brief Perform low-level keypress handling
- * @returns An integer representing the character that was input
- * 
-*/
-[[nodiscard]]
-int readKey()
+namespace
 {
-    using kilo::lib::read::read;
+    /// Input read past the end of a paste, waiting to be decoded as keys
+    std::string pushback;
+    std::size_t pushbackPos = 0;
 
-    [[maybe_unused]] long bytesRead = 0;
-    unsigned char keyRead;
+    /// How many consecutive read timeouts end a paste whose end marker never arrives
+    constexpr int PasteTimeouts = 10;
 
-    while ((bytesRead = read(STDIN_FILENO, &keyRead, 1)) != 1) {
-        // Recall: from Terminal.cpp, VMIN = 0, VTIME = 1;
-        // read returns [1, count] bytes before the timer expires, or 0 if the timer expires
+    /**
+     * @brief Take the next byte of input, from the pushback buffer if it holds any
+     * @param[out] byte The byte read
+     * @returns Whether a byte was read before the read timer expired
+    */
+    bool nextByte(unsigned char& byte)
+    {
+        if (pushbackPos < pushback.size()) {
+            byte = static_cast<unsigned char>(pushback[pushbackPos++]);
+
+            if (pushbackPos == pushback.size()) {
+                pushback.clear();
+                pushbackPos = 0;
+            }
+
+            return true;
+        }
+
+        return kilo::lib::read::read(STDIN_FILENO, &byte, 1) == 1;
     }
 
     /**
-     * If we read an escape character, immediately read 2 more bytes into @c sequence.
-     * If either of these reads times out, assume the user pressed ESC and return that instead.
-     * Otherwise, look to see if the escape sequence if an arrow key sequence.
-     * If it is, return the corresponding [w, a, s, d] character, else return ESC.
+     * @brief Turn the line terminators a terminal pastes, CR or CRLF, into '\n'
+     * @param text The pasted text, rewritten in place
     */
+    void normaliseNewlines(std::string& text) noexcept
+    {
+        std::size_t out = 0;
 
-    if (not isEscapeKey(keyRead)) {
-        return static_cast<int>(keyRead);
-    }
+        for (std::size_t in = 0; in < text.size(); ++in) {
+            if (text[in] == '\r') {
+                text[out++] = '\n';
 
-    std::array<unsigned char, 3> sequence;
+                if (in + 1 < text.size() and text[in + 1] == '\n') {
+                    ++in;
+                }
+            }
+            else {
+                text[out++] = text[in];
+            }
+        }
 
-    if (read(STDIN_FILENO, &sequence[0], 1) != 1) {
-        return static_cast<int>(Key::Escape);
-    }
-    else if (read(STDIN_FILENO, &sequence[1], 1) != 1) {
-        return static_cast<int>(Key::Escape);
+        text.resize(out);
     }
 
-    if (sequence[0] == '[' and std::isdigit(sequence[1])) {
-        if (read(STDIN_FILENO, &sequence[2], 1) != 1) {
+    /// The most digits read from an ESC [ <number> ~ sequence, which bounds a sequence at 6 bytes however it goes on
+    constexpr int MaxDigits = 4;
+
+    /**
+     * @brief Decode a key from its first byte, taking the rest of its escape sequence, if it has one, from @p readNext
+     * @param keyRead The first byte of the key
+     * @param readNext Takes the next byte of input, and returns false if none arrives before the read timer expires
+     * @returns An integer representing the character that was input
+    */
+    template <typename Next>
+    [[nodiscard]]
+    int decode(unsigned char keyRead, Next&& readNext)
+    {
+        /**
+         * If we read an escape character, immediately read 2 more bytes into @c sequence.
+         * If either of these reads times out, assume the user pressed ESC and return that instead.
+         * Otherwise, look to see if the escape sequence if an arrow key sequence.
+         * If it is, return the corresponding [w, a, s, d] character, else return ESC.
+        */
+
+        if (not isEscapeKey(keyRead)) {
+            return static_cast<int>(keyRead);
+        }
+
+        std::array<unsigned char, 2> sequence;
+
+        if (not readNext(sequence[0])) {
+            return static_cast<int>(Key::Escape);
+        }
+        else if (not readNext(sequence[1])) {
             return static_cast<int>(Key::Escape);
         }
 
-        if (sequence[2] == '~') {
-            switch (sequence[1]) {
-                case '1': 
-                case '7':
-                    return static_cast<int>(Key::Home);
+        // Sequences of the form ESC [ <number> ~, e.g. ESC [ 5 ~ for page up or ESC [ 200 ~ for the start of a paste
+        if (sequence[0] == '[' and std::isdigit(sequence[1])) {
+            int number = sequence[1] - '0';
+            int digits = 1;
+            unsigned char next;
+
+            // Count digits rather than compare the number, so that leading zeros can't keep the sequence going
+            do {
+                if (not readNext(next)) {
+                    return static_cast<int>(Key::Escape);
+                }
+                else if (std::isdigit(next)) {
+                    number = number * 10 + (next - '0');
+                    ++digits;
+                }
+            } while (std::isdigit(next) and digits < MaxDigits);
 
-                case '3':
-                    return static_cast<int>(Key::Delete);
+            if (next == '~') {
+                switch (number) {
+                    case 1: 
+                    case 7:
+                        return static_cast<int>(Key::Home);
+
+                    case 3:
+                        return static_cast<int>(Key::Delete);
                 
-                case '4':
-                case '8':
-                    return static_cast<int>(Key::End);
+                    case 4:
+                    case 8:
+                        return static_cast<int>(Key::End);
                 
-                case '5':
-                    return static_cast<int>(Key::PageUp);
+                    case 5:
+                        return static_cast<int>(Key::PageUp);
                 
-                case '6':
-                    return static_cast<int>(Key::PageDown);
+                    case 6:
+                        return static_cast<int>(Key::PageDown);
+
+                    case 200:
+                        return static_cast<int>(Key::Paste);
                 
-                default:
-                    break;                   
+                    default:
+                        break;                   
+                }
             }
         }
-    }
-    else if (sequence[0] == '[' and not std::isdigit(sequence[1])) {
-        switch (sequence[1]) {
-            case 'A':
-                return static_cast<int>(Key::ArrowUp);
+        else if (sequence[0] == '[' and not std::isdigit(sequence[1])) {
+            switch (sequence[1]) {
+                case 'A':
+                    return static_cast<int>(Key::ArrowUp);
             
-            case 'B':
-                return static_cast<int>(Key::ArrowDown);
+                case 'B':
+                    return static_cast<int>(Key::ArrowDown);
             
-            case 'C':
-                return static_cast<int>(Key::ArrowRight);
+                case 'C':
+                    return static_cast<int>(Key::ArrowRight);
             
-            case 'D':
-                return static_cast<int>(Key::ArrowLeft);
+                case 'D':
+                    return static_cast<int>(Key::ArrowLeft);
             
-            case 'H':
-                return static_cast<int>(Key::Home);
+                case 'H':
+                    return static_cast<int>(Key::Home);
             
-            case 'F':
-                return static_cast<int>(Key::End);
+                case 'F':
+                    return static_cast<int>(Key::End);
             
-            default:
-                break;
+                default:
+                    break;
+            }
         }
-    }
-    else if (sequence[0] == 'O') {
-        switch (sequence[1]) {
-            case 'H':
-                return static_cast<int>(Key::Home);
+        else if (sequence[0] == 'O') {
+            switch (sequence[1]) {
+                case 'H':
+                    return static_cast<int>(Key::Home);
                 
-            case 'F':
-                return static_cast<int>(Key::End);
+                case 'F':
+                    return static_cast<int>(Key::End);
 
-            default:
-                break;
+                default:
+                    break;
+            }
         }
+
+        return static_cast<int>(Key::Escape);
     }
+}
+
+/**
+ * @brief Perform low-level keypress handling
+ * @returns An integer representing the character that was input
+ * 
+*/
+[[nodiscard]]
+int readKey()
+{
+    return decodeKey(readByte());
+}
+
+/**
+ * @brief Block until a byte of input is available
+ * @returns The byte that was read
+*/
+[[nodiscard]]
+unsigned char readByte()
+{
+    unsigned char keyRead;
+
+    while (not nextByte(keyRead)) {
+        // Recall: from Terminal.cpp, VMIN = 0, VTIME = 1;
+        // read returns [1, count] bytes before the timer expires, or 0 if the timer expires
+    }
+
+    return keyRead;
+}
+
+/**
+ * @brief Decode a key from its first byte
+ * @param keyRead The first byte of the key
+ * @returns An integer representing the character that was input
+*/
+[[nodiscard]]
+int decodeKey(unsigned char keyRead)
+{
+    return decode(keyRead, nextByte);
+}
+
+/**
+ * @brief Decode the key at @p pos in @p input
+ * @param input The bytes the terminal sent
+ * @param[in,out] pos Where the key begins, moved past it
+ * @returns An integer representing the character that was input
+ *
+ * Running out of input has the same effect as the read timer expiring, so @p input is decoded exactly as readKey
+ * would decode it, had it been all the terminal sent.
+*/
+[[nodiscard]]
+int decodeKey(std::string_view input, std::size_t& pos)
+{
+    auto const next = [&](unsigned char& byte) {
+        if (pos == input.size()) {
+            return false;
+        }
+
+        byte = static_cast<unsigned char>(input[pos++]);
+        return true;
+    };
+
+    return decode(static_cast<unsigned char>(input[pos++]), next);
+}
+
+[[nodiscard]]
+bool inputPending() noexcept
+{
+    return pushbackPos < pushback.size();
+}
+
+/**
+ * @brief Read the text of a bracketed paste, up to and excluding the ESC [ 201 ~ that ends it
+ * @returns The pasted text, with its line terminators turned into '\n'
+ *
+ * The text is read in large chunks rather than a byte at a time, so a paste of megabytes takes a handful of reads.
+ * Anything read past the end marker is kept for readByte. If the end marker never arrives, the paste ends once the
+ * input has been quiet for about a second.
+*/
+[[nodiscard]]
+std::string readPaste()
+{
+    using kilo::lib::read::read;
+
+    constexpr std::string_view endMarker { "\x1b[201~" };
+    constexpr std::size_t chunkSize = 64 * 1024;
+
+    std::string text { std::string_view { pushback }.substr(pushbackPos) };
+    pushback.clear();
+    pushbackPos = 0;
+
+    int timeouts = 0;
+    auto end = text.find(endMarker);
+
+    while (end == std::string::npos) {
+        // The marker may straddle two chunks, so the next search starts just short of the end of this one
+        auto const searched = text.size() < endMarker.size() ? 0 : text.size() - endMarker.size() + 1;
+
+        auto const size = text.size();
+        text.resize(size + chunkSize);
+
+        auto const bytesRead = read(STDIN_FILENO, text.data() + size, chunkSize);
+        text.resize(size + static_cast<std::size_t>(std::max(bytesRead, 0L)));
+
+        if (bytesRead > 0) {
+            timeouts = 0;
+        }
+        else if (++timeouts == PasteTimeouts) {
+            normaliseNewlines(text);
+            return text;
+        }
+
+        end = text.find(endMarker, searched);
+    }
+
+    pushback.assign(text, end + endMarker.size());
+    text.resize(end);
 
-    return static_cast<int>(Key::Escape);
-}
\ No newline at end of file
+    normaliseNewlines(text);
+    return text;
+}
@@ -0,0 +1,250 @@
+#include "WrapLayout/WrapLayout.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+
+namespace
+{
+    /// The lowest set bit of @p i: the number of rows a node of the tree sums, ending at row i
+    constexpr int lowbit(int i) noexcept
+    {
+        return i & -i;
+    }
+}
+
+void WrapLayout::rebuild(Buffer const& buffer, int width)
+{
+    m_width = std::max(width, 1);
+    m_lengths.resize(static_cast<std::size_t>(buffer.size()));
+    m_heights.resize(m_lengths.size());
+
+    for (int y = 0; y < buffer.size(); ++y) {
+        m_lengths[static_cast<std::size_t>(y)] = buffer.rowLength(y);
+        m_heights[static_cast<std::size_t>(y)] = heightOf(m_lengths[static_cast<std::size_t>(y)]);
+    }
+
+    build(0);
+}
+
+/**
+ * @brief Lay out again the rows a change to the buffer touched
+ * @param buffer The buffer, as it is after the change
+ * @param y The first row changed
+ * @param removed How many rows from row @p y on the change replaced
+ * @param inserted How many rows now stand in their place
+*/
+void WrapLayout::update(Buffer const& buffer, int y, int removed, int inserted)
+{
+    auto const rows = static_cast<int>(m_lengths.size());
+
+    // Typing changes a row in place, and loading a file appends rows to it, a row at a time
+    if (removed == inserted and inserted <= Incremental) {
+        for (int k = y; k < y + inserted; ++k) {
+            set(k, buffer.rowLength(k));
+        }
+
+        return;
+    }
+
+    if (y + removed == rows and inserted <= Incremental) {
+        for (int k = 0; k < removed; ++k) {
+            pop();
+        }
+
+        for (int k = y; k < y + inserted; ++k) {
+            push(buffer.rowLength(k));
+        }
+
+        return;
+    }
+
+    // The rows after the change are moved once, by the difference
+    for (auto* column : { &m_lengths, &m_heights }) {
+        if (inserted > removed) {
+            column->insert(column->begin() + y, static_cast<std::size_t>(inserted - removed), 0);
+        }
+        else {
+            column->erase(column->begin() + y, column->begin() + y + (removed - inserted));
+        }
+    }
+
+    for (int k = y; k < y + inserted; ++k) {
+        m_lengths[static_cast<std::size_t>(k)] = buffer.rowLength(k);
+        m_heights[static_cast<std::size_t>(k)] = heightOf(m_lengths[static_cast<std::size_t>(k)]);
+    }
+
+    build(y);
+}
+
+/// \details Only the rows wider than the narrower of the two widths can change height, so only they are wrapped again
+void WrapLayout::setWidth(int width)
+{
+    width = std::max(width, 1);
+
+    if (width == m_width) {
+        return;
+    }
+
+    auto const narrowest = std::min(width, m_width);
+    m_width = width;
+
+    for (std::size_t y = 0; y < m_lengths.size(); ++y) {
+        if (m_lengths[y] > narrowest) {
+            m_heights[y] = heightOf(m_lengths[y]);
+        }
+    }
+
+    build(0);
+}
+
+int WrapLayout::height(int y) const noexcept
+{
+    if (y < 0 or y >= static_cast<int>(m_lengths.size())) {
+        return 1;
+    }
+
+    return m_heights[static_cast<std::size_t>(y)];
+}
+
+int WrapLayout::screenRow(int y) const noexcept
+{
+    return prefix(std::clamp(y, 0, static_cast<int>(m_lengths.size())));
+}
+
+/**
+ * @brief Find the buffer row a screen row shows
+ *
+ * Walks down the tree from its largest node, taking each node whose rows all end before @p row, so the search takes
+ * O(log n) steps.
+*/
+Position WrapLayout::locate(int row) const noexcept
+{
+    auto const rows = static_cast<int>(m_lengths.size());
+
+    if (row >= m_total) {
+        return { 0, rows };
+    }
+
+    int y = 0;
+    row = std::max(row, 0);
+
+    for (auto step = std::bit_floor(static_cast<unsigned>(rows)); step > 0; step >>= 1) {
+        auto const next = y + static_cast<int>(step);
+
+        if (next <= rows and m_tree[static_cast<std::size_t>(next)] <= row) {
+            y = next;
+            row -= m_tree[static_cast<std::size_t>(next)];
+        }
+    }
+
+    return { row * m_width, y };
+}
+
+Position WrapLayout::next(Position at) const noexcept
+{
+    if (at.x / m_width + 1 < height(at.y)) {
+        return { at.x + m_width, at.y };
+    }
+
+    return { 0, at.y + 1 };
+}
+
+Position WrapLayout::place(Position at) const noexcept
+{
+    auto const part = std::min(at.x / m_width, height(at.y) - 1);
+
+    return { at.x - part * m_width, screenRow(at.y) + part };
+}
+
+int WrapLayout::heightOf(int length) const noexcept
+{
+    return length <= m_width ? 1 : (length + m_width - 1) / m_width;
+}
+
+/// \returns The number of screen rows the first @p rows rows take up
+int WrapLayout::prefix(int rows) const noexcept
+{
+    int sum = 0;
+
+    for (; rows > 0; rows -= lowbit(rows)) {
+        sum += m_tree[static_cast<std::size_t>(rows)];
+    }
+
+    return sum;
+}
+
+/**
+ * @brief Build the nodes of the tree for the rows from row @p from on, in linear time
+ *
+ * The nodes for the rows before @p from only cover those rows, so they are kept as they are; the nodes after them
+ * are built by each adding itself to its parent in turn. The nodes of rows before @p from whose parents come after
+ * it are those a prefix sum up to @p from walks through, so they are added to their parents first.
+*/
+void WrapLayout::build(int from)
+{
+    auto const rows = static_cast<int>(m_lengths.size());
+    auto const parent = [](int i) { return i + lowbit(i); };
+
+    m_tree.resize(static_cast<std::size_t>(rows) + 1);
+
+    for (auto i = from + 1; i <= rows; ++i) {
+        m_tree[static_cast<std::size_t>(i)] = m_heights[static_cast<std::size_t>(i - 1)];
+    }
+
+    for (auto i = from; i > 0; i -= lowbit(i)) {
+        if (parent(i) <= rows) {
+            m_tree[static_cast<std::size_t>(parent(i))] += m_tree[static_cast<std::size_t>(i)];
+        }
+    }
+
+    for (auto i = from + 1; i <= rows; ++i) {
+        if (parent(i) <= rows) {
+            m_tree[static_cast<std::size_t>(parent(i))] += m_tree[static_cast<std::size_t>(i)];
+        }
+    }
+
+    m_total = prefix(rows);
+}
+
+void WrapLayout::set(int y, int length)
+{
+    auto& height = m_heights[static_cast<std::size_t>(y)];
+    auto const delta = heightOf(length) - height;
+
+    m_lengths[static_cast<std::size_t>(y)] = length;
+    height += delta;
+
+    if (delta == 0) {
+        return;
+    }
+
+    for (auto i = y + 1; i <= static_cast<int>(m_lengths.size()); i += lowbit(i)) {
+        m_tree[static_cast<std::size_t>(i)] += delta;
+    }
+
+    m_total += delta;
+}
+
+/// \brief Append a row; its node sums the rows it covers, all of which but itself are already in the tree
+void WrapLayout::push(int length)
+{
+    auto const height = heightOf(length);
+
+    m_lengths.push_back(length);
+    m_heights.push_back(height);
+
+    auto const i = static_cast<int>(m_lengths.size());
+
+    m_tree.push_back(height + prefix(i - 1) - prefix(i - lowbit(i)));
+    m_total += height;
+}
+
+/// \brief Drop the last row; no other node covers it
+void WrapLayout::pop()
+{
+    m_total -= m_heights.back();
+    m_lengths.pop_back();
+    m_heights.pop_back();
+    m_tree.pop_back();
+}
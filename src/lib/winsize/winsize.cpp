@@ -5,12 +5,14 @@
 #include <unistd.h>
 
 #include <system_error>
+#include <tuple>
 #include <iostream>
 
 namespace kilo::lib::winsize
 {
-    winsize::winsize() noexcept : row(getSize().first), col(getSize().second)
+    winsize::winsize() noexcept
     {
+        std::tie(row, col) = getSize();
     }
 
     std::pair<unsigned short, unsigned short> winsize::getSize() const& noexcept
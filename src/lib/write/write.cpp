@@ -26,4 +26,23 @@ namespace kilo::lib::write
 
         return rv;
     }
+
+    [[nodiscard]] long writeSome(int fd, void const* buffer, std::size_t count)
+    {
+        if (count > 0x7FFFF000) {
+            throw std::system_error(EINVAL, std::generic_category(), "Bytes to write exceed the maximum legal limit.");
+        }
+
+        errno = 0;
+        auto const rv = ::write(fd, buffer, count);
+
+        if (rv < 0 and (errno == EAGAIN or errno == EWOULDBLOCK or errno == EINTR)) {
+            return 0;
+        }
+        else if (rv < 0) {
+            throw std::system_error(errno, std::generic_category(), std::strerror(errno));
+        }
+
+        return rv;
+    }
 }
\ No newline at end of file
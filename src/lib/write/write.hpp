@@ -12,6 +12,15 @@ namespace kilo::lib::write
     /// \throws std::system_error An error that occurs upon write failure
     /// \returns The number of bytes written
     [[nodiscard]] long write(int fd, void const* buffer, std::size_t count);
+
+    /// \brief Write as much data as an open file accepts without blocking.
+    /// \details Unlike write, a short write is not an error, so this suits file descriptors set to O_NONBLOCK.
+    /// \param[in] fd A file descriptor referring to an open file.
+    /// \param[in] buffer The address of the data to be written.
+    /// \param[in] count The maximum number of bytes to be written
+    /// \throws std::system_error An error that occurs upon write failure, other than the file being full
+    /// \returns The number of bytes written, or 0 if the file can't accept any more right now
+    [[nodiscard]] long writeSome(int fd, void const* buffer, std::size_t count);
 }
 
 #endif
\ No newline at end of file
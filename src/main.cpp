@@ -1,10 +1,19 @@
 #include "Editor/Editor.hpp"
+#include "Batch/Batch.hpp"
 
 #include <cstdlib>
+#include <filesystem>
 #include <stdexcept>
+#include <string_view>
+#include <vector>
 
 int main(int argc, char* argv[])
 {
+    // kilo --batch <script> [file...] edits the files headlessly, without ever touching the terminal
+    if (argc >= 3 and std::string_view { argv[1] } == "--batch") {
+        return runBatch(argv[2], std::vector<std::filesystem::path>(argv + 3, argv + argc));
+    }
+
     Editor& editor = Editor::instance();
 
     if (argc >= 2) {
@@ -13,8 +22,11 @@ int main(int argc, char* argv[])
 
     while (true) {
         editor.refreshScreen();
-        editor.processKeypress();
+
+        if (editor.waitForInput()) {
+            editor.processKeypress();
+        }
     }
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,62 @@
+#include "Batch/Batch.hpp"
+
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    std::string edited(std::string const& script, std::string const& text)
+    {
+        std::istringstream scriptIn { script };
+        std::istringstream textIn { text };
+        std::ostringstream out;
+
+        Buffer buffer;
+        buffer.load(textIn);
+        Script::parse(scriptIn).apply(buffer);
+        buffer.save(out);
+
+        return out.str();
+    }
+}
+
+TEST(BatchTest, AppliesCommandsInOrder)
+{
+    auto const script = "# prepend a header\n"
+                        "insert // header\\n\n"
+                        "goto $\n"
+                        "end\n"
+                        "insert ;\n";
+
+    ASSERT_THAT(edited(script, "a\nb\n"), testing::Eq("// header\na\nb;\n"));
+}
+
+TEST(BatchTest, RepeatsCountedCommands)
+{
+    ASSERT_THAT(edited("right 2\ndelete 2\ndown\ndeleteline\n", "abcdef\nx\ny\n"), testing::Eq("abef\ny\n"));
+}
+
+TEST(BatchTest, ReplacesEveryOccurrence)
+{
+    ASSERT_THAT(edited("replace |foo|a b|\n", "foo foo\nbar\nfoo\n"), testing::Eq("a b a b\nbar\na b\n"));
+}
+
+TEST(BatchTest, ReportsTheLineOfAnInvalidCommand)
+{
+    std::istringstream script { "home\nfrobnicate\n" };
+
+    ASSERT_THROW(
+        {
+            try {
+                [[maybe_unused]] auto const parsed = Script::parse(script);
+            }
+            catch (std::invalid_argument const& err) {
+                ASSERT_THAT(err.what(), testing::HasSubstr("line 2"));
+                throw;
+            }
+        },
+        std::invalid_argument);
+}
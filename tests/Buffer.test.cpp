@@ -0,0 +1,216 @@
+#include "Buffer/Buffer.hpp"
+#include "TestFiles/TestFiles.hpp"
+
+#include <gmock/gmock.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+TEST(BufferTest, SplitsTextIntoRowsWithoutTerminators)
+{
+    auto const buffer = testFiles::loaded("one\ntwo\n\nfour\n");
+
+    ASSERT_THAT(buffer.size(), testing::Eq(4));
+    ASSERT_THAT(buffer.row(1), testing::Eq("two"));
+    ASSERT_THAT(buffer.row(2), testing::Eq(""));
+    ASSERT_THAT(buffer.dirty(), testing::IsFalse());
+}
+
+TEST(BufferTest, RoundTripsTextWithoutATrailingNewline)
+{
+    ASSERT_THAT(testFiles::textOf(testFiles::loaded("one\ntwo")), testing::Eq("one\ntwo"));
+    ASSERT_THAT(testFiles::textOf(testFiles::loaded("one\ntwo\n")), testing::Eq("one\ntwo\n"));
+}
+
+TEST(BufferTest, InsertsTextSpanningSeveralRows)
+{
+    auto buffer = testFiles::loaded("headtail\n");
+    auto const end = buffer.insert({ 4, 0 }, "1\n2\n3");
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("head1\n2\n3tail\n"));
+    ASSERT_THAT(end.x, testing::Eq(1));
+    ASSERT_THAT(end.y, testing::Eq(2));
+    ASSERT_THAT(buffer.dirty(), testing::IsTrue());
+}
+
+TEST(BufferTest, InsertingPastTheEndAppendsARow)
+{
+    auto buffer = testFiles::loaded("one\n");
+    buffer.insert({ 0, 1 }, "two");
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one\ntwo\n"));
+}
+
+TEST(BufferTest, ErasesRangesSpanningSeveralRows)
+{
+    auto buffer = testFiles::loaded("abc\ndef\nghi\n");
+    buffer.erase({ 1, 0 }, { 2, 2 });
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("ai\n"));
+}
+
+TEST(BufferTest, ErasesWholeRows)
+{
+    auto buffer = testFiles::loaded("a\nb\nc\n");
+    buffer.eraseRows(1, 5);
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("a\n"));
+}
+
+TEST(BufferTest, UndoesAndRedoesEachEntryAsAWhole)
+{
+    auto buffer = testFiles::loaded("a\nb\nc\n");
+
+    buffer.checkpoint();
+    buffer.insert({ 1, 0 }, "1\n2");
+    buffer.erase({ 0, 2 }, { 1, 2 });
+
+    buffer.checkpoint();
+    buffer.eraseRows(0, 2);
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("\nc\n"));
+
+    ASSERT_THAT(buffer.undo().has_value(), testing::IsTrue());
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("a1\n2\n\nc\n"));
+
+    auto const where = buffer.undo();
+    ASSERT_THAT(where.has_value(), testing::IsTrue());
+    ASSERT_THAT(where->x, testing::Eq(1));
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("a\nb\nc\n"));
+    ASSERT_THAT(buffer.undo().has_value(), testing::IsFalse());
+
+    buffer.redo();
+    buffer.redo();
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("\nc\n"));
+    ASSERT_THAT(buffer.redo().has_value(), testing::IsFalse());
+}
+
+TEST(BufferTest, UndoingAnAppendRemovesTheRow)
+{
+    auto buffer = testFiles::loaded("one\n");
+    buffer.checkpoint();
+    buffer.insert({ 0, 1 }, "two\nthree");
+    buffer.undo();
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one\n"));
+}
+
+TEST(BufferTest, UndoingAnEraseUpToThePastTheEndRowAddsNoRow)
+{
+    auto buffer = testFiles::loaded("one\ntwo\n");
+
+    // Deleting forward at the end of the last row has nothing to join
+    buffer.erase({ 3, 1 }, { 0, 2 });
+    ASSERT_THAT(buffer.undo().has_value(), testing::IsFalse());
+
+    buffer.erase({ 0, 0 }, { 0, 2 });
+    ASSERT_THAT(buffer.size(), testing::Eq(1));
+    buffer.undo();
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one\ntwo\n"));
+}
+
+TEST(BufferTest, SplicesThatTouchPastTheEndEndTogether)
+{
+    auto buffer = testFiles::loaded("one\n");
+    auto const ends = buffer.splice({ { { 0, 1 }, { 0, 1 }, "two\n" }, { { 0, 1 }, { 0, 1 }, "" }, { { 0, 1 }, { 0, 1 }, "" } });
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one\ntwo\n\n"));
+    ASSERT_THAT(ends.size(), testing::Eq(3u));
+    ASSERT_THAT(ends[1].y, testing::Eq(ends[0].y));
+    ASSERT_THAT(ends[2].y, testing::Eq(ends[0].y));
+}
+
+TEST(BufferTest, AMegabytePasteIsASingleUndoEntry)
+{
+    std::string paste;
+
+    for (int i = 0; paste.size() < 1024 * 1024; ++i) {
+        paste += "line " + std::to_string(i) + '\n';
+    }
+
+    auto buffer = testFiles::loaded("before\nafter\n");
+    buffer.checkpoint();
+    auto const end = buffer.insert({ 0, 1 }, paste);
+
+    ASSERT_THAT(end.y, testing::Eq(buffer.size() - 1));
+    ASSERT_THAT(buffer.row(buffer.size() - 1), testing::Eq("after"));
+
+    buffer.undo();
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("before\nafter\n"));
+}
+
+TEST(BufferTest, OpensLargeFilesLazily)
+{
+    auto const path = testFiles::path("buffer-lazy.txt");
+    std::string text;
+
+    for (int i = 0; i < 100'000; ++i) {
+        text += "row " + std::to_string(i) + '\n';
+    }
+
+    text += "no newline";
+    std::ofstream { path, std::ios::binary } << text;
+
+    Buffer buffer;
+    buffer.open(path, 24);
+
+    ASSERT_THAT(buffer.loading(), testing::IsTrue());
+    ASSERT_THAT(buffer.size(), testing::AllOf(testing::Ge(24), testing::Lt(100'000)));
+    ASSERT_THAT(buffer.row(23), testing::Eq("row 23"));
+
+    // Loading more of the file is not an edit
+    buffer.loadMore();
+    ASSERT_THAT(buffer.edits(), testing::Eq(0u));
+
+    // Editing finishes loading first
+    buffer.insert({ 0, 0 }, ">");
+    ASSERT_THAT(buffer.edits(), testing::Eq(1u));
+
+    ASSERT_THAT(buffer.loading(), testing::IsFalse());
+    ASSERT_THAT(buffer.size(), testing::Eq(100'001));
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq(">" + text));
+
+    std::filesystem::remove(path);
+}
+
+TEST(BufferTest, SavingKeepsTheModeOfTheFileAndSavesThroughASymlink)
+{
+    namespace fs = std::filesystem;
+
+    auto const file = testFiles::write("buffer-private.txt", "secret\n");
+    auto const link = testFiles::path("buffer-link.txt");
+    fs::permissions(file, fs::perms::owner_read | fs::perms::owner_write);
+    fs::create_symlink(file, link);
+
+    Buffer buffer;
+    buffer.open(link);
+    buffer.insert({ 6, 0 }, "!");
+    buffer.save(link);
+
+    ASSERT_THAT(fs::is_symlink(link), testing::IsTrue());
+    ASSERT_THAT(fs::status(file).permissions(), testing::Eq(fs::perms::owner_read | fs::perms::owner_write));
+    ASSERT_THAT(fs::exists(testFiles::path("buffer-private.txt.kilo-save")), testing::IsFalse());
+
+    std::ifstream in { file };
+    std::string text;
+    std::getline(in, text);
+    ASSERT_THAT(text, testing::Eq("secret!"));
+}
+
+TEST(BufferTest, SavingAFileWithOtherHardLinksRewritesItInPlace)
+{
+    auto const file = testFiles::write("buffer-linked.txt", "one\n");
+    auto const other = testFiles::path("buffer-other.txt");
+    std::filesystem::create_hard_link(file, other);
+
+    Buffer buffer;
+    buffer.open(file);
+    buffer.insert({ 3, 0 }, "!");
+    buffer.save(file);
+
+    std::ifstream in { other };
+    std::string text;
+    std::getline(in, text);
+    ASSERT_THAT(text, testing::Eq("one!"));
+}
@@ -0,0 +1,221 @@
+#include "Buffer/Buffer.hpp"
+#include "Compressed/Compressed.hpp"
+#include "TestFiles/TestFiles.hpp"
+
+#include <gmock/gmock.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <zstd.h>
+
+namespace
+{
+    std::filesystem::path writeCompressed(std::string const& name, std::string const& text, Compression compression)
+    {
+        auto const path = testFiles::path(name);
+        auto const out = compressed::openForWriting(path, compression);
+        *out << text;
+        out->flush();
+
+        return path;
+    }
+
+    /// \brief Write @p text as a single zstd frame, as the zstd tool does
+    std::filesystem::path writeZstdFrame(std::string const& name, std::string const& text)
+    {
+        std::string frame(::ZSTD_compressBound(text.size()), '\0');
+        frame.resize(::ZSTD_compress(frame.data(), frame.size(), text.data(), text.size(), 1));
+
+        return testFiles::write(name, frame);
+    }
+
+    std::string readAll(std::istream& in)
+    {
+        return { std::istreambuf_iterator<char> { in }, std::istreambuf_iterator<char> {} };
+    }
+
+    /// \brief Read 100 bytes at each of a few offsets spread over @p text, in no particular order, and compare them
+    void jumpAround(std::istream& in, std::string const& text)
+    {
+        for (std::size_t offset : { std::size_t { 0 }, text.size() / 2, std::size_t { 5 }, text.size() - 100, std::size_t { 2'499'990 } }) {
+            std::string piece(100, '\0');
+            in.clear();
+            in.seekg(static_cast<std::streamoff>(offset));
+            in.read(piece.data(), static_cast<std::streamsize>(piece.size()));
+            piece.resize(static_cast<std::size_t>(in.gcount()));
+
+            ASSERT_THAT(piece, testing::Eq(text.substr(offset, 100)));
+        }
+    }
+}
+
+TEST(CompressedTest, DetectsCompressionByItsMagic)
+{
+    auto const gzip = writeCompressed("compressed-detect.gz", "text\n", Compression::Gzip);
+    auto const zstd = writeCompressed("compressed-detect.zst", "text\n", Compression::Zstd);
+    auto const plain = testFiles::write("compressed-detect.txt", "text\n");
+
+    ASSERT_THAT(compressed::detect(gzip), testing::Eq(Compression::Gzip));
+    ASSERT_THAT(compressed::detect(zstd), testing::Eq(Compression::Zstd));
+    ASSERT_THAT(compressed::detect(plain), testing::Eq(Compression::None));
+
+    std::filesystem::remove(gzip);
+    std::filesystem::remove(zstd);
+    std::filesystem::remove(plain);
+}
+
+TEST(CompressedTest, ReadsConcatenatedMembersAsOneText)
+{
+    for (auto compression : { Compression::Gzip, Compression::Zstd }) {
+        auto const path = testFiles::path("compressed-members");
+
+        {
+            auto const out = compressed::openForWriting(path, compression);
+            *out << "first\n" << std::flush << "second\n" << std::flush;
+        }
+
+        auto const in = compressed::openForReading(path, compression);
+        ASSERT_THAT(readAll(*in), testing::Eq("first\nsecond\n"));
+
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(CompressedTest, SeeksWithoutDecompressingEverything)
+{
+    // More text than is cached, in several gzip members, so that blocks are decompressed again across member ends
+    auto const text = testFiles::makeText(80'000);
+    auto const path = testFiles::path("compressed-seek.gz");
+
+    {
+        auto const out = compressed::openForWriting(path, Compression::Gzip);
+
+        for (std::size_t start = 0; start < text.size(); start += 2'500'000) {
+            *out << text.substr(start, 2'500'000) << std::flush;
+        }
+    }
+
+    GzipReader reader { path };
+    std::istream in { &reader };
+
+    ASSERT_THAT(readAll(in), testing::Eq(text));
+    ASSERT_THAT(text.size(), testing::Gt(GzipReader::CacheBytes));
+    ASSERT_THAT(reader.accessPoints(), testing::Ge(text.size() / (2 * GzipReader::Span)));
+    ASSERT_THAT(reader.cachedBytes(), testing::Le(GzipReader::CacheBytes + 2 * GzipReader::Span));
+
+    // Back to the start of the file included, so that blocks are decompressed again from their access point
+    jumpAround(in, text);
+
+    in.clear();
+    ASSERT_THAT(in.seekg(static_cast<std::streamoff>(text.size() + 1)).fail(), testing::IsTrue());
+
+    std::filesystem::remove(path);
+}
+
+TEST(CompressedTest, SeeksInZstdFramesAndInsideThem)
+{
+    auto const text = testFiles::makeText(80'000);
+
+    // Frames of ZstdWriter::FrameSize, whose starts are the access points, and one long frame, which gets access
+    // points inside it
+    for (auto const& path : { writeCompressed("compressed-seek.zst", text, Compression::Zstd), writeZstdFrame("compressed-frame.zst", text) }) {
+        ZstdReader reader { path };
+        std::istream in { &reader };
+
+        ASSERT_THAT(readAll(in), testing::Eq(text));
+        ASSERT_THAT(reader.accessPoints(), testing::Ge(text.size() / (2 * ZstdReader::Span)));
+        ASSERT_THAT(reader.cachedBytes(), testing::Le(ZstdReader::CacheBytes + 2 * ZstdReader::Span));
+
+        jumpAround(in, text);
+
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(CompressedTest, SeeksStraightAwayWithASavedIndex)
+{
+    auto const text = testFiles::makeText(80'000);
+
+    for (auto compression : { Compression::Gzip, Compression::Zstd }) {
+        auto const path = writeCompressed("compressed-index", text, compression);
+
+        auto const index = std::make_shared<SeekIndex>();
+
+        {
+            auto const in = compressed::openForReading(path, compression, index);
+            in->seekg(0, std::ios::end);
+        }
+
+        ASSERT_THAT(index->complete, testing::IsTrue());
+
+        // Only the block read is decompressed, not the text before it
+        auto const reader = compression == Compression::Gzip
+            ? std::unique_ptr<SeekableReader> { std::make_unique<GzipReader>(path, index) }
+            : std::unique_ptr<SeekableReader> { std::make_unique<ZstdReader>(path, index) };
+        std::istream in { reader.get() };
+
+        ASSERT_THAT(reader->index(), testing::Eq(index));
+
+        std::string piece(100, '\0');
+        in.seekg(static_cast<std::streamoff>(text.size() - 100));
+        in.read(piece.data(), static_cast<std::streamsize>(piece.size()));
+
+        ASSERT_THAT(piece, testing::Eq(text.substr(text.size() - 100)));
+        ASSERT_THAT(reader->cachedBytes(), testing::Le(2 * SeekableReader::Span));
+
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(CompressedTest, ReportsCorruptData)
+{
+    for (auto compression : { Compression::Gzip, Compression::Zstd }) {
+        auto const path = writeCompressed("compressed-corrupt", testFiles::makeText(10'000), compression);
+
+        {
+            std::fstream file { path, std::ios::binary | std::ios::in | std::ios::out };
+            file.seekp(100);
+            file.write("garbage!garbage!", 16);
+        }
+
+        auto const in = compressed::openForReading(path, compression);
+        ASSERT_THROW(readAll(*in), std::system_error);
+
+        std::filesystem::remove(path);
+    }
+}
+
+TEST(CompressedTest, BufferSavesCompressedFilesAsTheyWere)
+{
+    auto const text = testFiles::makeText(1000);
+
+    for (auto compression : { Compression::Gzip, Compression::Zstd }) {
+        auto const path = writeCompressed("compressed-buffer", text, compression);
+
+        Buffer buffer;
+        buffer.open(path, 24);
+
+        ASSERT_THAT(buffer.row(0), testing::StartsWith("row 0 "));
+
+        buffer.loadAll();
+        ASSERT_THAT(buffer.seekIndex(), testing::NotNull());
+
+        // The file saved is another file, which the index doesn't describe
+        buffer.insert({ 0, 0 }, ">");
+        buffer.save(path);
+
+        ASSERT_THAT(buffer.seekIndex(), testing::IsNull());
+        ASSERT_THAT(compressed::detect(path), testing::Eq(compression));
+
+        auto const in = compressed::openForReading(path, compression);
+        ASSERT_THAT(readAll(*in), testing::Eq(">" + text));
+
+        std::filesystem::remove(path);
+    }
+}
@@ -0,0 +1,255 @@
+#include "CursorSet/CursorSet.hpp"
+#include "Commands/Commands.hpp"
+#include "Buffer/Buffer.hpp"
+#include "TestFiles/TestFiles.hpp"
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::vector<Position> positionsOf(CursorSet const& cursors)
+    {
+        std::vector<Position> positions;
+
+        for (auto const& cursor : cursors) {
+            positions.push_back(cursor.position());
+        }
+
+        return positions;
+    }
+
+    MATCHER_P2(IsAt, x, y, "") { return arg.x == x and arg.y == y; }
+}
+
+TEST(CursorSetTest, KeepsCursorsInOrderWithoutDuplicates)
+{
+    CursorSet cursors;
+
+    cursors.add({ 4, 2 });
+    cursors.add({ 1, 1 });
+    cursors.add({ 4, 2 });
+
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(0, 0), IsAt(1, 1), IsAt(4, 2)));
+    ASSERT_THAT(cursors.primary().position(), IsAt(4, 2));
+    ASSERT_THAT(cursors.onRow(1).size(), testing::Eq(1u));
+
+    // Cursors that meet merge, and the primary cursor is kept
+    cursors.moveEach([](Cursor& cursor) { cursor.moveTo({ 0, cursor.yPos == 0 ? 1 : cursor.yPos }); });
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(0, 1), IsAt(0, 2)));
+    ASSERT_THAT(cursors.primary().position(), IsAt(0, 2));
+
+    cursors.collapse();
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(0, 2)));
+}
+
+TEST(CursorSetTest, EditsAtEveryCursor)
+{
+    auto buffer = testFiles::loaded("one two\nthree\nfour\n");
+    CursorSet cursors;
+
+    cursors.assign({ { 3, 0 }, { 7, 0 }, { 0, 1 }, { 4, 2 } }, 0);
+
+    commands::insertText(buffer, cursors, "!");
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one! two!\n!three\nfour!\n"));
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(4, 0), IsAt(9, 0), IsAt(1, 1), IsAt(5, 2)));
+
+    commands::insertNewline(buffer, cursors);
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one!\n two!\n\n!\nthree\nfour!\n\n"));
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(0, 1), IsAt(0, 2), IsAt(0, 4), IsAt(0, 6)));
+
+    commands::deleteBackward(buffer, cursors);
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one! two!\n!three\nfour!\n"));
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(4, 0), IsAt(9, 0), IsAt(1, 1), IsAt(5, 2)));
+
+    // Nothing follows the last cursor, at the end of the text
+    commands::deleteForward(buffer, cursors);
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one!two!!hree\nfour!\n"));
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(4, 0), IsAt(8, 0), IsAt(9, 0), IsAt(5, 1)));
+
+    // Each keystroke is one edit, undone as one
+    buffer.checkpoint();
+    commands::insertText(buffer, cursors, "x");
+    buffer.checkpoint();
+    buffer.undo();
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one!two!!hree\nfour!\n"));
+}
+
+TEST(CursorSetTest, PagesEveryCursor)
+{
+    auto const buffer = testFiles::loaded("row 0\nrow 1\nrow 2\nrow 3\nrow 4\nrow 5\nrow 6\nrow 7\nrow 8\nrow 9\n");
+    Folds folds;
+    CursorSet cursors;
+
+    folds.fold(3, 5);
+    cursors.assign({ { 2, 0 }, { 1, 1 }, { 4, 6 } }, 1);
+
+    // The fold counts as one row, and no cursor goes past the row after the last
+    commands::moveRows(buffer, folds, cursors, 4);
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(2, 6), IsAt(1, 7), IsAt(0, 10)));
+    ASSERT_THAT(cursors.primary().position(), IsAt(1, 7));
+
+    // Cursors stop at the top, each keeping its column
+    commands::moveRows(buffer, folds, cursors, -20);
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(0, 0), IsAt(1, 0), IsAt(2, 0)));
+}
+
+TEST(CursorSetTest, PutsCursorsOnEveryOccurrenceOfAWord)
+{
+    auto const buffer = testFiles::loaded("let x = foo;\nfoobar(foo)\n  foo\n");
+    CursorSet cursors;
+
+    cursors.add({ 8, 0 });
+
+    ASSERT_THAT(commands::cursorsAtWord(buffer, cursors), testing::Eq(3u));
+    ASSERT_THAT(positionsOf(cursors), testing::ElementsAre(IsAt(8, 0), IsAt(7, 1), IsAt(2, 2)));
+
+    cursors.collapse();
+    ASSERT_THAT(cursors.primary().position(), IsAt(8, 0));
+
+    cursors.add({ 5, 0 });
+    cursors.collapse();
+    ASSERT_THAT(commands::cursorsAtWord(buffer, cursors), testing::Eq(1u));
+
+    cursors.primary().moveTo({ 3, 0 });
+    ASSERT_THAT(commands::cursorsAtWord(buffer, cursors), testing::Eq(1u));
+
+    cursors.primary().moveTo({ 1, 2 });
+    ASSERT_THAT(commands::cursorsAtWord(buffer, cursors), testing::Eq(0u));
+}
+
+/// Making the splices in one go gives the same text as making them one at a time, from the last to the first, and the
+/// rows reported as changed account for every row of the buffer
+TEST(CursorSetTest, SplicesMatchEditsMadeOneAtATime)
+{
+    std::mt19937 random { 11 };
+    std::string text;
+
+    for (int y = 0; y < 60; ++y) {
+        text += std::string(random() % 12, static_cast<char>('a' + y % 26)) + "\n";
+    }
+
+    auto buffer = testFiles::loaded(text);
+    auto expected = testFiles::loaded(text);
+    std::vector<int> lengths;
+
+    for (int y = 0; y < buffer.size(); ++y) {
+        lengths.push_back(buffer.rowLength(y));
+    }
+
+    buffer.onRowsChanged([&](int y, int removed, int inserted) {
+        lengths.erase(lengths.begin() + y, lengths.begin() + y + removed);
+
+        for (int k = 0; k < inserted; ++k) {
+            lengths.insert(lengths.begin() + y + k, buffer.rowLength(y + k));
+        }
+    });
+
+    std::vector<std::string> history { testFiles::textOf(buffer) };
+
+    for (int step = 0; step < 300; ++step) {
+        std::vector<Buffer::Splice> splices;
+        Position at {};
+
+        // Disjoint ranges in order, some of them spanning rows, some of them empty
+        while (true) {
+            auto const down = static_cast<int>(random() % 6);
+            at.y += down;
+
+            if (at.y > buffer.size()) {
+                break;
+            }
+
+            auto const x = static_cast<int>(random() % static_cast<unsigned>(buffer.rowLength(at.y) + 1));
+            at.x = down == 0 ? std::max(at.x, x) : x;
+
+            auto to = at;
+
+            if (random() % 3 == 0 and at.y + 1 < buffer.size()) {
+                to = { static_cast<int>(random() % static_cast<unsigned>(buffer.rowLength(at.y + 1) + 1)), at.y + 1 };
+            }
+            else if (random() % 2 and at.x < buffer.rowLength(at.y)) {
+                to.x = at.x + 1;
+            }
+
+            auto const inserted = std::string(random() % 3, 'X') + (random() % 4 == 0 ? "\nY" : "");
+            splices.push_back({ at, to, inserted });
+            at = to;
+        }
+
+        auto const changes = std::any_of(splices.begin(), splices.end(), [](Buffer::Splice const& splice) {
+            return splice.from.x != splice.to.x or splice.from.y != splice.to.y or not splice.text.empty();
+        });
+
+        if (not changes) {
+            continue;
+        }
+
+        for (auto splice = splices.rbegin(); splice != splices.rend(); ++splice) {
+            expected.erase(splice->from, splice->to);
+            expected.insert(splice->from, splice->text);
+        }
+
+        buffer.checkpoint();
+        auto const ends = buffer.splice(splices);
+
+        ASSERT_THAT(testFiles::textOf(buffer), testing::Eq(testFiles::textOf(expected))) << step;
+        ASSERT_THAT(ends.size(), testing::Eq(splices.size()));
+        ASSERT_THAT(static_cast<int>(lengths.size()), testing::Eq(buffer.size())) << step;
+
+        for (int y = 0; y < buffer.size(); ++y) {
+            ASSERT_THAT(lengths[static_cast<std::size_t>(y)], testing::Eq(buffer.rowLength(y))) << step;
+        }
+
+        // The text of each splice ends where the splice reports
+        for (std::size_t i = 0; i < splices.size(); ++i) {
+            auto const tail = splices[i].text.substr(splices[i].text.rfind('\n') + 1);
+            auto const end = ends[i];
+
+            ASSERT_THAT(buffer.text({ end.x - static_cast<int>(tail.size()), end.y }, end), testing::Eq(tail)) << step;
+        }
+
+        history.push_back(testFiles::textOf(buffer));
+    }
+
+    for (auto it = history.rbegin() + 1; it != history.rend(); ++it) {
+        buffer.undo();
+        ASSERT_THAT(testFiles::textOf(buffer), testing::Eq(*it));
+    }
+
+    while (buffer.redo()) {
+    }
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq(history.back()));
+}
+
+TEST(CursorSetTest, TypesAtTenThousandCursors)
+{
+    constexpr int Rows = 10'000;
+    std::string text;
+
+    for (int y = 0; y < Rows; ++y) {
+        text += "value = " + std::to_string(y) + ";\n";
+    }
+
+    auto buffer = testFiles::loaded(text);
+    CursorSet cursors;
+
+    ASSERT_THAT(commands::cursorsAtWord(buffer, cursors), testing::Eq(static_cast<std::size_t>(Rows)));
+
+    for (char c : std::string { "new_" }) {
+        commands::insertText(buffer, cursors, std::string_view { &c, 1 });
+    }
+
+    commands::insertNewline(buffer, cursors);
+    commands::deleteBackward(buffer, cursors);
+
+    ASSERT_THAT(buffer.size(), testing::Eq(Rows));
+    ASSERT_THAT(buffer.row(Rows - 1), testing::Eq("new_value = 9999;"));
+    ASSERT_THAT(cursors.size(), testing::Eq(static_cast<std::size_t>(Rows)));
+    ASSERT_THAT(cursors[Rows - 1].position(), IsAt(4, Rows - 1));
+}
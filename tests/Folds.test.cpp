@@ -0,0 +1,205 @@
+#include "Folds/Folds.hpp"
+#include "Cursor/Cursor.hpp"
+#include "Modal/Modal.hpp"
+#include "TestFiles/TestFiles.hpp"
+
+#include <gmock/gmock.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+    /// \brief Check @p folds against the rows they hide, worked out one row at a time
+    void expectIndexed(Folds const& folds, int rows)
+    {
+        std::vector<int> visible;
+
+        for (int y = 0; y < rows; ++y) {
+            if (not folds.hidden(y)) {
+                visible.push_back(y);
+            }
+        }
+
+        for (int y = 0, index = -1; y < rows; ++y) {
+            index += folds.hidden(y) ? 0 : 1;
+
+            ASSERT_THAT(folds.visible(y), testing::Eq(visible[static_cast<std::size_t>(index)])) << y;
+            ASSERT_THAT(folds.visibleIndex(y), testing::Eq(index)) << y;
+        }
+
+        for (std::size_t index = 0; index < visible.size(); ++index) {
+            ASSERT_THAT(folds.visibleRow(static_cast<int>(index)), testing::Eq(visible[index])) << index;
+        }
+    }
+
+    constexpr std::string_view Json =
+        "{\n"                   // 0
+        "    \"a\": [\n"        // 1
+        "        1,\n"          // 2
+        "        2\n"           // 3
+        "    ],\n"              // 4
+        "\n"                    // 5
+        "    \"b\": {\n"        // 6
+        "        \"c\": 3\n"    // 7
+        "    }\n"               // 8
+        "}\n";                  // 9
+}
+
+TEST(FoldsTest, MergesOverlappingFolds)
+{
+    Folds folds;
+
+    folds.fold(2, 4);
+    folds.fold(8, 9);
+    folds.fold(4, 6);
+
+    ASSERT_THAT(folds.size(), testing::Eq(2u));
+    ASSERT_THAT(folds.at(5)->first, testing::Eq(2));
+    ASSERT_THAT(folds.at(5)->last, testing::Eq(6));
+    ASSERT_FALSE(folds.hidden(2));
+    ASSERT_TRUE(folds.hidden(6));
+    ASSERT_FALSE(folds.at(7));
+
+    ASSERT_THAT(folds.step(2, 1), testing::Eq(7));
+    ASSERT_THAT(folds.step(9, -1), testing::Eq(7));
+    ASSERT_THAT(folds.step(7, -1), testing::Eq(2));
+
+    ASSERT_TRUE(folds.unfold(3));
+    ASSERT_FALSE(folds.unfold(3));
+    ASSERT_THAT(folds.size(), testing::Eq(1u));
+}
+
+TEST(FoldsTest, IndexesVisibleRowsUnderRandomFoldsAndEdits)
+{
+    std::mt19937 random { 5 };
+    Folds folds;
+    int rows = 500;
+
+    for (int step = 0; step < 3000; ++step) {
+        auto const y = static_cast<int>(random() % static_cast<unsigned>(rows));
+
+        switch (random() % 4) {
+            case 0: folds.fold(y, y + static_cast<int>(random() % 20)); break;
+            case 1: folds.unfold(y); break;
+            case 2: {
+                auto const removed = std::min(static_cast<int>(random() % 10), rows - y);
+                auto const inserted = static_cast<int>(random() % 10);
+
+                folds.update(y, removed, inserted);
+                rows += inserted - removed;
+                break;
+            }
+            case 3: folds.update(y, 1, 1); break;
+        }
+
+        rows = std::max(rows, 50);
+        expectIndexed(folds, rows + 20);
+
+        if (testing::Test::HasFatalFailure()) {
+            FAIL() << "after step " << step;
+        }
+    }
+}
+
+TEST(FoldsTest, FollowsRowsInsertedAndErasedInTheBuffer)
+{
+    auto buffer = testFiles::loaded(std::string(Json));
+    Folds folds;
+    buffer.onRowsChanged([&](int y, int removed, int inserted) { folds.update(y, removed, inserted); });
+
+    folds.fold(6, 8);
+    buffer.insert({ 0, 1 }, "x\ny\n");
+    ASSERT_THAT(folds.at(8)->first, testing::Eq(8));
+    ASSERT_THAT(folds.at(8)->last, testing::Eq(10));
+
+    // Typing in the fold's first row leaves it where it is
+    buffer.insert({ 0, 8 }, "z");
+    ASSERT_THAT(folds.at(8)->last, testing::Eq(10));
+
+    // Erasing every row the fold hides leaves nothing to fold
+    buffer.eraseRows(9, 2);
+    ASSERT_THAT(folds.size(), testing::Eq(0u));
+}
+
+TEST(FoldsTest, FoldsIndentedBlocks)
+{
+    auto const buffer = testFiles::loaded(std::string(Json));
+    Folds folds;
+
+    // A row that heads a block folds it; one inside a block folds the block it is in
+    ASSERT_TRUE(folds.foldIndented(buffer, 1));
+    ASSERT_THAT(folds.at(1)->last, testing::Eq(3));
+
+    ASSERT_TRUE(folds.foldIndented(buffer, 7));
+    ASSERT_THAT(folds.at(7)->first, testing::Eq(6));
+    ASSERT_THAT(folds.at(7)->last, testing::Eq(7));
+
+    // A blank row belongs to the block around it
+    folds.clear();
+    ASSERT_TRUE(folds.foldIndented(buffer, 5));
+    ASSERT_THAT(folds.at(5)->first, testing::Eq(0));
+    ASSERT_THAT(folds.at(5)->last, testing::Eq(8));
+
+    folds.clear();
+    folds.foldAllIndented(buffer);
+    ASSERT_THAT(folds.size(), testing::Eq(1u));
+    ASSERT_THAT(folds.visibleRow(1), testing::Eq(9));
+}
+
+TEST(FoldsTest, CursorMovesOverAFoldInOneStep)
+{
+    auto const buffer = testFiles::loaded(std::string(Json));
+    Folds folds;
+    Cursor cursor {};
+
+    folds.fold(1, 4);
+    cursor.yPos = 1;
+
+    cursor.moveCursor(Key::ArrowDown, buffer, folds);
+    ASSERT_THAT(cursor.yPos, testing::Eq(5));
+
+    cursor.moveCursor(Key::ArrowUp, buffer, folds);
+    ASSERT_THAT(cursor.yPos, testing::Eq(1));
+}
+
+TEST(FoldsTest, ModalFoldCommands)
+{
+    auto buffer = testFiles::loaded(std::string(Json));
+    Cursor cursor {};
+    Folds folds;
+    Modal modal;
+
+    modal.useFolds(folds);
+    buffer.onRowsChanged([&](int y, int removed, int inserted) { folds.update(y, removed, inserted); });
+
+    auto const type = [&](std::string_view keys) {
+        for (auto c : keys) {
+            modal.feed(static_cast<Key>(static_cast<unsigned char>(c)), buffer, cursor);
+        }
+    };
+
+    type("jzc");
+    ASSERT_THAT(folds.at(1)->last, testing::Eq(3));
+
+    // j and k step over the closed fold
+    type("j");
+    ASSERT_THAT(cursor.yPos, testing::Eq(4));
+    type("k");
+    ASSERT_THAT(cursor.yPos, testing::Eq(1));
+
+    type("zo");
+    ASSERT_THAT(folds.size(), testing::Eq(0u));
+
+    // zf takes a motion; a delete over a closed fold takes the whole fold
+    type("zfj");
+    ASSERT_THAT(folds.at(2)->first, testing::Eq(1));
+    type("dd");
+    ASSERT_THAT(buffer.size(), testing::Eq(8));
+    ASSERT_THAT(folds.size(), testing::Eq(0u));
+
+    type("zMzR");
+    ASSERT_THAT(folds.size(), testing::Eq(0u));
+}
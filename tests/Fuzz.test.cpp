@@ -0,0 +1,95 @@
+#include "Fuzz/Fuzz.hpp"
+#include "Keys/Keys.hpp"
+#include "Utils/Utils.hpp"
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    /// \brief How many random inputs each property is checked against; KILO_FUZZ_RUNS raises it, e.g. to check a
+    /// \brief rewrite of the buffer or the decoder for longer than a test run takes
+    int runs(int byDefault)
+    {
+        auto const* const value = std::getenv("KILO_FUZZ_RUNS");
+        return value ? std::max(std::atoi(value), 1) : byDefault;
+    }
+
+    /// \brief Random bytes, mostly drawn from @p likely so that they spell out what the check looks for more often
+    /// \brief than bytes drawn uniformly would
+    std::string randomBytes(std::mt19937& random, std::size_t maxSize, std::string_view likely = {})
+    {
+        std::string bytes(random() % (maxSize + 1), '\0');
+
+        for (auto& byte : bytes) {
+            byte = likely.empty() or random() % 4 == 0
+                ? static_cast<char>(random() % 256)
+                : likely[random() % likely.size()];
+        }
+
+        return bytes;
+    }
+
+    /// \brief Matches a check that found nothing wrong, and otherwise explains what it found
+    MATCHER(Holds, "holds")
+    {
+        if (arg) {
+            *result_listener << *arg;
+        }
+
+        return not arg.has_value();
+    }
+}
+
+TEST(FuzzTest, DecodesEscapeSequences)
+{
+    std::size_t pos = 0;
+
+    ASSERT_THAT(decodeKey("\x1b[5~x", pos), testing::Eq(static_cast<int>(Key::PageUp)));
+    ASSERT_THAT(decodeKey("\x1b[5~x", pos), testing::Eq('x'));
+
+    // Running out of input acts like the read timer expiring
+    pos = 0;
+    ASSERT_THAT(decodeKey("\x1b[20", pos), testing::Eq(static_cast<int>(Key::Escape)));
+    ASSERT_THAT(pos, testing::Eq(4u));
+
+    // However long a run of leading zeros, a sequence takes at most MaxSequence bytes
+    std::string const zeros = "\x1b[" + std::string(100, '0') + "5~";
+    pos = 0;
+    ASSERT_THAT(decodeKey(zeros, pos), testing::Eq(static_cast<int>(Key::Escape)));
+    ASSERT_THAT(pos, testing::Le(fuzz::MaxSequence));
+    ASSERT_THAT(fuzz::checkDecoder(zeros), Holds());
+}
+
+TEST(FuzzTest, DecoderPropertiesHoldForRandomInput)
+{
+    std::mt19937 random { 1 };
+
+    for (int run = runs(20'000); run > 0; --run) {
+        auto const input = randomBytes(random, 32, "\x1b\x1b\x1b[[O0123456789~~ABCDFHx");
+        ASSERT_THAT(fuzz::checkDecoder(input), Holds());
+    }
+}
+
+TEST(FuzzTest, KeysRoundTripThroughTheDecoder)
+{
+    std::mt19937 random { 2 };
+
+    for (int run = runs(20'000); run > 0; --run) {
+        ASSERT_THAT(fuzz::checkKeyRoundTrip(randomBytes(random, 64)), Holds());
+    }
+}
+
+TEST(FuzzTest, BufferAgreesWithANaiveModel)
+{
+    std::mt19937 random { 3 };
+
+    for (int run = runs(3'000); run > 0; --run) {
+        ASSERT_THAT(fuzz::checkBuffer(randomBytes(random, 400)), Holds());
+    }
+}
@@ -0,0 +1,19 @@
+#include "Fuzz/Fuzz.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size)
+{
+    std::string_view const input { reinterpret_cast<char const*>(data), size };
+
+    if (auto const failure = fuzz::checkBuffer(input)) {
+        std::fprintf(stderr, "%s\n", failure->c_str());
+        std::abort();
+    }
+
+    return 0;
+}
@@ -0,0 +1,25 @@
+#include "Fuzz/Fuzz.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const* data, std::size_t size)
+{
+    std::string_view const input { reinterpret_cast<char const*>(data), size };
+
+    auto failure = fuzz::checkDecoder(input);
+
+    if (not failure) {
+        failure = fuzz::checkKeyRoundTrip(input);
+    }
+
+    if (failure) {
+        std::fprintf(stderr, "%s\n", failure->c_str());
+        std::abort();
+    }
+
+    return 0;
+}
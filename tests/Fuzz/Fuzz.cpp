@@ -0,0 +1,684 @@
+#include "Fuzz/Fuzz.hpp"
+#include "Buffer/Buffer.hpp"
+#include "Cursor/Cursor.hpp"
+#include "Folds/Folds.hpp"
+#include "Keys/Keys.hpp"
+#include "Utils/Utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace
+{
+    std::string describe(Position at)
+    {
+        return fmt::format("{{{}, {}}}", at.x, at.y);
+    }
+
+    /// \brief The bytes a check is driven by, read as the numbers it needs; past the end, every byte read is 0
+    class Script
+    {
+    public:
+        explicit Script(std::string_view bytes) noexcept : m_bytes { bytes } {}
+
+        [[nodiscard]]
+        bool done() const noexcept { return m_pos >= m_bytes.size(); }
+
+        unsigned byte() noexcept
+        {
+            return m_pos < m_bytes.size() ? static_cast<unsigned char>(m_bytes[m_pos++]) : 0u;
+        }
+
+        /// \returns A number in [0, @p n), from two bytes if one can't reach every number
+        int below(int n) noexcept
+        {
+            if (n <= 1) {
+                return 0;
+            }
+
+            auto value = byte();
+
+            if (n > 256) {
+                value = value << 8 | byte();
+            }
+
+            return static_cast<int>(value % static_cast<unsigned>(n));
+        }
+
+        /// \returns A short run of text, '\n's included
+        std::string text()
+        {
+            constexpr std::string_view Alphabet { "ab \n" };
+            std::string result(static_cast<std::size_t>(below(8)), ' ');
+
+            for (auto& c : result) {
+                c = Alphabet[byte() % Alphabet.size()];
+            }
+
+            return result;
+        }
+
+    private:
+        std::string_view m_bytes;
+        std::size_t m_pos {0};
+    };
+
+    /// \brief What a Buffer should hold, kept as simply as possible: the text is one string in which every row, the
+    /// \brief last one included, ends with a '\n', and every edit is made to that string directly
+    /// \details The edits are specified the way the buffer documents them; in particular, row size() is the empty row
+    /// \details past the end of the text, and editing it appends a row.
+    class Model
+    {
+    public:
+        explicit Model(std::string text) : m_text { std::move(text) }
+        {
+            if (not m_text.empty() and m_text.back() != '\n') {
+                m_text += '\n';
+            }
+        }
+
+        [[nodiscard]]
+        int size() const noexcept { return static_cast<int>(std::count(m_text.begin(), m_text.end(), '\n')); }
+
+        [[nodiscard]]
+        std::string_view row(int y) const noexcept
+        {
+            if (y < 0 or y >= size()) {
+                return {};
+            }
+
+            auto const start = rowStart(y);
+            return std::string_view { m_text }.substr(start, m_text.find('\n', start) - start);
+        }
+
+        [[nodiscard]]
+        int rowLength(int y) const noexcept { return static_cast<int>(row(y).size()); }
+
+        [[nodiscard]]
+        Position clamp(Position at) const noexcept
+        {
+            at.y = std::clamp(at.y, 0, size());
+            at.x = std::clamp(at.x, 0, rowLength(at.y));
+
+            return at;
+        }
+
+        /// \returns The offset in the text of @p at, which must be within the buffer
+        [[nodiscard]]
+        std::size_t offset(Position at) const noexcept { return rowStart(at.y) + static_cast<std::size_t>(at.x); }
+
+        [[nodiscard]]
+        Position position(std::size_t offset) const noexcept
+        {
+            auto const head = std::string_view { m_text }.substr(0, offset);
+            auto const y = static_cast<int>(std::count(head.begin(), head.end(), '\n'));
+            auto const eol = head.rfind('\n');
+
+            return { static_cast<int>(eol == std::string_view::npos ? offset : offset - eol - 1), y };
+        }
+
+        Position insert(Position at, std::string_view text)
+        {
+            at = clamp(at);
+
+            if (not text.empty()) {
+                edit();
+                replace(offset(at), offset(at), text);
+            }
+
+            return position(offset(at) + text.size());
+        }
+
+        void erase(Position from, Position to)
+        {
+            std::tie(from, to) = ordered(from, to);
+
+            // The line terminator of the last row is left alone, as the row past the end has nothing to join
+            auto const begin = offset(from);
+            auto const end = std::min(offset(to), m_text.size() - 1);
+
+            if (from.y != size() and begin < end) {
+                edit();
+                m_text.erase(begin, end - begin);
+            }
+        }
+
+        void eraseRows(int y, int count)
+        {
+            y = std::clamp(y, 0, size());
+            count = std::clamp(count, 0, size() - y);
+
+            if (count > 0) {
+                edit();
+                m_text.erase(rowStart(y), rowStart(y + count) - rowStart(y));
+            }
+        }
+
+        /// \details The splices are made one at a time, from the last to the first, so that each of them is made at
+        /// \details the offsets the splices were given at. Each ends where its text ends, moved by the splices before it.
+        std::vector<Position> splice(std::vector<Buffer::Splice> splices)
+        {
+            std::vector<std::pair<std::size_t, std::size_t>> ranges;
+
+            for (auto& splice : splices) {
+                std::tie(splice.from, splice.to) = ordered(splice.from, splice.to);
+                ranges.emplace_back(offset(splice.from), offset(splice.to));
+            }
+
+            auto const changes = std::any_of(splices.begin(), splices.end(), [&](Buffer::Splice const& splice) {
+                return offset(splice.from) != offset(splice.to) or not splice.text.empty();
+            });
+
+            if (changes) {
+                edit();
+            }
+
+            for (auto i = splices.size(); i-- > 0;) {
+                replace(ranges[i].first, ranges[i].second, splices[i].text);
+            }
+
+            std::vector<Position> ends;
+            std::ptrdiff_t moved = 0;
+
+            for (std::size_t i = 0; i < splices.size(); ++i) {
+                auto const inserted = static_cast<std::ptrdiff_t>(splices[i].text.size());
+                auto const end = static_cast<std::ptrdiff_t>(ranges[i].first) + moved + inserted;
+
+                ends.push_back(position(static_cast<std::size_t>(end)));
+                moved += inserted - static_cast<std::ptrdiff_t>(ranges[i].second - ranges[i].first);
+            }
+
+            return ends;
+        }
+
+        void checkpoint() noexcept { ++m_entry; }
+
+        bool undo() { return revert(m_undo, m_redo); }
+
+        bool redo() { return revert(m_redo, m_undo); }
+
+    private:
+        /// \brief The text before an undo entry, or after it for a redo
+        struct Entry
+        {
+            std::uint64_t entry;
+            std::string text;
+        };
+
+        std::string m_text;
+        std::vector<Entry> m_undo;
+        std::vector<Entry> m_redo;
+        std::uint64_t m_entry {0};
+
+        [[nodiscard]]
+        std::size_t rowStart(int y) const noexcept
+        {
+            std::size_t start = 0;
+
+            for (int row = 0; row < y; ++row) {
+                start = m_text.find('\n', start) + 1;
+            }
+
+            return start;
+        }
+
+        [[nodiscard]]
+        std::pair<Position, Position> ordered(Position from, Position to) const noexcept
+        {
+            from = clamp(from);
+            to = clamp(to);
+
+            if (std::tie(to.y, to.x) < std::tie(from.y, from.x)) {
+                std::swap(from, to);
+            }
+
+            return { from, to };
+        }
+
+        /// \brief Replace the text in [@p from, @p to) with @p text
+        /// \details Erasing up to the row past the end joins the last row with it, so the row that is left still ends
+        /// \details with a '\n'; and inserting into the row past the end appends it as a row of its own.
+        void replace(std::size_t from, std::size_t to, std::string_view text)
+        {
+            bool const joinsPastEnd = from < to and to == m_text.size();
+            m_text.erase(from, to - from);
+
+            if (joinsPastEnd) {
+                m_text += '\n';
+            }
+
+            if (from == m_text.size() and not text.empty()) {
+                m_text += text;
+                m_text += '\n';
+            }
+            else {
+                m_text.insert(from, text);
+            }
+        }
+
+        /// \brief Record the text as it was before an edit, if the edit starts a new undo entry
+        void edit()
+        {
+            if (m_undo.empty() or m_undo.back().entry != m_entry) {
+                m_undo.push_back({ m_entry, m_text });
+            }
+
+            m_redo.clear();
+        }
+
+        bool revert(std::vector<Entry>& from, std::vector<Entry>& to)
+        {
+            if (from.empty()) {
+                return false;
+            }
+
+            to.push_back({ from.back().entry, std::move(m_text) });
+            m_text = std::move(from.back().text);
+            from.pop_back();
+
+            return true;
+        }
+    };
+
+    /// \brief Where a cursor moved by @p key should end up, with the rows @p folds hide stepped over one row at a time
+    Cursor moved(Cursor cursor, Key key, Model const& model, Folds const& folds)
+    {
+        auto const rows = model.size();
+
+        auto const visible = [&](int y) {
+            while (y > 0 and folds.hidden(y)) {
+                --y;
+            }
+
+            return y;
+        };
+
+        auto const up = [&](int y) {
+            y = std::max(visible(y) - 1, 0);
+            return visible(y);
+        };
+
+        auto const down = [&](int y) {
+            y = visible(y) + 1;
+
+            while (folds.hidden(y)) {
+                ++y;
+            }
+
+            return std::min(y, rows);
+        };
+
+        auto& [x, y] = cursor;
+
+        switch (key) {
+            case Key::ArrowLeft:
+                if (x > 0) {
+                    --x;
+                }
+                else if (y > 0) {
+                    y = up(y);
+                    x = model.rowLength(y);
+                }
+
+                break;
+
+            case Key::ArrowRight:
+                if (y < rows and x < model.rowLength(y)) {
+                    ++x;
+                }
+                else if (y < rows) {
+                    y = down(y);
+                    x = 0;
+                }
+
+                break;
+
+            case Key::ArrowUp:
+                y = y > 0 ? up(y) : y;
+                break;
+
+            case Key::ArrowDown:
+                y = y < rows ? down(y) : y;
+                break;
+
+            default:
+                break;
+        }
+
+        x = std::min(x, model.rowLength(y));
+        return cursor;
+    }
+
+    /// \returns Splices in order and not overlapping, some of them spanning rows and some of them empty
+    std::vector<Buffer::Splice> splices(Script& script, Model const& model)
+    {
+        std::vector<Buffer::Splice> result;
+        Position at { 0, script.below(model.size() + 1) };
+
+        for (int count = 1 + script.below(5); count > 0; --count) {
+            auto const down = script.below(3);
+            at.y += down;
+
+            if (at.y > model.size()) {
+                break;
+            }
+
+            auto const x = script.below(model.rowLength(at.y) + 1);
+            at.x = down == 0 ? std::max(at.x, x) : x;
+
+            auto to = at;
+
+            switch (script.below(3)) {
+                case 1:
+                    to.x = std::min(at.x + script.below(4), model.rowLength(at.y));
+                    break;
+
+                case 2:
+                    if (at.y < model.size()) {
+                        to = { script.below(model.rowLength(at.y + 1) + 1), at.y + 1 };
+                    }
+
+                    break;
+            }
+
+            result.push_back({ at, to, script.text() });
+            at = to;
+        }
+
+        return result;
+    }
+
+    /// \returns A position to edit at, which may lie outside the buffer on either side
+    Position somewhere(Script& script, Model const& model)
+    {
+        auto const y = script.below(model.size() + 3) - 1;
+        auto const x = script.below(model.rowLength(y) + 3) - 1;
+
+        return { x, y };
+    }
+
+    /// \brief The ways terminals send the keys decodeKey knows, as they are decoded
+    constexpr std::array<std::pair<std::string_view, Key>, 21> Encodings { {
+        { "\x1b[A", Key::ArrowUp }, { "\x1b[B", Key::ArrowDown }, { "\x1b[C", Key::ArrowRight },
+        { "\x1b[D", Key::ArrowLeft }, { "\x1b[H", Key::Home }, { "\x1bOH", Key::Home }, { "\x1b[1~", Key::Home },
+        { "\x1b[7~", Key::Home }, { "\x1b[F", Key::End }, { "\x1bOF", Key::End }, { "\x1b[4~", Key::End },
+        { "\x1b[8~", Key::End }, { "\x1b[3~", Key::Delete }, { "\x1b[5~", Key::PageUp }, { "\x1b[6~", Key::PageDown },
+        { "\x1b[200~", Key::Paste }, { "\x1b[05~", Key::PageUp }, { "\x1b[003~", Key::Delete },
+        { "\x1b[X", Key::Escape }, { "\x1b[1234", Key::Escape }, { "\x1bOA", Key::Escape },
+    } };
+}
+
+namespace fuzz
+{
+    std::optional<std::string> checkDecoder(std::string_view input)
+    {
+        for (std::size_t pos = 0; pos < input.size();) {
+            auto const start = pos;
+            auto const key = decodeKey(input, pos);
+            auto const used = pos - start;
+            auto const first = static_cast<unsigned char>(input[start]);
+            auto const at = " at offset " + std::to_string(start);
+
+            if (used == 0 or used > MaxSequence or pos > input.size()) {
+                return "a key took " + std::to_string(used) + " bytes" + at;
+            }
+
+            if (not isEscapeKey(first) and (key != first or used != 1)) {
+                return "byte " + std::to_string(first) + " decoded as key " + std::to_string(key) + at;
+            }
+
+            if (isEscapeKey(first) and (key < static_cast<int>(Key::ArrowLeft) or key > static_cast<int>(Key::Paste))) {
+                return "an escape sequence decoded as key " + std::to_string(key) + at;
+            }
+
+            // A key is decoded from its own bytes alone, whatever follows them
+            std::size_t alone = 0;
+
+            if (decodeKey(input.substr(start, used), alone) != key or alone != used) {
+                return "key " + std::to_string(key) + " decoded differently without the input after it" + at;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::string> checkKeyRoundTrip(std::string_view input)
+    {
+        Script script { input };
+        std::string encoded;
+        std::vector<int> keys;
+
+        while (not script.done()) {
+            if (script.byte() % 2 == 0) {
+                auto const byte = static_cast<unsigned char>(script.byte());
+
+                if (not isEscapeKey(byte)) {
+                    encoded += static_cast<char>(byte);
+                    keys.push_back(byte);
+                }
+            }
+            else {
+                auto const& [sequence, key] = Encodings[script.byte() % Encodings.size()];
+                encoded += sequence;
+                keys.push_back(static_cast<int>(key));
+            }
+        }
+
+        // A lone ESC is only taken as the escape key when nothing follows it before the read timer expires
+        if (script.byte() % 2) {
+            encoded += '\x1b';
+            keys.push_back(static_cast<int>(Key::Escape));
+        }
+
+        std::size_t pos = 0;
+
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (pos == encoded.size()) {
+                return "the input ran out after " + std::to_string(i) + " of " + std::to_string(keys.size()) + " keys";
+            }
+
+            if (auto const key = decodeKey(encoded, pos); key != keys[i]) {
+                return "key " + std::to_string(i) + " decoded as " + std::to_string(key) + " rather than "
+                    + std::to_string(keys[i]);
+            }
+        }
+
+        if (pos != encoded.size()) {
+            return std::to_string(encoded.size() - pos) + " bytes were left after every key was decoded";
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<std::string> checkBuffer(std::string_view input)
+    {
+        Script script { input };
+        std::string text;
+
+        for (int rows = script.below(6); rows > 0; --rows) {
+            text += script.text() + "\n";
+        }
+
+        // The last row may or may not end with a line terminator
+        text += script.text();
+
+        Buffer buffer;
+        std::istringstream in { text };
+        buffer.load(in);
+
+        Model model { text };
+        Folds folds;
+        Cursor cursor {};
+        std::vector<int> lengths;
+
+        for (int y = 0; y < buffer.size(); ++y) {
+            lengths.push_back(buffer.rowLength(y));
+        }
+
+        std::optional<std::string> failure;
+
+        buffer.onRowsChanged([&](int y, int removed, int inserted) {
+            if (y < 0 or removed < 0 or inserted < 0 or y + removed > static_cast<int>(lengths.size())) {
+                failure = "rows " + std::to_string(y) + " to " + std::to_string(y + removed) + " were reported as "
+                    "changed in a view of " + std::to_string(lengths.size()) + " rows";
+                return;
+            }
+
+            lengths.erase(lengths.begin() + y, lengths.begin() + y + removed);
+
+            for (int k = 0; k < inserted; ++k) {
+                lengths.insert(lengths.begin() + y + k, buffer.rowLength(y + k));
+            }
+
+            folds.update(y, removed, inserted);
+        });
+
+        constexpr std::array<std::string_view, 10> Steps {
+            "insert", "erase", "eraseRows", "splice", "checkpoint", "undo", "redo", "moveCursor", "fold", "unfold"
+        };
+
+        for (int step = 0; not script.done() and not failure; ++step) {
+            auto const kind = script.below(static_cast<int>(Steps.size()));
+            auto const at = " after step " + std::to_string(step) + ", " + std::string { Steps[static_cast<std::size_t>(kind)] };
+
+            switch (kind) {
+                case 0: {
+                    auto const where = somewhere(script, model);
+                    auto const inserted = script.text();
+                    auto const end = buffer.insert(where, inserted);
+
+                    if (auto const expected = model.insert(where, inserted); end.x != expected.x or end.y != expected.y) {
+                        return "an insert ended at " + describe(end) + " rather than " + describe(expected) + at;
+                    }
+
+                    break;
+                }
+
+                case 1: {
+                    auto const from = somewhere(script, model);
+                    auto const to = somewhere(script, model);
+                    buffer.erase(from, to);
+                    model.erase(from, to);
+                    break;
+                }
+
+                case 2: {
+                    auto const y = script.below(model.size() + 2) - 1;
+                    auto const count = script.below(4);
+                    buffer.eraseRows(y, count);
+                    model.eraseRows(y, count);
+                    break;
+                }
+
+                case 3: {
+                    auto const made = splices(script, model);
+                    auto const ends = buffer.splice(made);
+                    auto const expected = model.splice(made);
+
+                    for (std::size_t i = 0; i < std::min(ends.size(), expected.size()); ++i) {
+                        if (ends[i].x != expected[i].x or ends[i].y != expected[i].y) {
+                            return "splice " + std::to_string(i) + " of " + std::to_string(made.size()) + " ended at "
+                                + describe(ends[i]) + " rather than " + describe(expected[i]) + at;
+                        }
+                    }
+
+                    if (ends.size() != expected.size()) {
+                        return std::to_string(ends.size()) + " splice ends were reported for " +
+                            std::to_string(expected.size()) + " splices" + at;
+                    }
+
+                    break;
+                }
+
+                case 4:
+                    buffer.checkpoint();
+                    model.checkpoint();
+                    break;
+
+                case 5:
+                    if (buffer.undo().has_value() != model.undo()) {
+                        return "undo disagreed on whether there was anything to undo" + at;
+                    }
+
+                    break;
+
+                case 6:
+                    if (buffer.redo().has_value() != model.redo()) {
+                        return "redo disagreed on whether there was anything to redo" + at;
+                    }
+
+                    break;
+
+                case 7: {
+                    auto const key = static_cast<Key>(static_cast<int>(Key::ArrowLeft) + script.below(4));
+                    auto const expected = moved(cursor, key, model, folds);
+                    cursor.moveCursor(key, buffer, folds);
+
+                    if (auto const clamped = model.clamp(cursor.position());
+                            cursor.xPos != clamped.x or cursor.yPos != clamped.y) {
+                        return "the cursor moved out of the buffer, to " + describe(cursor.position()) + at;
+                    }
+
+                    if (cursor.xPos != expected.xPos or cursor.yPos != expected.yPos) {
+                        return "the cursor moved to " + describe(cursor.position()) + " rather than "
+                            + describe(expected.position()) + at;
+                    }
+
+                    break;
+                }
+
+                case 8: {
+                    auto const y = script.below(model.size() + 1);
+                    folds.fold(y, y + script.below(6));
+                    break;
+                }
+
+                case 9:
+                    folds.unfold(script.below(model.size() + 1));
+                    break;
+            }
+
+            if (failure) {
+                return *failure + at;
+            }
+
+            if (buffer.size() != model.size()) {
+                return "the buffer has " + std::to_string(buffer.size()) + " rows rather than "
+                    + std::to_string(model.size()) + at;
+            }
+
+            if (static_cast<int>(lengths.size()) != buffer.size()) {
+                return "a view kept by the rows reported as changed has " + std::to_string(lengths.size())
+                    + " rows rather than " + std::to_string(buffer.size()) + at;
+            }
+
+            for (int y = 0; y < buffer.size(); ++y) {
+                if (buffer.row(y) != model.row(y)) {
+                    return "row " + std::to_string(y) + " is \"" + std::string { buffer.row(y) } + "\" rather than \""
+                        + std::string { model.row(y) } + "\"" + at;
+                }
+
+                if (lengths[static_cast<std::size_t>(y)] != buffer.rowLength(y)) {
+                    return "a view kept by the rows reported as changed has the wrong length for row "
+                        + std::to_string(y) + at;
+                }
+            }
+
+            // The editor keeps the cursor within the buffer across edits, as every motion must
+            cursor.moveTo(model.clamp(cursor.position()));
+        }
+
+        return failure;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef FUZZ_HPP
+#define FUZZ_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/// \brief Properties of the input decoder and the buffer, checked against arbitrary bytes
+/// \details Each check takes any sequence of bytes whatsoever and reports the first property that doesn't hold, so the
+/// \details same checks are driven by random bytes in the tests and by libFuzzer in the fuzzers. Nothing is checked
+/// \details with gtest assertions, which a fuzzer can't report.
+namespace fuzz
+{
+    /// \brief Decode @p input as the terminal's input, checking every key decoded from it
+    /// \details Every key takes between 1 and MaxSequence bytes. A byte other than ESC is a key of its own, and a key
+    /// \details starting with ESC is either a special key or Escape itself.
+    /// \returns What went wrong, or nothing if every property holds
+    [[nodiscard]]
+    std::optional<std::string> checkDecoder(std::string_view input);
+
+    /// \brief Encode the keys @p input describes, in every form terminals send them, and check they decode as such
+    /// \returns What went wrong, or nothing if every key round-trips
+    [[nodiscard]]
+    std::optional<std::string> checkKeyRoundTrip(std::string_view input);
+
+    /// \brief Run @p input as a script of edits, undos, redos, folds and cursor motions against a Buffer, and against
+    /// \brief a naive model of it that holds the text as a single string
+    /// \details After every step, the buffer holds the same text as the model, the rows reported as changed account for
+    /// \details every row of the buffer, and the cursor is where the model puts it and within the buffer.
+    /// \returns What went wrong, or nothing if the buffer and the model agree throughout
+    [[nodiscard]]
+    std::optional<std::string> checkBuffer(std::string_view input);
+
+    /// \brief The most bytes a single key takes
+    constexpr std::size_t MaxSequence = 6;
+}
+
+#endif
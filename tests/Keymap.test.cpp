@@ -0,0 +1,111 @@
+#include "Keymap/Keymap.hpp"
+
+#include <gmock/gmock.h>
+
+#include <array>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr Key ctrl(char c) noexcept
+    {
+        return static_cast<Key>(ctrlKey(c));
+    }
+}
+
+// The default keymap is built at compile time
+static_assert(Keymap { DefaultKeymap }.lookup(Key::ArrowUp) == Command::MoveUp);
+static_assert(Keymap { DefaultKeymap }.lookup(static_cast<Key>('a')) == Command::InsertChar);
+static_assert(Keymap { DefaultKeymap }.lookup(Key::Paste) == Command::Paste);
+
+TEST(KeymapTest, LooksUpSingleKeys)
+{
+    Keymap keymap { DefaultKeymap };
+
+    ASSERT_THAT(keymap.lookup(ctrl('s')), testing::Eq(Command::Save));
+    ASSERT_THAT(keymap.lookup(Key::PageDown), testing::Eq(Command::PageDown));
+    ASSERT_THAT(keymap.lookup(ctrl('g')), testing::Eq(Command::None));
+}
+
+TEST(KeymapTest, WaitsForTheSecondKeyOfAChord)
+{
+    Keymap keymap { DefaultKeymap };
+
+    ASSERT_THAT(keymap.lookup(ctrl('x')), testing::Eq(Command::None));
+    ASSERT_THAT(keymap.pending(), testing::IsTrue());
+    ASSERT_THAT(keymap.lookup(ctrl('c')), testing::Eq(Command::Quit));
+    ASSERT_THAT(keymap.pending(), testing::IsFalse());
+
+    // An unbound second key abandons the chord
+    ASSERT_THAT(keymap.lookup(ctrl('x')), testing::Eq(Command::None));
+    ASSERT_THAT(keymap.lookup(static_cast<Key>('a')), testing::Eq(Command::None));
+    ASSERT_THAT(keymap.lookup(static_cast<Key>('a')), testing::Eq(Command::InsertChar));
+}
+
+TEST(KeymapTest, CancelsAChordWhoseSecondKeyWentElsewhere)
+{
+    Keymap keymap { DefaultKeymap };
+
+    ASSERT_THAT(keymap.lookup(ctrl('x')), testing::Eq(Command::None));
+    keymap.cancel();
+
+    ASSERT_THAT(keymap.pending(), testing::IsFalse());
+    ASSERT_THAT(keymap.lookup(ctrl('s')), testing::Eq(Command::Save));
+    ASSERT_THAT(keymap.lookup(static_cast<Key>('a')), testing::Eq(Command::InsertChar));
+}
+
+TEST(KeymapTest, RebindsKeysAtRuntime)
+{
+    Keymap keymap { DefaultKeymap };
+    std::istringstream bindings { "# vi-ish\nbind ctrl-k move-up\nunbind ctrl-q\nbind ctrl-w ctrl-w quit\n" };
+
+    keymap.load(bindings);
+
+    ASSERT_THAT(keymap.lookup(ctrl('k')), testing::Eq(Command::MoveUp));
+    ASSERT_THAT(keymap.lookup(ctrl('q')), testing::Eq(Command::None));
+    ASSERT_THAT(keymap.lookup(ctrl('w')), testing::Eq(Command::None));
+    ASSERT_THAT(keymap.lookup(ctrl('w')), testing::Eq(Command::Quit));
+}
+
+TEST(KeymapTest, RejectsBindingsThatClashWithAChord)
+{
+    Keymap keymap { DefaultKeymap };
+    std::array<Key, 1> const prefix { ctrl('x') };
+
+    ASSERT_THROW(keymap.bind(prefix, Command::Save), std::invalid_argument);
+
+    std::istringstream bindings { "bind ctrl-x frobnicate\n" };
+    ASSERT_THROW(keymap.load(bindings), std::invalid_argument);
+}
+
+TEST(KeymapTest, ReusesTheTablesOfUnboundChords)
+{
+    Keymap keymap;
+
+    // Far more prefixes than there is room for at once, each unbound before the next is bound
+    for (char c = 'a'; c <= 'z'; ++c) {
+        std::array<Key, 2> const chord { ctrl(c), ctrl('s') };
+        std::array<Key, 1> const prefix { ctrl(c) };
+
+        ASSERT_NO_THROW(keymap.bind(chord, Command::Save));
+        ASSERT_THAT(keymap.lookup(ctrl(c)), testing::Eq(Command::None));
+        ASSERT_THAT(keymap.lookup(ctrl('s')), testing::Eq(Command::Save));
+
+        keymap.bind(prefix, Command::None);
+    }
+
+    // A table taken up again starts out empty
+    std::array<Key, 2> const chord { ctrl('a'), ctrl('c') };
+    keymap.bind(chord, Command::Quit);
+    ASSERT_THAT(keymap.lookup(ctrl('a')), testing::Eq(Command::None));
+    ASSERT_THAT(keymap.lookup(ctrl('s')), testing::Eq(Command::None));
+
+    for (char c = 'b'; c < 'b' + static_cast<char>(Keymap::MaxChords) - 1; ++c) {
+        std::array<Key, 2> const another { ctrl(c), ctrl('s') };
+        keymap.bind(another, Command::Save);
+    }
+
+    std::array<Key, 2> const tooMany { ctrl('y'), ctrl('s') };
+    ASSERT_THROW(keymap.bind(tooMany, Command::Save), std::length_error);
+}
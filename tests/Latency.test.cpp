@@ -0,0 +1,81 @@
+#include "Latency/Latency.hpp"
+
+#include <gmock/gmock.h>
+
+TEST(HistogramTest, IsEmptyByDefault)
+{
+    Histogram histogram;
+
+    ASSERT_THAT(histogram.count(), testing::Eq(0u));
+    ASSERT_THAT(histogram.percentile(0.99), testing::Eq(0u));
+}
+
+TEST(HistogramTest, RecordsSmallValuesExactly)
+{
+    Histogram histogram;
+
+    for (std::uint64_t value = 1; value <= 10; ++value) {
+        histogram.record(value);
+    }
+
+    ASSERT_THAT(histogram.count(), testing::Eq(10u));
+    ASSERT_THAT(histogram.percentile(0.50), testing::Eq(5u));
+    ASSERT_THAT(histogram.max(), testing::Eq(10u));
+}
+
+TEST(HistogramTest, PercentilesOfLargeValuesAreWithinBucketPrecision)
+{
+    Histogram histogram;
+
+    for (std::uint64_t value = 1; value <= 100'000; ++value) {
+        histogram.record(value * 1'000);
+    }
+
+    ASSERT_THAT(histogram.percentile(0.50), testing::AllOf(testing::Ge(50'000'000u), testing::Le(53'125'000u)));
+    ASSERT_THAT(histogram.percentile(0.99), testing::AllOf(testing::Ge(99'000'000u), testing::Le(100'000'000u)));
+    ASSERT_THAT(histogram.max(), testing::Eq(100'000'000u));
+}
+
+TEST(LatencyTest, IgnoresStampsWhileDisabled)
+{
+    Latency latency;
+
+    latency.start();
+    latency.stamp(Stage::Read);
+    latency.stamp(Stage::Write);
+
+    ASSERT_THAT(latency.histogram(Stage::Read).count(), testing::Eq(0u));
+    ASSERT_THAT(latency.total().count(), testing::Eq(0u));
+}
+
+TEST(LatencyTest, RecordsEveryStageOfAFrame)
+{
+    Latency latency;
+    latency.enable(true);
+    latency.start();
+
+    for (auto stage : { Stage::Read, Stage::Decode, Stage::Dispatch, Stage::Layout, Stage::Render, Stage::Write }) {
+        latency.stamp(stage);
+    }
+
+    for (auto stage : { Stage::Read, Stage::Decode, Stage::Dispatch, Stage::Layout, Stage::Render, Stage::Write }) {
+        ASSERT_THAT(latency.histogram(stage).count(), testing::Eq(1u));
+    }
+
+    // The total is kept apart from the stages, and spans them all
+    ASSERT_THAT(latency.total().count(), testing::Eq(1u));
+    ASSERT_THAT(latency.total().max(), testing::Ge(latency.histogram(Stage::Read).max()));
+}
+
+TEST(LatencyTest, IgnoresRepaintsWithoutAKeypress)
+{
+    Latency latency;
+    latency.enable(true);
+
+    latency.stamp(Stage::Layout);
+    latency.stamp(Stage::Render);
+    latency.stamp(Stage::Write);
+
+    ASSERT_THAT(latency.histogram(Stage::Write).count(), testing::Eq(0u));
+    ASSERT_THAT(latency.total().count(), testing::Eq(0u));
+}
@@ -0,0 +1,173 @@
+#include "Modal/Modal.hpp"
+#include "TestFiles/TestFiles.hpp"
+
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    class ModalTest : public testing::Test
+    {
+    protected:
+        Buffer buffer;
+        Cursor cursor {};
+        Modal modal;
+
+        void load(std::string const& text)
+        {
+            std::istringstream in { text };
+            buffer.load(in);
+        }
+
+        void type(std::string_view keys)
+        {
+            // The editor starts a new undo entry before every key pressed outside of insert mode
+            for (auto c : keys) {
+                if (modal.mode() != Mode::Insert) {
+                    buffer.checkpoint();
+                }
+
+                modal.feed(static_cast<Key>(static_cast<unsigned char>(c)), buffer, cursor);
+            }
+        }
+
+        std::string text() const
+        {
+            std::ostringstream out;
+            buffer.save(out);
+            return out.str();
+        }
+    };
+}
+
+TEST_F(ModalTest, StartsInNormalMode)
+{
+    ASSERT_THAT(modal.mode(), testing::Eq(Mode::Normal));
+}
+
+TEST_F(ModalTest, CountedMotionsJumpStraightToTheirTarget)
+{
+    std::string lines;
+
+    for (int i = 0; i < 10'000; ++i) {
+        lines += "line\n";
+    }
+
+    load(lines);
+    type("5000j");
+
+    ASSERT_THAT(cursor.yPos, testing::Eq(5000));
+    ASSERT_THAT(modal.pending(), testing::IsEmpty());
+
+    type("99999999j");
+    ASSERT_THAT(cursor.yPos, testing::Eq(9999));
+
+    type("gg");
+    ASSERT_THAT(cursor.yPos, testing::Eq(0));
+
+    type("42G");
+    ASSERT_THAT(cursor.yPos, testing::Eq(41));
+}
+
+TEST_F(ModalTest, OperatorsComposeWithCountedMotions)
+{
+    load("one two three four five\n");
+    type("d3w");
+
+    ASSERT_THAT(text(), testing::Eq("four five\n"));
+
+    load("a b c d e f g\n");
+    cursor = {};
+    type("2d2w");
+
+    ASSERT_THAT(text(), testing::Eq("e f g\n"));
+}
+
+TEST_F(ModalTest, WordDeletionStopsAtTheEndOfTheRow)
+{
+    load("one two\nthree\n");
+    type("wdw");
+
+    ASSERT_THAT(text(), testing::Eq("one \nthree\n"));
+}
+
+TEST_F(ModalTest, DeletesAndPastesWholeRows)
+{
+    load("1\n2\n3\n4\n");
+    type("j2dd");
+
+    ASSERT_THAT(text(), testing::Eq("1\n4\n"));
+
+    type("p");
+    ASSERT_THAT(text(), testing::Eq("1\n4\n2\n3\n"));
+}
+
+TEST_F(ModalTest, ChangeEntersInsertMode)
+{
+    load("hello world\n");
+    type("cw");
+
+    ASSERT_THAT(text(), testing::Eq(" world\n"));
+    ASSERT_THAT(modal.mode(), testing::Eq(Mode::Insert));
+
+    modal.enterNormal(buffer, cursor);
+    ASSERT_THAT(modal.mode(), testing::Eq(Mode::Normal));
+}
+
+TEST_F(ModalTest, VisualModeOperatesOnTheSelection)
+{
+    load("abcdef\n");
+    type("lvlly");
+
+    ASSERT_THAT(modal.mode(), testing::Eq(Mode::Normal));
+
+    type("$p");
+    ASSERT_THAT(text(), testing::Eq("abcdefbcd\n"));
+
+    type("0vlx");
+    ASSERT_THAT(text(), testing::Eq("cdefbcd\n"));
+}
+
+TEST_F(ModalTest, UndoesOneCommandAtATime)
+{
+    load("1\n2\n3\n");
+    type("dddd");
+
+    ASSERT_THAT(text(), testing::Eq("3\n"));
+
+    type("u");
+    ASSERT_THAT(text(), testing::Eq("2\n3\n"));
+
+    type("u");
+    ASSERT_THAT(text(), testing::Eq("1\n2\n3\n"));
+}
+
+TEST_F(ModalTest, GoingToTheLastRowReadsTheWholeFile)
+{
+    std::string text;
+
+    for (int i = 0; i < 100'000; ++i) {
+        text += "row " + std::to_string(i) + '\n';
+    }
+
+    buffer.open(testFiles::write("modal-lazy.txt", text), 24);
+    ASSERT_THAT(buffer.loading(), testing::IsTrue());
+
+    type("G");
+
+    ASSERT_THAT(buffer.loading(), testing::IsFalse());
+    ASSERT_THAT(cursor.yPos, testing::Eq(99'999));
+}
+
+TEST_F(ModalTest, CountedPasteStopsAtALimit)
+{
+    load("abc\n");
+    type("yw");
+
+    ASSERT_NO_THROW(type("99999999p"));
+    ASSERT_THAT(buffer.rowLength(0), testing::AllOf(testing::Gt(3), testing::Lt(100'000'000)));
+    ASSERT_THAT(modal.mode(), testing::Eq(Mode::Normal));
+}
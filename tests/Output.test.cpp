@@ -0,0 +1,75 @@
+#include "Output/Output.hpp"
+
+#include <gmock/gmock.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <string>
+
+namespace
+{
+    /// \brief A non-blocking pipe standing in for a terminal that is slower than the editor
+    class OutputTest : public testing::Test
+    {
+    protected:
+        std::array<int, 2> pipe {-1, -1};
+
+        void SetUp() override
+        {
+            ASSERT_THAT(::pipe(pipe.data()), testing::Eq(0));
+            ::fcntl(pipe[0], F_SETFL, O_NONBLOCK);
+            ::fcntl(pipe[1], F_SETFL, O_NONBLOCK);
+        }
+
+        void TearDown() override
+        {
+            ::close(pipe[0]);
+            ::close(pipe[1]);
+        }
+
+        /// \brief Read everything written to the pipe, flushing @p output whenever there is room for more
+        std::string drain(Output& output)
+        {
+            std::string text;
+            std::array<char, 4096> chunk;
+
+            while (true) {
+                output.flush();
+                auto const rv = ::read(pipe[0], chunk.data(), chunk.size());
+
+                if (rv <= 0) {
+                    return text;
+                }
+
+                text.append(chunk.data(), static_cast<std::size_t>(rv));
+            }
+        }
+    };
+}
+
+TEST_F(OutputTest, WritesFramesStraightThroughWhenTheTerminalKeepsUp)
+{
+    Output output { pipe[1] };
+    output.submit("frame");
+
+    ASSERT_THAT(output.pending(), testing::IsFalse());
+    ASSERT_THAT(drain(output), testing::Eq("frame"));
+}
+
+TEST_F(OutputTest, FinishesTheFrameGoingOutAndSkipsToTheNewest)
+{
+    Output output { pipe[1] };
+    std::string const large(1 << 20, 'a');
+
+    output.submit(large);
+    ASSERT_THAT(output.pending(), testing::IsTrue());
+
+    output.submit("b");
+    output.submit("c");
+
+    ASSERT_THAT(output.dropped(), testing::Eq(1u));
+    ASSERT_THAT(drain(output), testing::Eq(large + "c"));
+    ASSERT_THAT(output.pending(), testing::IsFalse());
+}
@@ -0,0 +1,188 @@
+#include "Buffer/Buffer.hpp"
+#include "Compressed/Compressed.hpp"
+#include "LineIndex/LineIndex.hpp"
+#include "Session/Session.hpp"
+#include "TestFiles/TestFiles.hpp"
+
+#include <gmock/gmock.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+namespace
+{
+    Session sessionOf(std::filesystem::path const& path, int row)
+    {
+        Buffer buffer;
+        buffer.open(path);
+
+        return Session { FileStamp::of(path), { 0, row }, { row, 0 }, Session::indexOf(buffer), buffer.seekIndex() };
+    }
+}
+
+TEST(LineIndexTest, LocatesEveryRow)
+{
+    auto const text = testFiles::makeText(5000);
+    std::istringstream in { text };
+
+    LineIndex index;
+    index.extend(in);
+
+    ASSERT_THAT(index.rows(), testing::Eq(5000));
+    ASSERT_THAT(index.bytes(), testing::Eq(text.size()));
+
+    std::uint64_t start = 0;
+
+    for (int row = 0; row < index.rows(); ++row) {
+        ASSERT_THAT(index.start(row), testing::Eq(start));
+        start = text.find('\n', start) + 1;
+    }
+
+    ASSERT_THAT(index.start(index.rows()), testing::Eq(text.size()));
+}
+
+TEST(LineIndexTest, SkipsAnUnfinishedLastRow)
+{
+    std::istringstream in { "one\ntwo\nthree" };
+
+    LineIndex index;
+    index.extend(in);
+
+    ASSERT_THAT(index.rows(), testing::Eq(2));
+    ASSERT_THAT(index.bytes(), testing::Eq(8u));
+}
+
+TEST(SessionTest, RestoresPositionAndIndex)
+{
+    auto const path = testFiles::write("session-same.txt", testFiles::makeText(3000));
+    auto const sidecar = testFiles::path("session-same.idx");
+
+    auto const saved = sessionOf(path, 2500);
+    saved.save(sidecar);
+
+    auto const restored = Session::restore(path, sidecar);
+
+    ASSERT_THAT(restored.has_value(), testing::IsTrue());
+    ASSERT_THAT(restored->cursor.y, testing::Eq(2500));
+    ASSERT_THAT(restored->offset.x, testing::Eq(2500));
+    ASSERT_THAT(restored->index.rows(), testing::Eq(3000));
+    ASSERT_THAT(restored->index.start(2500), testing::Eq(saved.index.start(2500)));
+
+    std::filesystem::remove(sidecar);
+    std::filesystem::remove(path);
+}
+
+TEST(SessionTest, IndexesOnlyTheTailOfAGrownFile)
+{
+    auto const text = testFiles::makeText(3000);
+    auto const path = testFiles::write("session-grown.txt", text);
+    auto const sidecar = testFiles::path("session-grown.idx");
+
+    sessionOf(path, 10).save(sidecar);
+    std::ofstream { path, std::ios::binary | std::ios::app } << "appended\nanother\n";
+
+    auto const restored = Session::restore(path, sidecar);
+
+    ASSERT_THAT(restored.has_value(), testing::IsTrue());
+    ASSERT_THAT(restored->stamp, testing::Eq(FileStamp::of(path)));
+    ASSERT_THAT(restored->index.rows(), testing::Eq(3002));
+    ASSERT_THAT(restored->index.start(3001), testing::Eq(text.size() + 9));
+
+    std::filesystem::remove(sidecar);
+    std::filesystem::remove(path);
+}
+
+TEST(SessionTest, DropsTheIndexOfARewrittenFile)
+{
+    auto const path = testFiles::write("session-rewritten.txt", testFiles::makeText(3000));
+    auto const sidecar = testFiles::path("session-rewritten.idx");
+
+    sessionOf(path, 100).save(sidecar);
+    testFiles::write("session-rewritten.txt", "short\n");
+
+    auto const restored = Session::restore(path, sidecar);
+
+    ASSERT_THAT(restored.has_value(), testing::IsTrue());
+    ASSERT_THAT(restored->index.rows(), testing::Eq(0));
+    ASSERT_THAT(restored->cursor.y, testing::Eq(100));
+
+    std::filesystem::remove(sidecar);
+    std::filesystem::remove(path);
+}
+
+TEST(SessionTest, RejectsACorruptSidecar)
+{
+    auto const path = testFiles::write("session-corrupt.txt", testFiles::makeText(10));
+    auto const sidecar = testFiles::write("session-corrupt.idx", "KILOIDX2 but nothing after it");
+
+    ASSERT_THAT(Session::restore(path, sidecar).has_value(), testing::IsFalse());
+
+    std::filesystem::remove(sidecar);
+    std::filesystem::remove(path);
+}
+
+TEST(SessionTest, OpensAFileAtARowInTheMiddle)
+{
+    auto const text = testFiles::makeText(5000) + "no newline";
+    auto const path = testFiles::write("session-middle.txt", text);
+    auto const session = sessionOf(path, 4000);
+
+    Buffer buffer;
+    buffer.open(path, session.index, 4000, 24);
+
+    ASSERT_THAT(buffer.loading(), testing::IsTrue());
+    ASSERT_THAT(buffer.size(), testing::Eq(5000));
+    ASSERT_THAT(buffer.row(4000), testing::StartsWith("row 4000 "));
+    ASSERT_THAT(buffer.row(3999), testing::IsEmpty());
+
+    buffer.loadAll();
+
+    // The last row isn't in the index, since it has no '\n'; it is appended once read
+    ASSERT_THAT(buffer.size(), testing::Eq(5001));
+    ASSERT_THAT(buffer.row(3999), testing::StartsWith("row 3999 "));
+    ASSERT_THAT(buffer.row(5000), testing::Eq("no newline"));
+
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq(text));
+
+    std::filesystem::remove(path);
+}
+
+TEST(SessionTest, OpensACompressedFileInTheMiddleWithoutDecompressingTheStart)
+{
+    auto const text = testFiles::makeText(60'000);
+    auto const path = testFiles::path("session-compressed.zst");
+    auto const sidecar = testFiles::path("session-compressed.idx");
+
+    {
+        auto const out = compressed::openForWriting(path, Compression::Zstd);
+        *out << text << std::flush;
+    }
+
+    sessionOf(path, 55'000).save(sidecar);
+    auto const restored = Session::restore(path, sidecar);
+
+    ASSERT_THAT(restored.has_value(), testing::IsTrue());
+    ASSERT_THAT(restored->seekIndex, testing::NotNull());
+    ASSERT_THAT(restored->seekIndex->complete, testing::IsTrue());
+    ASSERT_THAT(restored->seekIndex->points.size(), testing::Gt(2u));
+    ASSERT_THAT(restored->seekIndex->points.back().out, testing::Eq(text.size()));
+
+    // Text in the middle of the file that fails its frame's checksum shows that the start of the session doesn't read it
+    {
+        std::fstream file { path, std::ios::binary | std::ios::in | std::ios::out };
+        file.seekp(static_cast<std::streamoff>(std::filesystem::file_size(path) / 2));
+        file.write("garbage!garbage!", 16);
+    }
+
+    Buffer buffer;
+    buffer.open(path, restored->index, 55'000, 24, restored->seekIndex);
+
+    ASSERT_THAT(buffer.row(55'000), testing::StartsWith("row 55000 "));
+    ASSERT_THROW(buffer.loadAll(), std::system_error);
+
+    std::filesystem::remove(sidecar);
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,87 @@
+#include "TestFiles/TestFiles.hpp"
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+namespace
+{
+    /// \brief The directory of this run, removed when the run ends
+    class Directory
+    {
+    public:
+        Directory()
+        {
+            auto pattern = (std::filesystem::temp_directory_path() / "kilo-tests-XXXXXX").string();
+
+            if (::mkdtemp(pattern.data()) == nullptr) {
+                throw std::system_error(errno, std::generic_category(), "Could not create a directory for test files");
+            }
+
+            m_path = pattern;
+        }
+
+        ~Directory()
+        {
+            std::error_code err;
+            std::filesystem::remove_all(m_path, err);
+        }
+
+        Directory(Directory const&) = delete;
+        Directory& operator=(Directory const&) = delete;
+
+        [[nodiscard]]
+        std::filesystem::path const& path() const noexcept { return m_path; }
+
+    private:
+        std::filesystem::path m_path;
+    };
+}
+
+std::filesystem::path testFiles::path(std::string const& name)
+{
+    static Directory const directory;
+    return directory.path() / name;
+}
+
+std::filesystem::path testFiles::write(std::string const& name, std::string_view text)
+{
+    auto const file = path(name);
+    std::ofstream out { file, std::ios::binary | std::ios::trunc };
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+
+    return file;
+}
+
+std::string testFiles::makeText(int rows)
+{
+    std::mt19937 random { 42 };
+    std::string text;
+
+    for (int i = 0; i < rows; ++i) {
+        text += "row " + std::to_string(i) + ' ' + std::to_string(random()) + ' ' + std::string(random() % 300, 'x') + '\n';
+    }
+
+    return text;
+}
+
+Buffer testFiles::loaded(std::string const& text)
+{
+    std::istringstream in { text };
+    Buffer buffer;
+    buffer.load(in);
+
+    return buffer;
+}
+
+std::string testFiles::textOf(Buffer const& buffer)
+{
+    std::ostringstream out;
+    buffer.save(out);
+
+    return out.str();
+}
@@ -0,0 +1,38 @@
+#ifndef TEST_FILES_HPP
+#define TEST_FILES_HPP
+
+#include "Buffer/Buffer.hpp"
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+/// \brief The files the tests write, and the texts and buffers they start from
+/// \details Files are kept in a directory of their own for each run of the tests. The directory is created under the
+/// \details system's temporary directory with a unique name the first time it is needed, and removed with everything
+/// \details in it when the run ends, so runs in parallel never share a file.
+namespace testFiles
+{
+    /// \returns The path of the file named @p name in the directory of this run; the file isn't created
+    [[nodiscard]]
+    std::filesystem::path path(std::string const& name);
+
+    /// \brief Write @p text to the file named @p name in the directory of this run, replacing what it held
+    /// \returns The path of the file
+    std::filesystem::path write(std::string const& name, std::string_view text);
+
+    /// \returns A text of @p rows rows of varying lengths, some long enough to need multi-byte varints in a line index,
+    /// \returns and random enough not to compress to next to nothing; the same text every time
+    [[nodiscard]]
+    std::string makeText(int rows);
+
+    /// \returns A buffer holding @p text
+    [[nodiscard]]
+    Buffer loaded(std::string const& text);
+
+    /// \returns The text of @p buffer, as it would be saved
+    [[nodiscard]]
+    std::string textOf(Buffer const& buffer);
+}
+
+#endif
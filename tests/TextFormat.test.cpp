@@ -0,0 +1,221 @@
+#include "Buffer/Buffer.hpp"
+#include "Session/Session.hpp"
+#include "TextFormat/TextFormat.hpp"
+#include "TestFiles/TestFiles.hpp"
+
+#include <gmock/gmock.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <system_error>
+
+namespace
+{
+    /// \brief Decode @p text character by character, as a reference for Utf8Validator
+    bool referenceValid(std::string_view text)
+    {
+        for (std::size_t i = 0; i < text.size(); ) {
+            auto const lead = static_cast<unsigned char>(text[i]);
+            int const length = lead < 0x80 ? 1 : lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 0;
+
+            if (length == 0 or lead > 0xf4 or i + static_cast<std::size_t>(length) > text.size()) {
+                return false;
+            }
+
+            char32_t c = length == 1 ? lead : lead & (0x7f >> length);
+
+            for (int k = 1; k < length; ++k) {
+                auto const next = static_cast<unsigned char>(text[i + static_cast<std::size_t>(k)]);
+
+                if ((next & 0xc0) != 0x80) {
+                    return false;
+                }
+
+                c = (c << 6) | (next & 0x3f);
+            }
+
+            constexpr char32_t smallest[] { 0, 0, 0x80, 0x800, 0x10000 };
+
+            if (c < smallest[length] or c > 0x10ffff or (c >= 0xd800 and c <= 0xdfff)) {
+                return false;
+            }
+
+            i += static_cast<std::size_t>(length);
+        }
+
+        return true;
+    }
+
+    /// \brief Feed @p text to a validator in pieces of random sizes
+    bool validate(std::string_view text, std::mt19937& random)
+    {
+        Utf8Validator validator;
+
+        while (not text.empty()) {
+            auto const piece = std::min<std::size_t>(text.size(), random() % 40);
+            validator.feed(text.substr(0, piece));
+            text.remove_prefix(piece);
+        }
+
+        return validator.finish();
+    }
+
+    std::string fileText(std::filesystem::path const& path)
+    {
+        std::ifstream in { path, std::ios::binary };
+        return { std::istreambuf_iterator<char> { in }, std::istreambuf_iterator<char> {} };
+    }
+}
+
+TEST(TextFormatTest, DetectsLineEndingsFromTheFirstLine)
+{
+    ASSERT_THAT(TextFormat::detect("one\ntwo\r\n", true).lineEnding, testing::Eq(LineEnding::LF));
+    ASSERT_THAT(TextFormat::detect("one\r\ntwo\n", true).lineEnding, testing::Eq(LineEnding::CRLF));
+    ASSERT_THAT(TextFormat::detect("one\rtwo\r", true).lineEnding, testing::Eq(LineEnding::CR));
+    ASSERT_THAT(TextFormat::detect("no line ending", true).lineEnding, testing::Eq(LineEnding::LF));
+
+    // A '\r' at the very end of what has been read so far is most likely followed by a '\n'
+    ASSERT_THAT(TextFormat::detect("one\r", false).lineEnding, testing::Eq(LineEnding::CRLF));
+    ASSERT_THAT(TextFormat::detect("one\r", true).lineEnding, testing::Eq(LineEnding::CR));
+
+    ASSERT_THAT(TextFormat::detect("\xef\xbb\xbfone\n", true).bom, testing::IsTrue());
+    ASSERT_THAT(TextFormat::detect("one\n", true).bom, testing::IsFalse());
+}
+
+TEST(TextFormatTest, ValidatesUtf8)
+{
+    std::mt19937 random { 7 };
+
+    for (std::string_view valid : { "", "ascii only", "caf\xc3\xa9", "\xe2\x82\xac 20", "\xf0\x9f\x98\x80!", "\xf4\x8f\xbf\xbf" }) {
+        ASSERT_THAT(validate(valid, random), testing::IsTrue()) << valid;
+    }
+
+    for (std::string_view invalid : {
+        "\x80",                 // a stray continuation byte
+        "caf\xe9",              // Latin-1
+        "\xc0\xaf",             // overlong
+        "\xe0\x80\xaf",         // overlong
+        "\xed\xa0\x80",         // a surrogate
+        "\xf4\x90\x80\x80",     // past U+10FFFF
+        "\xe2\x82",             // cut short
+        "\xf8\x88\x80\x80\x80", // a five-byte sequence
+    }) {
+        ASSERT_THAT(validate(invalid, random), testing::IsFalse()) << invalid;
+    }
+}
+
+TEST(TextFormatTest, ValidatorAgreesWithADecoder)
+{
+    std::mt19937 random { 11 };
+
+    // Texts built from pieces of valid characters, with the odd byte flipped, hit the edge cases far more often than
+    // uniformly random bytes would
+    constexpr std::string_view pieces[] { "a", "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\x9f\xbf", "\xef\xbf\xbf" };
+
+    for (int round = 0; round < 5000; ++round) {
+        std::string text;
+
+        for (auto count = random() % 60; count > 0; --count) {
+            text += pieces[random() % std::size(pieces)];
+        }
+
+        if (not text.empty() and random() % 2 == 0) {
+            text[random() % text.size()] = static_cast<char>(random());
+        }
+
+        ASSERT_THAT(validate(text, random), testing::Eq(referenceValid(text))) << round;
+    }
+}
+
+TEST(TextFormatTest, ConvertsLatin1BothWays)
+{
+    std::string latin1;
+
+    for (int c = 0; c < 256; ++c) {
+        latin1 += static_cast<char>(c);
+    }
+
+    auto const utf8 = utf8::fromLatin1(latin1);
+    std::string back;
+
+    ASSERT_THAT(utf8::length(utf8), testing::Eq(256u));
+    ASSERT_THAT(utf8::toLatin1(utf8, back), testing::IsTrue());
+    ASSERT_THAT(back, testing::Eq(latin1));
+    ASSERT_THAT(utf8::toLatin1("\xe2\x82\xac", back), testing::IsFalse());
+}
+
+TEST(TextFormatTest, BufferKeepsCrlfAndTheBom)
+{
+    auto const text = std::string { TextFormat::Bom } + "one\r\ntwo\r\n\r\nlast";
+    auto const path = testFiles::write("format-crlf.txt", text);
+
+    Buffer buffer;
+    buffer.open(path);
+
+    ASSERT_THAT(buffer.format().lineEnding, testing::Eq(LineEnding::CRLF));
+    ASSERT_THAT(buffer.format().bom, testing::IsTrue());
+    ASSERT_THAT(buffer.size(), testing::Eq(4));
+    ASSERT_THAT(buffer.row(0), testing::Eq("one"));
+    ASSERT_THAT(buffer.row(2), testing::IsEmpty());
+    ASSERT_THAT(buffer.row(3), testing::Eq("last"));
+
+    buffer.insert({ 0, 1 }, "new\n");
+    buffer.save(path);
+
+    ASSERT_THAT(fileText(path), testing::Eq(std::string { TextFormat::Bom } + "one\r\nnew\r\ntwo\r\n\r\nlast"));
+
+    std::filesystem::remove(path);
+}
+
+TEST(TextFormatTest, BufferSplitsOnLoneCarriageReturns)
+{
+    auto const buffer = testFiles::loaded("one\rtwo\r");
+
+    ASSERT_THAT(buffer.format().lineEnding, testing::Eq(LineEnding::CR));
+    ASSERT_THAT(buffer.size(), testing::Eq(2));
+    ASSERT_THAT(buffer.row(1), testing::Eq("two"));
+    ASSERT_THAT(testFiles::textOf(buffer), testing::Eq("one\rtwo\r"));
+}
+
+TEST(TextFormatTest, BufferFallsBackToLatin1LateInTheFile)
+{
+    // The first invalid byte only comes after several chunks have been read as UTF-8, valid characters included
+    std::string text;
+
+    for (int i = 0; i < 60'000; ++i) {
+        text += "row " + std::to_string(i) + " caf\xc3\xa9\n";
+    }
+
+    text += "na\xefve\n";
+
+    auto const path = testFiles::write("format-latin1.txt", text);
+
+    Buffer buffer;
+    buffer.open(path, 24);
+
+    ASSERT_THAT(buffer.format().encoding, testing::Eq(Encoding::Utf8));
+    ASSERT_THAT(buffer.row(0), testing::Eq("row 0 caf\xc3\xa9"));
+
+    buffer.loadAll();
+
+    ASSERT_THAT(buffer.format().encoding, testing::Eq(Encoding::Latin1));
+    ASSERT_THAT(buffer.row(0), testing::Eq("row 0 caf\xc3\x83\xc2\xa9"));
+    ASSERT_THAT(buffer.row(60'000), testing::Eq("na\xc3\xafve"));
+
+    // Every byte of the file is kept, and each row still takes up as many bytes in it as it did
+    buffer.save(path);
+    ASSERT_THAT(fileText(path), testing::Eq(text));
+
+    auto const index = Session::indexOf(buffer);
+    ASSERT_THAT(index.bytes(), testing::Eq(text.size()));
+
+    buffer.insert({ 0, 0 }, "\xe2\x82\xac");
+    ASSERT_THROW(buffer.save(path), std::system_error);
+    ASSERT_THAT(fileText(path), testing::Eq(text));
+    ASSERT_THAT(std::filesystem::exists(testFiles::path("format-latin1.txt.kilo-save")), testing::IsFalse());
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,63 @@
+#include "Utils/Utils.hpp"
+#include "Keys/Keys.hpp"
+
+#include <gmock/gmock.h>
+
+#include <unistd.h>
+
+#include <string>
+#include <string_view>
+
+namespace
+{
+    /// \brief Stands in for the terminal: the input given is all stdin holds, and reading past it times out
+    class FakeInput
+    {
+    public:
+        explicit FakeInput(std::string_view input)
+        {
+            int fds[2];
+
+            if (::pipe(fds) != 0) {
+                return;
+            }
+
+            // The input is small enough to fit in the pipe without blocking
+            [[maybe_unused]] auto const written = ::write(fds[1], input.data(), input.size());
+            ::close(fds[1]);
+
+            ::dup2(fds[0], STDIN_FILENO);
+            ::close(fds[0]);
+        }
+
+        ~FakeInput()
+        {
+            ::dup2(m_stdin, STDIN_FILENO);
+            ::close(m_stdin);
+        }
+
+        FakeInput(FakeInput const&) = delete;
+        FakeInput& operator=(FakeInput const&) = delete;
+
+    private:
+        int m_stdin { ::dup(STDIN_FILENO) };
+    };
+}
+
+TEST(UtilsTest, DecodesEscapeSequences)
+{
+    FakeInput const input { "\x1b[5~\x1b[200~x" };
+
+    ASSERT_THAT(readKey(), testing::Eq(static_cast<int>(Key::PageUp)));
+    ASSERT_THAT(readKey(), testing::Eq(static_cast<int>(Key::Paste)));
+    ASSERT_THAT(readKey(), testing::Eq('x'));
+}
+
+TEST(UtilsTest, LeadingZerosDoNotKeepASequenceGoing)
+{
+    FakeInput const input { "\x1b[" + std::string(100, '0') + "5~" };
+
+    // The sequence ends after its fourth digit, and what follows is read as keys of its own
+    ASSERT_THAT(readKey(), testing::Eq(static_cast<int>(Key::Escape)));
+    ASSERT_THAT(readKey(), testing::Eq('0'));
+}
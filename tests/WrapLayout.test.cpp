@@ -0,0 +1,150 @@
+#include "WrapLayout/WrapLayout.hpp"
+#include "Buffer/Buffer.hpp"
+#include "Session/Session.hpp"
+#include "TestFiles/TestFiles.hpp"
+
+#include <gmock/gmock.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    constexpr int Width = 10;
+
+    /// \brief A buffer with a layout that follows its changes
+    struct Wrapped
+    {
+        Buffer buffer;
+        WrapLayout layout;
+
+        explicit Wrapped(std::string const& text)
+        {
+            std::istringstream in { text };
+            buffer.load(in);
+            layout.rebuild(buffer, Width);
+            buffer.onRowsChanged([this](int y, int removed, int inserted) { layout.update(buffer, y, removed, inserted); });
+        }
+    };
+
+    /// \brief Check @p layout against one laid out from scratch, screen row by screen row
+    void expectLaidOut(WrapLayout const& layout, Buffer const& buffer)
+    {
+        int screenRow = 0;
+
+        for (int y = 0; y < buffer.size(); ++y) {
+            auto const height = std::max(1, (buffer.rowLength(y) + layout.width() - 1) / layout.width());
+
+            ASSERT_THAT(layout.height(y), testing::Eq(height)) << y;
+            ASSERT_THAT(layout.screenRow(y), testing::Eq(screenRow)) << y;
+
+            for (int part = 0; part < height; ++part) {
+                auto const at = layout.locate(screenRow + part);
+
+                ASSERT_THAT(at.y, testing::Eq(y)) << screenRow + part;
+                ASSERT_THAT(at.x, testing::Eq(part * layout.width())) << screenRow + part;
+            }
+
+            screenRow += height;
+        }
+
+        ASSERT_THAT(layout.screenRows(), testing::Eq(screenRow));
+        ASSERT_THAT(layout.locate(screenRow).y, testing::Eq(buffer.size()));
+    }
+}
+
+TEST(WrapLayoutTest, WrapsRowsWiderThanTheScreen)
+{
+    Wrapped wrapped { "short\n0123456789\n0123456789ab\n\n" + std::string(35, 'x') + "\n" };
+    auto const& layout = wrapped.layout;
+
+    ASSERT_THAT(layout.screenRows(), testing::Eq(1 + 1 + 2 + 1 + 4));
+    ASSERT_THAT(layout.screenRow(4), testing::Eq(5));
+    ASSERT_THAT(layout.locate(3).y, testing::Eq(2));
+    ASSERT_THAT(layout.locate(3).x, testing::Eq(10));
+    ASSERT_THAT(layout.locate(8).x, testing::Eq(30));
+
+    ASSERT_THAT(layout.next({ 10, 2 }).y, testing::Eq(3));
+    ASSERT_THAT(layout.next({ 0, 4 }).x, testing::Eq(10));
+
+    // The end of a row that exactly fills its screen rows stays on the last of them
+    ASSERT_THAT(layout.place({ 10, 1 }).x, testing::Eq(10));
+    ASSERT_THAT(layout.place({ 10, 1 }).y, testing::Eq(1));
+    ASSERT_THAT(layout.place({ 11, 2 }).x, testing::Eq(1));
+    ASSERT_THAT(layout.place({ 11, 2 }).y, testing::Eq(3));
+}
+
+TEST(WrapLayoutTest, FollowsEditsUndoAndRedo)
+{
+    std::mt19937 random { 3 };
+    std::string text;
+
+    for (int y = 0; y < 200; ++y) {
+        text += std::string(random() % 35, 'a') + "\n";
+    }
+
+    Wrapped wrapped { text };
+    auto& buffer = wrapped.buffer;
+
+    auto const anywhere = [&] {
+        auto const y = static_cast<int>(random() % static_cast<unsigned>(buffer.size() + 1));
+        return Position { static_cast<int>(random() % static_cast<unsigned>(buffer.rowLength(y) + 1)), y };
+    };
+
+    for (int step = 0; step < 2000; ++step) {
+        buffer.checkpoint();
+
+        switch (random() % 7) {
+            case 0: buffer.insert(anywhere(), std::string(random() % 25, 'b')); break;
+            case 1: buffer.insert(anywhere(), "c\n" + std::string(random() % 25, 'd') + "\n"); break;
+            case 2: buffer.erase(anywhere(), anywhere()); break;
+            case 3: buffer.eraseRows(anywhere().y, static_cast<int>(random() % 30)); break;
+            case 4: buffer.undo(); break;
+            case 5: buffer.redo(); break;
+            case 6: wrapped.layout.setWidth(1 + static_cast<int>(random() % 20)); break;
+        }
+
+        expectLaidOut(wrapped.layout, buffer);
+
+        if (testing::Test::HasFatalFailure()) {
+            FAIL() << "after step " << step;
+        }
+    }
+}
+
+TEST(WrapLayoutTest, FollowsAFileAsItLoads)
+{
+    auto const path = testFiles::path("wrap-layout.txt");
+
+    {
+        std::ofstream out { path };
+
+        for (int y = 0; y < 50'000; ++y) {
+            out << std::string(static_cast<std::size_t>(y % 37), 'x') << '\n';
+        }
+    }
+
+    Buffer buffer;
+    WrapLayout layout;
+    buffer.onRowsChanged([&](int y, int removed, int inserted) { layout.update(buffer, y, removed, inserted); });
+
+    buffer.open(path, 10);
+    layout.setWidth(Width);
+    expectLaidOut(layout, buffer);
+
+    buffer.loadAll();
+    expectLaidOut(layout, buffer);
+
+    // Resumed from a session, the rows are all there, empty, from the start, and are filled in as they are read
+    auto const index = Session::indexOf(buffer);
+    buffer.open(path, index, 40'000, 10);
+    expectLaidOut(layout, buffer);
+
+    buffer.loadAll();
+    expectLaidOut(layout, buffer);
+
+    std::filesystem::remove(path);
+}